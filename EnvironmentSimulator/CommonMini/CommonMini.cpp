@@ -93,6 +93,8 @@ void Logger::Log(char const* file, char const* func, int line, char const* forma
 	static char complete_entry[2048];
 	static char message[1024];
 
+	mutex_.Lock();
+
 	va_list args;
 	va_start(args, format);
 	vsnprintf(message, 1024, format, args);
@@ -111,6 +113,8 @@ void Logger::Log(char const* file, char const* func, int line, char const* forma
 
 	file_.flush();
 	va_end(args);
+
+	mutex_.Unlock();
 }
 
 Logger& Logger::Inst()
@@ -107,4 +107,5 @@ private:
 	FuncPtr callback_;
 
 	std::ofstream file_;
+	SE_Mutex mutex_;  // Log may be called from several threads
 };
@@ -119,7 +119,7 @@ static void viewer_thread(void *args)
 	int firstScenarioVehicle = scenarioEngine->GetExtControl() == true ? 1 : 0;
 
 	// Create viewer
-	scenarioViewer = new viewer::Viewer(roadmanager::Position::GetOpenDrive(), scenarioEngine->getSceneGraphFilename().c_str(), *parser, true);
+	scenarioViewer = new viewer::Viewer(scenarioEngine->getRoadManager(), scenarioEngine->getSceneGraphFilename().c_str(), *parser, true);
 
 	// Create Ego vehicle, 
 	if (scenarioEngine->GetExtControl())
@@ -203,8 +203,6 @@ int main(int argc, char** argv)
 
 	ScenarioGateway *scenarioGateway;
 	roadmanager::OpenDrive *odrManager;
-	roadmanager::Position *lane_pos = new roadmanager::Position();
-	roadmanager::Position *track_pos = new roadmanager::Position();
 
 	double simTime = 0;
 
@@ -316,10 +314,10 @@ int main(int argc, char** argv)
 				UpdateEgo(deltaSimTime, scenarioViewer);
 
 				// Report updated Ego state to scenario gateway
-				scenarioGateway->reportObject(ObjectState(EGO_ID, std::string("Ego"), 0, 1, simTime,
+				scenarioGateway->reportObject(EGO_ID, std::string("Ego"), 0, 1, simTime,
 					egoCar->vehicle->posX_, egoCar->vehicle->posY_, egoCar->vehicle->posZ_,
 					egoCar->vehicle->heading_, egoCar->vehicle->pitch_, 0,
-					egoCar->vehicle->speed_));
+					egoCar->vehicle->speed_);
 			}
 
 			scenarioEngine->step(deltaSimTime);
@@ -340,8 +338,6 @@ int main(int argc, char** argv)
 
 	delete(scenarioEngine);
 	delete(egoCar);
-	delete track_pos;
-	delete lane_pos;
 
 	return 0;
 }
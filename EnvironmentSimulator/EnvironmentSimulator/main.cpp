@@ -18,6 +18,11 @@
   *
   * The Viewer is driven in a separate thread to enable camera movement even if simulation is paused.
   *
+  * With --headless no viewer is created and the scenario is stepped with a fixed time step, not paced
+  * by the system clock, until the given end time. Results are then independent of machine load.
+  * With --adaptive_step the fixed step is only used when something is going on in the scenario. Else 
+  * it jumps, by steps up to the given size, towards the earliest time any condition could trig.
+  *
   * A simpler solution is to move the Viewer handling to the main loop, i.e:
   *   Creation of Viewer and Vehicles visual models should be done after scenario engine initialization
   *   Vehicle position update and Viewer->frame() call part of the main loop.
@@ -38,8 +43,10 @@ using namespace scenarioengine;
 
 static const double maxStepSize = 0.1;
 static const double minStepSize = 0.01;
+static const double defaultFixedStepSize = 0.05;  // Used in headless mode unless specified
 static const bool freerun = true;
 static bool viewer_running = false;
+static bool quit_request = false;
 
 
 static ScenarioEngine *scenarioEngine;
@@ -52,7 +59,7 @@ void viewer_thread(void *args)
 	osg::ArgumentParser *parser = (osg::ArgumentParser*)args;
 
 	// Create viewer
-	viewer::Viewer *viewer = new viewer::Viewer(roadmanager::Position::GetOpenDrive(), scenarioEngine->getSceneGraphFilename().c_str(), *parser);
+	viewer::Viewer *viewer = new viewer::Viewer(scenarioEngine->getRoadManager(), scenarioEngine->getSceneGraphFilename().c_str(), *parser);
 
 	//  Create cars for visualization
 	for (size_t i = 0; i < scenarioEngine->entities.object_.size(); i++)
@@ -60,7 +67,7 @@ void viewer_thread(void *args)
 		viewer->AddCar(scenarioEngine->entities.object_[i]->model_filepath_);
 	}
 
-	while (!viewer->osgViewer_->done())
+	while (!viewer->osgViewer_->done() && !quit_request)
 	{
 
 		mutex.Lock();
@@ -97,9 +104,10 @@ int main(int argc, char *argv[])
 	double deltaSimTime;
 
 	// Simulation constants
-	double endTime = 100;
+	double endTime = -1;  // Negative means run until viewer is closed
 	double simulationTime = 0;
-	double timeStep = 1;
+	double fixedTimeStep = -1;  // Negative means step size by system clock
+	double maxTimeStep = -1;  // Max adaptive step size, negative means no adaptive stepping
 
 	// use an ArgumentParser object to manage the program arguments.
 	osg::ArgumentParser arguments(&argc, argv);
@@ -109,6 +117,11 @@ int main(int argc, char *argv[])
 	arguments.getApplicationUsage()->setCommandLineUsage(arguments.getApplicationName() + " [options]\n");
 	arguments.getApplicationUsage()->addCommandLineOption("--osc <filename>", "OpenSCENARIO filename");
 	arguments.getApplicationUsage()->addCommandLineOption("--ext_control <mode>", "Ego control (\"osc\", \"off\", \"on\")");
+	arguments.getApplicationUsage()->addCommandLineOption("--record <filename>", "Record position data into a file for later replay");
+	arguments.getApplicationUsage()->addCommandLineOption("--headless", "Run without viewer, as fast as possible. Requires --end_time");
+	arguments.getApplicationUsage()->addCommandLineOption("--fixed_timestep <seconds>", "Fixed step size instead of system clock (headless default 0.05)");
+	arguments.getApplicationUsage()->addCommandLineOption("--end_time <seconds>", "Quit when simulation time reaches given value");
+	arguments.getApplicationUsage()->addCommandLineOption("--adaptive_step <seconds>", "Headless: Skip ahead by steps up to given size while nothing happens");
 
 	if (arguments.argc() < 2)
 	{
@@ -135,6 +148,29 @@ int main(int argc, char *argv[])
 	std::string record_filename;
 	arguments.read("--record", record_filename);
 
+	bool headless = arguments.read("--headless");
+	arguments.read("--fixed_timestep", fixedTimeStep);
+	arguments.read("--end_time", endTime);
+	arguments.read("--adaptive_step", maxTimeStep);
+
+	if (headless)
+	{
+		if (endTime < 0)
+		{
+			printf("Headless mode requires --end_time\n");
+			return -1;
+		}
+		if (fixedTimeStep < SMALL_NUMBER)
+		{
+			fixedTimeStep = defaultFixedStepSize;
+		}
+	}
+	else if (maxTimeStep > 0)
+	{
+		printf("Adaptive step size requires --headless\n");
+		return -1;
+	}
+
 	// Use logger callback
 	Logger::Inst().SetCallback(log_callback);
 
@@ -163,6 +199,46 @@ int main(int argc, char *argv[])
 	// Report all vehicles initially - to communicate initial position for external vehicles as well
 	scenarioEngine->step(0.0, true);
 
+	if (headless)
+	{
+		__int64 startTimeStamp = SE_getSystemTime();
+		double simTime = 0;
+		int nSteps = 0;
+
+		if (maxTimeStep > fixedTimeStep)
+		{
+			LOG("Running headless, adaptive step %.3f - %.3f s until %.2f s", fixedTimeStep, maxTimeStep, endTime);
+		}
+		else
+		{
+			LOG("Running headless, fixed step %.3f s until %.2f s", fixedTimeStep, endTime);
+		}
+
+		while (simTime < endTime - SMALL_NUMBER)
+		{
+			deltaSimTime = fixedTimeStep;
+
+			if (maxTimeStep > fixedTimeStep)
+			{
+				deltaSimTime = scenarioEngine->GetAdaptiveStepSize(fixedTimeStep, maxTimeStep);
+				if (deltaSimTime > endTime - simTime)
+				{
+					deltaSimTime = endTime - simTime;
+				}
+			}
+
+			scenarioEngine->step(deltaSimTime);
+			simTime += deltaSimTime;
+			nSteps++;
+		}
+
+		LOG("Simulated %.2f s in %d steps, %.3f s (system time)", simTime, nSteps, 1E-3 * (SE_getSystemTime() - startTimeStamp));
+
+		delete scenarioEngine;
+
+		return 0;
+	}
+
 	// Launch viewer in a separate thread
 	thread.Start(viewer_thread, &arguments);
 	
@@ -172,27 +248,41 @@ int main(int argc, char *argv[])
 	__int64 now, lastTimeStamp = 0;
 	double simTime = 0;
 
-	while (viewer_running)
+	while (viewer_running && (endTime < 0 || simTime < endTime - SMALL_NUMBER))
 	{
 		// Get milliseconds since Jan 1 1970
 		now = SE_getSystemTime();
-		deltaSimTime = (now - lastTimeStamp) / 1000.0;  // step size in seconds
-		lastTimeStamp = now;
-		double adjust = 0;
 
-		if (deltaSimTime > maxStepSize) // limit step size
+		if (fixedTimeStep > 0)
 		{
-			adjust = -(deltaSimTime - maxStepSize);
+			// Fixed step, but still paced to real time for viewing
+			if (lastTimeStamp > 0 && now - lastTimeStamp < fixedTimeStep * 1000)
+			{
+				SE_sleep((unsigned int)(fixedTimeStep * 1000 - (now - lastTimeStamp)));
+			}
+			lastTimeStamp = SE_getSystemTime();
+			deltaSimTime = fixedTimeStep;
 		}
-		else if (deltaSimTime < minStepSize)  // avoid CPU rush, sleep for a while
+		else
 		{
-			adjust = minStepSize - deltaSimTime;
-			SE_sleep(adjust * 1000);
-			lastTimeStamp += adjust * 1000;
+			deltaSimTime = (now - lastTimeStamp) / 1000.0;  // step size in seconds
+			lastTimeStamp = now;
+			double adjust = 0;
+
+			if (deltaSimTime > maxStepSize) // limit step size
+			{
+				adjust = -(deltaSimTime - maxStepSize);
+			}
+			else if (deltaSimTime < minStepSize)  // avoid CPU rush, sleep for a while
+			{
+				adjust = minStepSize - deltaSimTime;
+				SE_sleep(adjust * 1000);
+				lastTimeStamp += adjust * 1000;
+			}
+
+			deltaSimTime += adjust;
 		}
 
-		deltaSimTime += adjust;
-
 		// Time operations
 		simTime = simTime + deltaSimTime;
 
@@ -204,6 +294,9 @@ int main(int argc, char *argv[])
 		mutex.Unlock();
 	}
 
+	// Close the viewer, if still running, before releasing the scenario
+	quit_request = true;
+	thread.Wait();
 
 	delete scenarioEngine;
 
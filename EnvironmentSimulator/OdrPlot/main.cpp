@@ -47,9 +47,9 @@ int main(int argc, char *argv[])
 	std::ofstream file;
 	file.open("track.csv");
 
-	Position* pos = new Position();
+	RoadCursor cursor;
 	double step_length_target = 1;
-	OpenDrive *od = Position::GetOpenDrive();
+	OpenDrive *od = Position::GetDefaultOpenDrive();
 
 	for (int r = 0; r < od->GetNumOfRoads(); r++)
 	{
@@ -76,10 +76,13 @@ int main(int argc, char *argv[])
 #endif
 
 				file << "lane, " << road->GetId() << ", " << i << ", " << lane->GetId() << std::endl;
+				cursor.Set(road, s_start);
 				for (int k = 0; k < steps + 1; k++)
 				{
-					pos->SetLanePos(road->GetId(), lane->GetId(), MIN(s_end, s_start + k * step_length), 0, i);
-					file << pos->GetX() << ", " << pos->GetY() << ", " << pos->GetZ() << ", " << pos->GetH() << std::endl;
+					double x, y, h;
+					cursor.MoveTo(MIN(s_end, s_start + k * step_length));
+					cursor.GetLanePos(lane->GetId(), 0, &x, &y, &h);
+					file << x << ", " << y << ", " << cursor.GetZ() << ", " << h << std::endl;
 				}
 #ifndef REF_ONLY
 			}
@@ -90,7 +93,5 @@ int main(int argc, char *argv[])
 	file.close();
 //	od->Print();
 
-	delete pos;
-
 	return 0;
 }
\ No newline at end of file
@@ -198,7 +198,7 @@ int main(int argc, char** argv)
 			printf("Failed to load ODR %s\n", odrFilename.c_str());
 			return -1;
 		}
-		roadmanager::OpenDrive *odrManager = roadmanager::Position::GetOpenDrive();
+		roadmanager::OpenDrive *odrManager = roadmanager::Position::GetDefaultOpenDrive();
 
 		viewer::Viewer *viewer = new viewer::Viewer(
 			odrManager, 
@@ -31,7 +31,7 @@ Replay::Replay(std::string filename) : time_(0.0), index_(0)
 
 	while (!file_.eof())
 	{
-		ObjectStateStruct data;
+		ObjectStateStructDat data;
 
 		file_.read((char*)&data, sizeof(data));
 
@@ -49,8 +49,6 @@ Replay::~Replay()
 
 void Replay::Step(double dt)
 {
-	ObjectStateStruct data;
-
 	time_ += dt;
 
 	// Find entry according to time 
@@ -65,7 +63,7 @@ void Replay::Step(double dt)
 	}
 }
 
-ObjectStateStruct* Replay::GetState(int id)
+ObjectStateStructDat* Replay::GetState(int id)
 {
 	// Read all vehicles at current timestamp
 	if (index_ + id > data_.size() - 1 || data_[index_ + id].id != id)
@@ -36,10 +36,10 @@ namespace scenarioengine
 		Replay(std::string filename);
 		~Replay();
 		void Step(double dt);
-		ObjectStateStruct * GetState(int id);
+		ObjectStateStructDat * GetState(int id);
 
 		ReplayHeader header_;
-		std::vector<ObjectStateStruct> data_;
+		std::vector<ObjectStateStructDat> data_;
 		std::ifstream file_;
 		double time_;
 		unsigned int index_;
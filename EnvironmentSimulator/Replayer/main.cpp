@@ -38,7 +38,7 @@ typedef struct
 {
 	int id;
 	viewer::CarModel *carModel;
-	roadmanager::Position pos;
+	ObjectPositionStructDat pos;
 } ScenarioCar;
 
 static std::vector<ScenarioCar> scenarioCar;
@@ -108,7 +108,7 @@ int main(int argc, char** argv)
 	{
 		std::string odr_path = res_path;
 		roadmanager::Position::LoadOpenDrive(odr_path.append("/xodr/").append(player->header_.odr_filename).c_str());
-		odrManager = roadmanager::Position::GetOpenDrive();
+		odrManager = roadmanager::Position::GetDefaultOpenDrive();
 
 		std::string model_path = res_path;
 		viewer::Viewer *viewer = new viewer::Viewer(
@@ -141,7 +141,7 @@ int main(int argc, char** argv)
 
 			// Fetch states of scenario objects
 			int index = 0;
-			ObjectStateStruct *state = player->GetState(index);
+			ObjectStateStructDat *state = player->GetState(index);
 			while (state != 0)
 			{
 				ScenarioCar *sc = getScenarioCarById(state->id);
@@ -172,8 +172,8 @@ int main(int argc, char** argv)
 			for (size_t i=0; i<scenarioCar.size(); i++)
 			{
 				ScenarioCar *c = &scenarioCar[i];
-				c->carModel->SetPosition(c->pos.GetX(), c->pos.GetY(), c->pos.GetZ());
-				c->carModel->SetRotation(c->pos.GetH(), c->pos.GetR(), c->pos.GetP());
+				c->carModel->SetPosition(c->pos.x, c->pos.y, c->pos.z);
+				c->carModel->SetRotation(c->pos.h, c->pos.r, c->pos.p);
 			}
 
 			// Update graphics
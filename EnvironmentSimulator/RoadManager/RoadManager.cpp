@@ -49,6 +49,21 @@
 #include <random>
 #include <time.h>
 #include <limits>
+#include <algorithm>
+#include <queue>
+#include <thread>
+#include <new>
+#include <string>
+
+#ifdef _WIN32
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
 
 #define _USE_MATH_DEFINES
 #include <math.h>
@@ -58,7 +73,6 @@
 #include "pugixml.hpp"
 #include "CommonMini.hpp"
 
-static std::mt19937 mt_rand;
 
 using namespace std;
 using namespace roadmanager;
@@ -69,6 +83,99 @@ using namespace roadmanager;
 #define MIN(x, y) (y < x ? y : x)
 #define CLAMP(x, a, b) (MIN(MAX(x, a), b))
 #define MAX_TRACK_DIST 10
+#define JUNCTION_STRAIGHT_MAX_ANGLE (M_PI / 6)  // max heading change through a junction considered straight
+#define SPATIAL_INDEX_SAMPLE_DIST 1.0  // max distance between samples of curved geometries
+#define SPATIAL_INDEX_MARGIN 0.01  // safety margin of geometry bounding boxes
+#define SPIRAL_TABLE_MAX_ERROR 1e-6  // max position error (m) of spiral lookup table, 0 = always exact evaluation
+#define SPIRAL_TABLE_MAX_SIZE 10000  // max number of table points per spiral, longer tables are skipped
+#define CLOSEST_POINT_MAX_ITERATIONS 20  // max number of iterations refining closest point on curved geometries
+#define CURVATURE_BOUND_INTERVALS 16  // parameter intervals of a ParamPoly3 bounded separately
+#define CURVATURE_BOUND_MAX_SPLITS 8  // max number of times an interval is halved to prove it free from cusps
+
+/**
+Find the piecewise element (e.g. geometry, lane section or width record) containing a given s value
+@param s_start Start s values of the elements, in increasing order
+@param s The s value to look up
+@param hint_idx Index of a likely element, e.g. from last lookup. Ignored if < 0.
+@return Index of last element starting at or before s. First element if s is before start. -1 if no elements.
+*/
+static int GetIdxByS(ArenaVector<double> &s_start, double s, int hint_idx)
+{
+	int n = (int)s_start.size();
+
+	if (n == 0)
+	{
+		return -1;
+	}
+
+	if (hint_idx >= 0 && hint_idx < n)
+	{
+		// Stay on hinted element as long as s is within it, including its end point
+		if ((hint_idx == 0 || s >= s_start[hint_idx]) && (hint_idx == n - 1 || s <= s_start[hint_idx + 1]))
+		{
+			return hint_idx;
+		}
+
+		// Check next element as well, typical for a position moving along the road
+		if (hint_idx + 1 < n && s >= s_start[hint_idx + 1] && (hint_idx + 1 == n - 1 || s < s_start[hint_idx + 2]))
+		{
+			return hint_idx + 1;
+		}
+	}
+
+	int idx = (int)(std::upper_bound(s_start.begin(), s_start.end(), s) - s_start.begin()) - 1;
+
+	return MAX(idx, 0);
+}
+
+static double PointDistance(double x0, double y0, double x1, double y1)
+{
+	// https://en.wikipedia.org/wiki/Distance
+
+	return sqrt((x1 - x0)*(x1 - x0) + (y1 - y0) * (y1 - y0));
+}
+
+/**
+Find the point of a geometry closest to a given point, by Newton iterations on the condition that the 
+tangent is perpendicular to the vector to the point. Starts from projection on the chord of the geometry.
+Each step is bounded to the geometry, and falls back to plain projection on the tangent when close to the
+center of curvature, where the Newton step is not reliable.
+*/
+template<class T> static double RefineClosestDS(T *geom, double x, double y, double tolerance)
+{
+	double length = geom->GetLength();
+	double x0, y0, h0, x1, y1, h1;
+
+	geom->EvaluateDS(0, &x0, &y0, &h0);
+	geom->EvaluateDS(length, &x1, &y1, &h1);
+
+	double chord_sqr = (x1 - x0) * (x1 - x0) + (y1 - y0) * (y1 - y0);
+	if (chord_sqr < SMALL_NUMBER)
+	{
+		return 0;
+	}
+	double ds = CLAMP(((x - x0) * (x1 - x0) + (y - y0) * (y1 - y0)) / chord_sqr, 0.0, 1.0) * length;
+
+	for (int i = 0; i < CLOSEST_POINT_MAX_ITERATIONS; i++)
+	{
+		double xc, yc, hc;
+		geom->EvaluateDS(ds, &xc, &yc, &hc);
+
+		// Tangential and normal component of vector from curve to point
+		double dt = (x - xc) * cos(hc) + (y - yc) * sin(hc);
+		double dn = -(x - xc) * sin(hc) + (y - yc) * cos(hc);
+		double derivative = 1 - geom->EvaluateCurvatureDS(ds) * dn;
+		double ds_new = CLAMP(ds + dt / (derivative > 0.1 ? derivative : 1.0), 0.0, length);
+
+		if (fabs(ds_new - ds) < tolerance)
+		{
+			return ds_new;
+		}
+		ds = ds_new;
+	}
+
+	return ds;
+}
 
 
 double Polynomial::Evaluate(double s)
@@ -92,6 +199,41 @@ double Polynomial::EvaluatePrimPrim(double s)
 	return (2 * c_ + 6 * p*d_);
 }
 
+double Polynomial::EvaluateAbsMax(double s0, double s1)
+{
+	// Extreme values are found at interval end points or where derivative is zero
+	double max_value = MAX(fabs(Evaluate(s0)), fabs(Evaluate(s1)));
+
+	// Solve b + 2cp + 3dp^2 = 0, p = s / s_max
+	double roots[2];
+	int n_roots = 0;
+
+	if (fabs(d_) > SMALL_NUMBER)
+	{
+		double discriminant = 4 * c_ * c_ - 12 * d_ * b_;
+		if (discriminant >= 0)
+		{
+			roots[n_roots++] = (-2 * c_ + sqrt(discriminant)) / (6 * d_);
+			roots[n_roots++] = (-2 * c_ - sqrt(discriminant)) / (6 * d_);
+		}
+	}
+	else if (fabs(c_) > SMALL_NUMBER)
+	{
+		roots[n_roots++] = -b_ / (2 * c_);
+	}
+
+	for (int i = 0; i < n_roots; i++)
+	{
+		double s = roots[i] * s_max_;
+		if (s > MIN(s0, s1) && s < MAX(s0, s1))
+		{
+			max_value = MAX(max_value, fabs(Evaluate(s)));
+		}
+	}
+
+	return max_value;
+}
+
 void Polynomial::Set(double a, double b, double c, double d, double s_max)
 {
 	a_ = a;
@@ -103,13 +245,83 @@ void Polynomial::Set(double a, double b, double c, double d, double s_max)
 
 void Geometry::Print()
 {
-	LOG("Geometry virtual Print\n");
+	switch (type_)
+	{
+	case GEOMETRY_TYPE_LINE: static_cast<Line*>(this)->Print(); break;
+	case GEOMETRY_TYPE_ARC: static_cast<Arc*>(this)->Print(); break;
+	case GEOMETRY_TYPE_SPIRAL: static_cast<Spiral*>(this)->Print(); break;
+	case GEOMETRY_TYPE_POLY3: static_cast<Poly3*>(this)->Print(); break;
+	case GEOMETRY_TYPE_PARAM_POLY3: static_cast<ParamPoly3*>(this)->Print(); break;
+	default: LOG("Geometry Print: Unknown geometry type %d\n", type_);
+	}
 }
 
 void Geometry::EvaluateDS(double ds, double *x, double *y, double *h)
 {
-	(void)ds; (void)x; (void)y; (void)h;
-	LOG("Geometry virtual Evaluate\n");
+	switch (type_)
+	{
+	case GEOMETRY_TYPE_LINE: static_cast<Line*>(this)->EvaluateDS(ds, x, y, h); break;
+	case GEOMETRY_TYPE_ARC: static_cast<Arc*>(this)->EvaluateDS(ds, x, y, h); break;
+	case GEOMETRY_TYPE_SPIRAL: static_cast<Spiral*>(this)->EvaluateDS(ds, x, y, h); break;
+	case GEOMETRY_TYPE_POLY3: static_cast<Poly3*>(this)->EvaluateDS(ds, x, y, h); break;
+	case GEOMETRY_TYPE_PARAM_POLY3: static_cast<ParamPoly3*>(this)->EvaluateDS(ds, x, y, h); break;
+	default: LOG("Geometry Evaluate: Unknown geometry type %d\n", type_);
+	}
+}
+
+void Geometry::EvaluateDSBatch(int n, const double *ds, double *x, double *y, double *h)
+{
+	switch (type_)
+	{
+	case GEOMETRY_TYPE_LINE: static_cast<Line*>(this)->EvaluateDSBatch(n, ds, x, y, h); break;
+	case GEOMETRY_TYPE_ARC: static_cast<Arc*>(this)->EvaluateDSBatch(n, ds, x, y, h); break;
+	case GEOMETRY_TYPE_SPIRAL: static_cast<Spiral*>(this)->EvaluateDSBatch(n, ds, x, y, h); break;
+	case GEOMETRY_TYPE_POLY3: static_cast<Poly3*>(this)->EvaluateDSBatch(n, ds, x, y, h); break;
+	case GEOMETRY_TYPE_PARAM_POLY3: static_cast<ParamPoly3*>(this)->EvaluateDSBatch(n, ds, x, y, h); break;
+	default: LOG("Geometry EvaluateDSBatch: Unknown geometry type %d\n", type_);
+	}
+}
+
+double Geometry::FindClosestDS(double x, double y, double tolerance)
+{
+	switch (type_)
+	{
+	case GEOMETRY_TYPE_LINE: return static_cast<Line*>(this)->FindClosestDS(x, y, tolerance);
+	case GEOMETRY_TYPE_ARC: return static_cast<Arc*>(this)->FindClosestDS(x, y, tolerance);
+	case GEOMETRY_TYPE_SPIRAL: return static_cast<Spiral*>(this)->FindClosestDS(x, y, tolerance);
+	case GEOMETRY_TYPE_POLY3: return static_cast<Poly3*>(this)->FindClosestDS(x, y, tolerance);
+	case GEOMETRY_TYPE_PARAM_POLY3: return static_cast<ParamPoly3*>(this)->FindClosestDS(x, y, tolerance);
+	default: LOG("Geometry FindClosestDS: Unknown geometry type %d\n", type_);
+	}
+	return 0.0;
+}
+
+double Geometry::EvaluateCurvatureDS(double ds)
+{
+	switch (type_)
+	{
+	case GEOMETRY_TYPE_LINE: return static_cast<Line*>(this)->EvaluateCurvatureDS(ds);
+	case GEOMETRY_TYPE_ARC: return static_cast<Arc*>(this)->EvaluateCurvatureDS(ds);
+	case GEOMETRY_TYPE_SPIRAL: return static_cast<Spiral*>(this)->EvaluateCurvatureDS(ds);
+	case GEOMETRY_TYPE_POLY3: return static_cast<Poly3*>(this)->EvaluateCurvatureDS(ds);
+	case GEOMETRY_TYPE_PARAM_POLY3: return static_cast<ParamPoly3*>(this)->EvaluateCurvatureDS(ds);
+	default: LOG("Geometry EvaluateCurvatureDS: Unknown geometry type %d\n", type_);
+	}
+	return 0.0;
+}
+
+double Geometry::GetCurvatureBound()
+{
+	switch (type_)
+	{
+	case GEOMETRY_TYPE_LINE: return static_cast<Line*>(this)->GetCurvatureBound();
+	case GEOMETRY_TYPE_ARC: return static_cast<Arc*>(this)->GetCurvatureBound();
+	case GEOMETRY_TYPE_SPIRAL: return static_cast<Spiral*>(this)->GetCurvatureBound();
+	case GEOMETRY_TYPE_POLY3: return static_cast<Poly3*>(this)->GetCurvatureBound();
+	case GEOMETRY_TYPE_PARAM_POLY3: return static_cast<ParamPoly3*>(this)->GetCurvatureBound();
+	default: LOG("Geometry GetCurvatureBound: Unknown geometry type %d\n", type_);
+	}
+	return 0.0;
 }
 
 void Line::Print()
@@ -124,6 +336,33 @@ void Line::EvaluateDS(double ds, double *x, double *y, double *h)
 	*y = GetY() + ds * sin(*h);
 }
 
+void Line::EvaluateDSBatch(int n, const double *ds, double *x, double *y, double *h)
+{
+	// Keep constants in local variables, helping the compiler to vectorize the loop
+	double x0 = GetX();
+	double y0 = GetY();
+	double hdg = GetHdg();
+	double cos_h = cos(hdg);
+	double sin_h = sin(hdg);
+
+	for (int i = 0; i < n; i++)
+	{
+		h[i] = hdg;
+		x[i] = x0 + ds[i] * cos_h;
+		y[i] = y0 + ds[i] * sin_h;
+	}
+}
+
+double Line::FindClosestDS(double x, double y, double tolerance)
+{
+	(void)tolerance;
+
+	// Projection on the line
+	double ds = (x - GetX()) * cos(GetHdg()) + (y - GetY()) * sin(GetHdg());
+
+	return CLAMP(ds, 0.0, GetLength());
+}
+
 void Arc::Print()
 {
 	LOG("Arc x: %.2f, y: %.2f, h: %.2f curvature: %.2f length: %.2f\n", GetX(), GetY(), GetHdg(), curvature_, GetLength());
@@ -157,38 +396,174 @@ void Arc::EvaluateDS(double ds, double *x, double *y, double *h)
 	*h = GetHdg() + angle;
 }
 
+void Arc::EvaluateDSBatch(int n, const double *ds, double *x, double *y, double *h)
+{
+	double x0 = GetX();
+	double y0 = GetY();
+	double hdg = GetHdg();
+	double cos_h = cos(hdg);
+	double sin_h = sin(hdg);
+	double radius = GetRadius();
+	double curvature = curvature_;
+
+	// Start angle and offset of local unit circle, see EvaluateDS()
+	double angle0 = curvature_ < 0 ? M_PI / 2.0 : 3.0 * M_PI / 2.0;
+	double y_local0 = curvature_ < 0 ? -1.0 : 1.0;
+
+	for (int i = 0; i < n; i++)
+	{
+		double angle = ds[i] * curvature;
+		double x_local = cos(angle + angle0);
+		double y_local = sin(angle + angle0) + y_local0;
+
+		x[i] = x0 + radius * (x_local * cos_h - y_local * sin_h);
+		y[i] = y0 + radius * (x_local * sin_h + y_local * cos_h);
+		h[i] = hdg + angle;
+	}
+}
+
+double Arc::FindClosestDS(double x, double y, double tolerance)
+{
+	if (fabs(curvature_) < CURV_ZERO)
+	{
+		return RefineClosestDS(this, x, y, tolerance);
+	}
+
+	// Center of the circle, on the left side for positive curvature
+	double xc = GetX() - sin(GetHdg()) / curvature_;
+	double yc = GetY() + cos(GetHdg()) / curvature_;
+
+	if (PointDistance(x, y, xc, yc) < SMALL_NUMBER)
+	{
+		return 0;  // all points equally close
+	}
+
+	// Heading of the circle where its radius points towards the point, see EvaluateDS()
+	double h = curvature_ > 0 ? atan2(x - xc, -(y - yc)) : atan2(-(x - xc), y - yc);
+
+	// Angle travelled from start, in driving direction, within [0, 2pi)
+	double angle = fmod((h - GetHdg()) * SIGN(curvature_), 2 * M_PI);
+	if (angle < 0)
+	{
+		angle += 2 * M_PI;
+	}
+
+	double ds = angle / fabs(curvature_);
+	if (ds > GetLength())
+	{
+		// Outside the arc, pick the closest end
+		double angle_to_end = angle - GetLength() * fabs(curvature_);
+		double angle_to_start = 2 * M_PI - angle;
+		ds = angle_to_end < angle_to_start ? GetLength() : 0;
+	}
+
+	return ds;
+}
+
 void Spiral::Print()
 {
 	LOG("Spiral x: %.2f, y: %.2f, h: %.2f start curvature: %.4f end curvature: %.4f length: %.2f\n",
 		GetX(), GetY(), GetHdg(), GetCurvStart(), GetCurvEnd(), GetLength());
 }
 
-void Spiral::EvaluateDS(double ds, double *x, double *y, double *h)
+void Spiral::Prepare(Arena *arena)
 {
-	double xTmp, yTmp, t, curv_a, curv_b, h_start;
+	backwards_ = !(abs(GetCurvEnd()) > abs(GetCurvStart()));
+	if (backwards_)
+	{
+		// Constant end point of the standard spiral segment, evaluation starts from there
+		odrSpiral(GetS0() + GetLength(), GetCDot(), &x_end_, &y_end_, &h_end_);
+	}
+	cos_h0_ = cos(-GetH0());
+	sin_h0_ = sin(-GetH0());
+
+	// rotation of standard spiral segment to road heading, see EvaluateDS()
+	double h_start = backwards_ ? GetHdg() - h_end_ : GetHdg();
+	cos_h_start_ = cos(h_start);
+	sin_h_start_ = sin(h_start);
+
+	// Create lookup table of points and tangents for cubic Hermite interpolation. The interpolation 
+	// error of each coordinate is bounded by ds^4 / 384 * max|d4r/ds4|, where for a spiral with 
+	// curvature k and curvature rate k': |d4r/ds4| = |-3kk'T - k^3N| <= 3|k||k'| + |k|^3 
+	// Step length ds is selected so that the position error is within SPIRAL_TABLE_MAX_ERROR.
+	table_ = ArenaVector<double>(arena);
+	table_ds_ = 0.0;
+
+	// Max curvature of the standard spiral segment covered by the table
+	double k_max = abs(GetCDot()) * MAX(abs(GetS0()), abs(GetS0() + GetLength()));
+	double r4_max = 3 * k_max * abs(GetCDot()) + k_max * k_max * k_max;
+	if (!(SPIRAL_TABLE_MAX_ERROR > 0.0) || !(abs(GetCDot()) > 0.0) || !std::isfinite(r4_max) || GetLength() < SMALL_NUMBER)
+	{
+		return;
+	}
+
+	double ds_max = r4_max > 0.0 ? pow(384.0 * SPIRAL_TABLE_MAX_ERROR / (sqrt(2.0) * r4_max), 0.25) : GetLength();
+	int n = (int)ceil(GetLength() / MIN(ds_max, GetLength()));
+	if (n + 1 > SPIRAL_TABLE_MAX_SIZE)
+	{
+		return;  // Too long or sharp, use exact evaluation
+	}
+
+	table_ds_ = GetLength() / n;
+	table_.resize(4 * (n + 1));
+	for (int i = 0; i < n + 1; i++)
+	{
+		double t;
+		odrSpiral(GetS0() + i * table_ds_, GetCDot(), &table_[4 * i], &table_[4 * i + 1], &t);
+		table_[4 * i + 2] = cos(t);
+		table_[4 * i + 3] = sin(t);
+	}
+}
+
+void Spiral::EvaluateStandardSpiral(double s, double *x, double *y, double *t)
+{
+	double u = table_ds_ > 0.0 ? (s - GetS0()) / table_ds_ : -1.0;
+	int n = (int)table_.size() / 4 - 1;
+
+	if (!(u >= 0.0 && u <= n))
+	{
+		// Outside table, or no table available
+		odrSpiral(s, GetCDot(), x, y, t);
+		return;
+	}
+
+	int i = MIN((int)u, n - 1);
+	double *p = &table_[4 * i];
+	u -= i;
+
+	// Cubic Hermite basis functions, tangent terms scaled by step length
+	double u2 = u * u;
+	double u3 = u2 * u;
+	double h00 = 2 * u3 - 3 * u2 + 1;
+	double h10 = (u3 - 2 * u2 + u) * table_ds_;
+	double h01 = -2 * u3 + 3 * u2;
+	double h11 = (u3 - u2) * table_ds_;
+
+	*x = h00 * p[0] + h10 * p[2] + h01 * p[4] + h11 * p[6];
+	*y = h00 * p[1] + h10 * p[3] + h01 * p[5] + h11 * p[7];
+	*t = s * s * GetCDot() * 0.5;
+}
 
-	curv_a = GetCurvStart();
-	curv_b = GetCurvEnd();
-	h_start = GetHdg();
+void Spiral::EvaluateDS(double ds, double *x, double *y, double *h)
+{
+	double xTmp, yTmp, t;
 
-	if (abs(curv_b) > abs(curv_a))
+	if (!backwards_)
 	{
-		odrSpiral(ds + GetS0(), GetCDot(), &xTmp, &yTmp, &t);
+		EvaluateStandardSpiral(ds + GetS0(), &xTmp, &yTmp, &t);
 		*h = t;
 	}
 	else  // backwards, starting from sharper curve - ending with lower curvature
 	{
-		double x0, y0, t0, x1, y1, t1;
+		double x1, y1, t1;
 
-		odrSpiral(GetS0() + GetLength(), GetCDot(), &x0, &y0, &t0);
-		odrSpiral(GetS0() + GetLength() - ds, GetCDot(), &x1, &y1, &t1);
+		EvaluateStandardSpiral(GetS0() + GetLength() - ds, &x1, &y1, &t1);
 
-		xTmp = x0 - x1;
-		yTmp = y0 - y1;
+		xTmp = x_end_ - x1;
+		yTmp = y_end_ - y1;
 
 		// rotate point according to heading, and translate to start position
-		h_start -= t0;
-		*h = t1 - t0;
+		*h = t1 - h_end_;
 	}
 
 	*h += GetHdg() + GetH0();
@@ -198,12 +573,25 @@ void Spiral::EvaluateDS(double ds, double *x, double *y, double *h)
 	// transform spline segment to origo and start angle = 0
 	x1 = xTmp - GetX0();
 	y1 = yTmp - GetY0();
-	x2 = x1 * cos(-GetH0()) - y1 * sin(-GetH0());
-	y2 = x1 * sin(-GetH0()) + y1 * cos(-GetH0());
+	x2 = x1 * cos_h0_ - y1 * sin_h0_;
+	y2 = x1 * sin_h0_ + y1 * cos_h0_;
 
 	// Then transform according to segment start position and heading
-	*x = GetX() + x2 * cos(h_start) - y2 * sin(h_start);
-	*y = GetY() + x2 * sin(h_start) + y2 * cos(h_start);
+	*x = GetX() + x2 * cos_h_start_ - y2 * sin_h_start_;
+	*y = GetY() + x2 * sin_h_start_ + y2 * cos_h_start_;
+}
+
+void Spiral::EvaluateDSBatch(int n, const double *ds, double *x, double *y, double *h)
+{
+	for (int i = 0; i < n; i++)
+	{
+		Spiral::EvaluateDS(ds[i], &x[i], &y[i], &h[i]);
+	}
+}
+
+double Spiral::FindClosestDS(double x, double y, double tolerance)
+{
+	return RefineClosestDS(this, x, y, tolerance);
 }
 
 double Spiral::EvaluateCurvatureDS(double ds)
@@ -211,6 +599,12 @@ double Spiral::EvaluateCurvatureDS(double ds)
 	return (curv_start_ + (ds / GetLength())* (curv_end_ - curv_start_));
 }
 
+double Spiral::GetCurvatureBound()
+{
+	// Curvature changes linearly
+	return MAX(fabs(curv_start_), fabs(curv_end_));
+}
+
 void Poly3::Print()
 {
 	LOG("Poly3 x: %.2f, y: %.2f, h: %.2f length: %.2f a: %.2f b: %.2f c: %.2f d: %.2f\n",
@@ -229,11 +623,53 @@ void Poly3::EvaluateDS(double ds, double *x, double *y, double *h)
 	*h = GetHdg() + poly3_.EvaluatePrim(p);
 }
 
+void Poly3::EvaluateDSBatch(int n, const double *ds, double *x, double *y, double *h)
+{
+	double x0 = GetX();
+	double y0 = GetY();
+	double hdg = GetHdg();
+	double cos_h = cos(hdg);
+	double sin_h = sin(hdg);
+	double length = GetLength();
+	double u_max = GetUMax();
+	double a = poly3_.GetA();
+	double b = poly3_.GetB();
+	double c = poly3_.GetC();
+	double d = poly3_.GetD();
+	double s_max = poly3_.GetSMax();
+
+	for (int i = 0; i < n; i++)
+	{
+		double p = (ds[i] / length) * u_max;
+		double q = p / s_max;  // see Polynomial::Evaluate()
+		double v_local = a + q * b + q * q * c + q * q * q * d;
+
+		x[i] = x0 + p * cos_h - v_local * sin_h;
+		y[i] = y0 + p * sin_h + v_local * cos_h;
+		h[i] = hdg + (b + 2 * q * c + 3 * q * q * d);
+	}
+}
+
+double Poly3::FindClosestDS(double x, double y, double tolerance)
+{
+	return RefineClosestDS(this, x, y, tolerance);
+}
+
 double Poly3::EvaluateCurvatureDS(double ds)
 {
 	return poly3_.EvaluatePrimPrim(ds);
 }
 
+double Poly3::GetCurvatureBound()
+{
+	// Curvature of v(u) is v'' / (1 + v'^2)^(3/2), hence bounded by |v''|. Which is linear in u, 
+	// so extreme values are found at the ends, u = 0 and u = umax.
+	double s_max = poly3_.GetSMax();
+	double q_max = GetUMax() / s_max;
+
+	return MAX(fabs(2 * poly3_.GetC()), fabs(2 * poly3_.GetC() + 6 * poly3_.GetD() * q_max)) / (s_max * s_max);
+}
+
 void ParamPoly3::Print()
 {
 	LOG("ParamPoly3 x: %.2f, y: %.2f, h: %.2f length: %.2f U: %.8f, %.8f, %.8f, %.8f V: %.8f, %.8f, %.8f, %.8f\n",
@@ -260,100 +696,331 @@ void ParamPoly3::EvaluateDS(double ds, double *x, double *y, double *h)
 	*h = GetHdg() + poly3V_.EvaluatePrim(p) / poly3U_.EvaluatePrim(p);
 }
 
-double ParamPoly3::EvaluateCurvatureDS(double ds)
+void ParamPoly3::EvaluateDSBatch(int n, const double *ds, double *x, double *y, double *h)
 {
-	return poly3V_.EvaluatePrimPrim(ds) / poly3U_.EvaluatePrim(ds);;
-}
-
-void Elevation::Print()
+	double x0 = GetX();
+	double y0 = GetY();
+	double hdg = GetHdg();
+	double cos_h = cos(hdg);
+	double sin_h = sin(hdg);
+	double length = GetPRange() == ParamPoly3::P_RANGE_NORMALIZED ? GetLength() : 1.0;
+	double aU = poly3U_.GetA();
+	double bU = poly3U_.GetB();
+	double cU = poly3U_.GetC();
+	double dU = poly3U_.GetD();
+	double aV = poly3V_.GetA();
+	double bV = poly3V_.GetB();
+	double cV = poly3V_.GetC();
+	double dV = poly3V_.GetD();
+	double s_maxU = poly3U_.GetSMax();
+	double s_maxV = poly3V_.GetSMax();
+
+	for (int i = 0; i < n; i++)
+	{
+		double p = ds[i] / length;
+		double qU = p / s_maxU;  // see Polynomial::Evaluate()
+		double qV = p / s_maxV;
+		double u_local = aU + qU * bU + qU * qU * cU + qU * qU * qU * dU;
+		double v_local = aV + qV * bV + qV * qV * cV + qV * qV * qV * dV;
+
+		x[i] = x0 + u_local * cos_h - v_local * sin_h;
+		y[i] = y0 + u_local * sin_h + v_local * cos_h;
+		h[i] = hdg + (bV + 2 * qV * cV + 3 * qV * qV * dV) / (bU + 2 * qU * cU + 3 * qU * qU * dU);
+	}
+}
+
+double ParamPoly3::FindClosestDS(double x, double y, double tolerance)
 {
-	LOG("Elevation: s: %.2f A: %.4f B: %.4f C: %.4f D: %.4f\n",
-		GetS(), poly3_.GetA(), poly3_.GetB(), poly3_.GetC(), poly3_.GetD());
+	return RefineClosestDS(this, x, y, tolerance);
 }
 
-void LaneLink::Print()
+double ParamPoly3::EvaluateCurvatureDS(double ds)
 {
-	LOG("LaneLink type: %d id: %d\n", type_, id_);
+	return poly3V_.EvaluatePrimPrim(ds) / poly3U_.EvaluatePrim(ds);;
 }
 
-LaneWidth *Lane::GetWidthByS(double s)
+/**
+Range of the quadratic c0 + c1 * p + c2 * p^2 within [p0, p1]
+*/
+static void QuadraticRange(double c0, double c1, double c2, double p0, double p1, double &min, double &max)
 {
-	if (lane_width_.size() == 0)
-	{
-		return 0;  // No lanewidth defined
-	}
-	for (int i=0; i+1<(int)lane_width_.size(); i++)
+	double v0 = c0 + c1 * p0 + c2 * p0 * p0;
+	double v1 = c0 + c1 * p1 + c2 * p1 * p1;
+
+	min = MIN(v0, v1);
+	max = MAX(v0, v1);
+
+	// Extreme value in between, where the derivative is zero
+	if (c2 != 0)
 	{
-		if (s < lane_width_[i + 1]->GetSOffset())
+		double p = -c1 / (2 * c2);
+		if (p > p0 && p < p1)
 		{
-			return lane_width_[i];
+			double v = c0 + c1 * p + c2 * p * p;
+			min = MIN(min, v);
+			max = MAX(max, v);
 		}
 	}
-	return lane_width_.back();
 }
 
-LaneLink *Lane::GetLink(LinkType type)
+/**
+Upper bound of the curvature |u'v'' - v'u''| / (u'^2 + v'^2)^(3/2) of a parametric cubic within [p0, p1], 
+from the ranges of the derivatives. An interval where the derivatives might both be zero, i.e. the curve 
+might stop and turn, is halved until proven free from such points.
+@param du Coefficients of u' = du[0] + du[1] * p + du[2] * p^2
+@param dv Coefficients of v', same as du
+@param splits Max number of times to halve the interval
+@return The bound, INFINITY if the curve can not be proven free from cusps
+*/
+static double ParamCurvatureBound(const double *du, const double *dv, double p0, double p1, int splits)
 {
-	for (int i=0; i<(int)link_.size(); i++)
+	double du_min, du_max, dv_min, dv_max;
+	QuadraticRange(du[0], du[1], du[2], p0, p1, du_min, du_max);
+	QuadraticRange(dv[0], dv[1], dv[2], p0, p1, dv_min, dv_max);
+
+	// Smallest absolute values of u' and v', zero if changing sign
+	double du_abs_min = du_min > 0 ? du_min : (du_max < 0 ? -du_max : 0);
+	double dv_abs_min = dv_min > 0 ? dv_min : (dv_max < 0 ? -dv_max : 0);
+	double speed2_min = du_abs_min * du_abs_min + dv_abs_min * dv_abs_min;
+
+	if (speed2_min <= 0)
 	{
-		LaneLink *l = link_[i];
-		if (l->GetType() == type)
+		if (splits == 0)
 		{
-			return l;
+			return INFINITY;
 		}
+		double p_mid = (p0 + p1) / 2;
+		return MAX(ParamCurvatureBound(du, dv, p0, p_mid, splits - 1), ParamCurvatureBound(du, dv, p_mid, p1, splits - 1));
 	}
-	return 0; // No link of requested type exists
+
+	// Second derivatives are linear, extreme values at the ends
+	double ddu_abs_max = MAX(fabs(du[1] + 2 * du[2] * p0), fabs(du[1] + 2 * du[2] * p1));
+	double ddv_abs_max = MAX(fabs(dv[1] + 2 * dv[2] * p0), fabs(dv[1] + 2 * dv[2] * p1));
+	double du_abs_max = MAX(fabs(du_min), fabs(du_max));
+	double dv_abs_max = MAX(fabs(dv_min), fabs(dv_max));
+
+	return (du_abs_max * ddv_abs_max + dv_abs_max * ddu_abs_max) / (speed2_min * sqrt(speed2_min));
 }
 
-void LaneWidth::Print()
+double ParamPoly3::GetCurvatureBound()
 {
-	LOG("LaneWidth: sOffset: %.2f, a: %.2f, b: %.2f, c: %.2f, d: %.2f\n",
-		s_offset_, poly3_.GetA(), poly3_.GetB(), poly3_.GetC(), poly3_.GetD());
+	// Derivatives with respect to p, see Polynomial::Evaluate() for the scaling by s_max
+	double p_max = GetPRange() == ParamPoly3::P_RANGE_NORMALIZED ? 1.0 : GetLength();
+	double su = poly3U_.GetSMax();
+	double sv = poly3V_.GetSMax();
+	double du[3] = { poly3U_.GetB() / su, 2 * poly3U_.GetC() / (su * su), 3 * poly3U_.GetD() / (su * su * su) };
+	double dv[3] = { poly3V_.GetB() / sv, 2 * poly3V_.GetC() / (sv * sv), 3 * poly3V_.GetD() / (sv * sv * sv) };
+	double bound = 0;
+
+	// Bounds of shorter intervals are tighter
+	for (int i = 0; i < CURVATURE_BOUND_INTERVALS; i++)
+	{
+		double p0 = i * p_max / CURVATURE_BOUND_INTERVALS;
+		double p1 = (i + 1) * p_max / CURVATURE_BOUND_INTERVALS;
+		bound = MAX(bound, ParamCurvatureBound(du, dv, p0, p1, CURVATURE_BOUND_MAX_SPLITS));
+	}
+
+	return bound;
 }
 
-void LaneOffset::Print()
+GeometryRecord::GeometryRecord(const Line &line) : type_(Geometry::GEOMETRY_TYPE_LINE)
 {
-	LOG("LaneOffset s %.2f a %.4f b %.2f c %.2f d %.2f s_max %.2f length %.2f\n",
-		s_, polynomial_.GetA(), polynomial_.GetB(), polynomial_.GetC(), polynomial_.GetD(), polynomial_.GetSMax(), length_);
+	new (&line_) Line(line);
 }
 
-double LaneOffset::GetLaneOffset(double s)
+GeometryRecord::GeometryRecord(const Arc &arc) : type_(Geometry::GEOMETRY_TYPE_ARC)
 {
-	return (polynomial_.Evaluate(s - s_));
+	new (&arc_) Arc(arc);
 }
 
-double LaneOffset::GetLaneOffsetPrim(double s)
+GeometryRecord::GeometryRecord(const Spiral &spiral) : type_(Geometry::GEOMETRY_TYPE_SPIRAL)
 {
-	return (polynomial_.EvaluatePrim(s - s_));
+	new (&spiral_) Spiral(spiral);
 }
 
-void Lane::Print()
+GeometryRecord::GeometryRecord(const Poly3 &poly3) : type_(Geometry::GEOMETRY_TYPE_POLY3)
 {
-	LOG("Lane: %d, type: %d, level: %d\n", id_, type_, level_);
-	
-	for (size_t i = 0; i < link_.size(); i++)
+	new (&poly3_) Poly3(poly3);
+}
+
+GeometryRecord::GeometryRecord(const ParamPoly3 &param_poly3) : type_(Geometry::GEOMETRY_TYPE_PARAM_POLY3)
+{
+	new (&param_poly3_) ParamPoly3(param_poly3);
+}
+
+GeometryRecord::GeometryRecord(const GeometryRecord &other)
+{
+	Copy(other);
+}
+
+GeometryRecord::GeometryRecord(GeometryRecord &&other) noexcept
+{
+	Move(other);
+}
+
+GeometryRecord &GeometryRecord::operator=(const GeometryRecord &other)
+{
+	if (this != &other)
 	{
-		link_[i]->Print();
+		Destroy();
+		Copy(other);
 	}
+	return *this;
+}
 
-	for (size_t i=0; i<lane_width_.size(); i++)
+GeometryRecord::~GeometryRecord()
+{
+	Destroy();
+}
+
+Geometry *GeometryRecord::GetGeometry()
+{
+	switch (type_)
 	{
-		lane_width_[i]->Print();
+	case Geometry::GEOMETRY_TYPE_LINE: return &line_;
+	case Geometry::GEOMETRY_TYPE_ARC: return &arc_;
+	case Geometry::GEOMETRY_TYPE_SPIRAL: return &spiral_;
+	case Geometry::GEOMETRY_TYPE_POLY3: return &poly3_;
+	case Geometry::GEOMETRY_TYPE_PARAM_POLY3: return &param_poly3_;
+	default: return 0;
 	}
 }
 
-int Lane::IsDriving()
+void GeometryRecord::Copy(const GeometryRecord &other)
 {
-	if (GetId() == 0)
+	type_ = other.type_;
+	switch (type_)
 	{
-		return 0;  // Ref lane no width -> no driving
+	case Geometry::GEOMETRY_TYPE_LINE: new (&line_) Line(other.line_); break;
+	case Geometry::GEOMETRY_TYPE_ARC: new (&arc_) Arc(other.arc_); break;
+	case Geometry::GEOMETRY_TYPE_SPIRAL: new (&spiral_) Spiral(other.spiral_); break;
+	case Geometry::GEOMETRY_TYPE_POLY3: new (&poly3_) Poly3(other.poly3_); break;
+	case Geometry::GEOMETRY_TYPE_PARAM_POLY3: new (&param_poly3_) ParamPoly3(other.param_poly3_); break;
+	default: break;
 	}
+}
 
+void GeometryRecord::Move(GeometryRecord &other)
+{
+	type_ = other.type_;
 	switch (type_)
 	{
-	case Lane::LANE_TYPE_DRIVING:
-	case Lane::LANE_TYPE_ENTRY:
-	case Lane::LANE_TYPE_EXIT:
+	case Geometry::GEOMETRY_TYPE_LINE: new (&line_) Line(std::move(other.line_)); break;
+	case Geometry::GEOMETRY_TYPE_ARC: new (&arc_) Arc(std::move(other.arc_)); break;
+	case Geometry::GEOMETRY_TYPE_SPIRAL: new (&spiral_) Spiral(std::move(other.spiral_)); break;
+	case Geometry::GEOMETRY_TYPE_POLY3: new (&poly3_) Poly3(std::move(other.poly3_)); break;
+	case Geometry::GEOMETRY_TYPE_PARAM_POLY3: new (&param_poly3_) ParamPoly3(std::move(other.param_poly3_)); break;
+	default: break;
+	}
+}
+
+void GeometryRecord::Destroy()
+{
+	switch (type_)
+	{
+	case Geometry::GEOMETRY_TYPE_LINE: line_.~Line(); break;
+	case Geometry::GEOMETRY_TYPE_ARC: arc_.~Arc(); break;
+	case Geometry::GEOMETRY_TYPE_SPIRAL: spiral_.~Spiral(); break;
+	case Geometry::GEOMETRY_TYPE_POLY3: poly3_.~Poly3(); break;
+	case Geometry::GEOMETRY_TYPE_PARAM_POLY3: param_poly3_.~ParamPoly3(); break;
+	default: break;
+	}
+	type_ = Geometry::GEOMETRY_TYPE_UNKNOWN;
+}
+
+void Elevation::Print()
+{
+	LOG("Elevation: s: %.2f A: %.4f B: %.4f C: %.4f D: %.4f\n",
+		GetS(), poly3_.GetA(), poly3_.GetB(), poly3_.GetC(), poly3_.GetD());
+}
+
+void LaneLink::Print()
+{
+	LOG("LaneLink type: %d id: %d\n", type_, id_);
+}
+
+LaneWidth *Lane::GetWidthByS(double s)
+{
+	if (lane_width_.size() == 0)
+	{
+		return 0;  // No lanewidth defined
+	}
+	return lane_width_[GetWidthIdxByS(s)];
+}
+
+int Lane::GetWidthIdxByS(double s, int hint_idx)
+{
+	return GetIdxByS(lane_width_s_, s, hint_idx);
+}
+
+void Lane::AddLaneWIdth(LaneWidth *lane_width)
+{
+	lane_width_.push_back(lane_width);
+	lane_width_s_.push_back(lane_width->GetSOffset());
+}
+
+LaneLink *Lane::GetLink(LinkType type)
+{
+	for (int i=0; i<(int)link_.size(); i++)
+	{
+		LaneLink *l = link_[i];
+		if (l->GetType() == type)
+		{
+			return l;
+		}
+	}
+	return 0; // No link of requested type exists
+}
+
+void LaneWidth::Print()
+{
+	LOG("LaneWidth: sOffset: %.2f, a: %.2f, b: %.2f, c: %.2f, d: %.2f\n",
+		s_offset_, poly3_.GetA(), poly3_.GetB(), poly3_.GetC(), poly3_.GetD());
+}
+
+void LaneOffset::Print()
+{
+	LOG("LaneOffset s %.2f a %.4f b %.2f c %.2f d %.2f s_max %.2f length %.2f\n",
+		s_, polynomial_.GetA(), polynomial_.GetB(), polynomial_.GetC(), polynomial_.GetD(), polynomial_.GetSMax(), length_);
+}
+
+double LaneOffset::GetLaneOffset(double s)
+{
+	return (polynomial_.Evaluate(s - s_));
+}
+
+double LaneOffset::GetLaneOffsetPrim(double s)
+{
+	return (polynomial_.EvaluatePrim(s - s_));
+}
+
+void Lane::Print()
+{
+	LOG("Lane: %d, type: %d, level: %d\n", id_, type_, level_);
+	
+	for (size_t i = 0; i < link_.size(); i++)
+	{
+		link_[i]->Print();
+	}
+
+	for (size_t i=0; i<lane_width_.size(); i++)
+	{
+		lane_width_[i]->Print();
+	}
+}
+
+int Lane::IsDriving()
+{
+	if (GetId() == 0)
+	{
+		return 0;  // Ref lane no width -> no driving
+	}
+
+	switch (type_)
+	{
+	case Lane::LANE_TYPE_DRIVING:
+	case Lane::LANE_TYPE_ENTRY:
+	case Lane::LANE_TYPE_EXIT:
 	case Lane::LANE_TYPE_OFF_RAMP:
 	case Lane::LANE_TYPE_ON_RAMP:
 	case Lane::LANE_TYPE_PARKING:
@@ -381,25 +1048,33 @@ LaneSection* Road::GetLaneSectionByIdx(int idx)
 
 LaneSection* Road::GetLaneSectionByS(double s)
 {
-	double length = 0;
-
 	if (lane_section_.size() == 0)
 	{
 		return 0;
 	}
 
-	for (size_t i = 0; i < lane_section_.size(); i++)
-	{
-		length = length + lane_section_[i]->GetLength();
+	// s outside segment gives first or last lane section
+	return lane_section_[GetLaneSectionIdxByS(s)];
+}
 
-		if (s < length)
-		{
-			return lane_section_[i];
-		}
-	}
+int Road::GetLaneSectionIdxByS(double s, int hint_idx)
+{
+	return GetIdxByS(lane_section_s_, s, hint_idx);
+}
 
-	// s outside segment - return last lane section
-	return (lane_section_.back());
+int Road::GetGeometryIdxByS(double s, int hint_idx)
+{
+	return GetIdxByS(geometry_s_, s, hint_idx);
+}
+
+int Road::GetElevationIdxByS(double s, int hint_idx)
+{
+	return GetIdxByS(elevation_s_, s, hint_idx);
+}
+
+int Road::GetLaneOffsetIdxByS(double s, int hint_idx)
+{
+	return GetIdxByS(lane_offset_s_, s, hint_idx);
 }
 
 LaneInfo Road::GetLaneInfoByS(double s, int start_lane_section_idx, int start_lane_id)
@@ -454,7 +1129,7 @@ Geometry* Road::GetGeometry(int idx)
 		LOG("Road::GetGeometry index %d out of range [0:%d]\n", idx, (int)geometry_.size());
 		return 0;
 	}
-	return geometry_[idx]; 
+	return geometry_[idx].GetGeometry();
 }
 
 
@@ -651,18 +1326,79 @@ double LaneSection::GetCenterOffsetHeading(double s, int lane_id)
 	return (inner_offset_heading + outer_offset_heading) / 2;
 }
 
+std::atomic<int> LaneSection::serial_counter_(1);  // 0 reserved for no lane section
+
 void LaneSection::AddLane(Lane *lane)
 {
 	lane_.push_back(lane);
+
+	// Update lane order and inner neighbours, for calculation of all lane offsets at once
+	lane_order_.clear();
+	inner_lane_idx_.clear();
+	for (int i = 0; i < (int)lane_.size(); i++)
+	{
+		int id = lane_[i]->GetId();
+		int j = 0;
+
+		while (j < (int)lane_order_.size() && abs(lane_[lane_order_[j]]->GetId()) <= abs(id))
+		{
+			j++;
+		}
+		lane_order_.insert(lane_order_.begin() + j, i);
+		inner_lane_idx_.push_back(abs(id) > 1 ? GetLaneIdxById(id - SIGN(id)) : -1);
+	}
+}
+
+void LaneSection::GetOuterOffsets(double s, double *outer_offset)
+{
+	for (size_t i = 0; i < lane_order_.size(); i++)
+	{
+		int idx = lane_order_[i];
+		Lane *lane = lane_[idx];
+		LaneWidth *lane_width = lane->GetWidthByS(s - s_);
+
+		if (lane->GetId() == 0 || lane_width == 0)
+		{
+			// Reference lane or no lane width registered, see GetOuterOffset()
+			outer_offset[idx] = 0.0;
+			continue;
+		}
+
+		// Calculate width at local s-parameter in width segment
+		double width = lane_width->poly3_.Evaluate(s - (s_ + lane_width->GetSOffset()));
+
+		// Inner lanes are already calculated, just add the width of this one
+		outer_offset[idx] = inner_lane_idx_[idx] < 0 ? width : width + outer_offset[inner_lane_idx_[idx]];
+	}
+}
+
+double LaneSection::GetCenterOffsetFromOuterOffsets(double *outer_offset, int lane_idx)
+{
+	if (lane_[lane_idx]->GetId() == 0)
+	{
+		// Reference lane (0) has no width
+		return 0.0;
+	}
+
+	double inner_offset = inner_lane_idx_[lane_idx] < 0 ? 0.0 : outer_offset[inner_lane_idx_[lane_idx]];
+
+	// Center is simply mean value of inner and outer lane boundries
+	return (inner_offset + outer_offset[lane_idx]) / 2;
 }
 
 int LaneSection::GetConnectingLaneId(int incoming_lane_id, LinkType link_type)
 {
 	int id = incoming_lane_id;
+	Lane *lane = GetLaneById(id);
 
-	if (GetLaneById(id)->GetLink(link_type))
+	if (lane == 0)
+	{
+		// Lane not available, e.g. position just moved onto another road - keep lane id
+		return id;
+	}
+	else if (lane->GetLink(link_type))
 	{
-		id = GetLaneById(id)->GetLink(link_type)->GetId();
+		id = lane->GetLink(link_type)->GetId();
 	}
 	else
 	{
@@ -749,22 +1485,6 @@ void RoadLink::Print()
 	cout << "RoadLink type: " << type_ << " id: " << element_id_ << " element type: " << element_type_ << " contact point type: " << contact_point_type_ << endl;
 }
 
-Road::~Road()
-{
-	for (size_t i=0; i<geometry_.size(); i++)
-	{
-		delete(geometry_[i]);
-	}
-	for (size_t i=0; i<elevation_profile_.size(); i++)
-	{
-		delete(elevation_profile_[i]);
-	}
-	for (size_t i=0; i<link_.size(); i++)
-	{
-		delete(link_[i]);
-	}
-}
-
 void Road::Print()
 {
 	LOG("Road id: %d length: %.2f\n", id_, GetLength());
@@ -772,7 +1492,7 @@ void Road::Print()
 
 	for (size_t i = 0; i < geometry_.size(); i++)
 	{
-		cout << "Geometry type: " << geometry_[i]->GetType() << endl;
+		cout << "Geometry type: " << geometry_[i].GetGeometry()->GetType() << endl;
 	}
 
 	for (size_t i=0; i<link_.size(); i++)
@@ -791,18 +1511,185 @@ void Road::Print()
 	}
 }
 
-void Road::AddLine(Line *line)
+void Road::EvaluateSBatch(int n, const double *s, double *x, double *y, double *h)
+{
+	const int buf_size = 64;
+	double ds[buf_size];
+	int geom_idx = -1;
+
+	if (geometry_.size() == 0)
+	{
+		LOG("Road::EvaluateSBatch Error: No geometries in road %d\n", id_);
+		return;
+	}
+
+	for (int i = 0; i < n;)
+	{
+		geom_idx = GetGeometryIdxByS(s[i], geom_idx);
+		Geometry *geom = geometry_[geom_idx].GetGeometry();
+
+		// Collect following points on the same geometry
+		int n_batch = 0;
+		do
+		{
+			ds[n_batch] = s[i + n_batch] - geom->GetS();
+			n_batch++;
+		} while (n_batch < buf_size && i + n_batch < n && GetGeometryIdxByS(s[i + n_batch], geom_idx) == geom_idx);
+
+		geom->EvaluateDSBatch(n_batch, ds, &x[i], &y[i], &h[i]);
+		i += n_batch;
+	}
+}
+
+void RoadCursor::Set(Road *road, double s)
+{
+	if (road == 0)
+	{
+		LOG("RoadCursor::Set Error: No road\n");
+		return;
+	}
+
+	road_ = road;
+	s_ = CLAMP(s, 0.0, road_->GetLength());
+	geometry_idx_ = -1;
+	lane_section_idx_ = -1;
+	elevation_idx_ = -1;
+	lane_offset_idx_ = -1;
+	z_ = 0.0;
+	p_ = 0.0;
+	lane_offset_ = 0.0;
+	lane_offset_prim_ = 0.0;
+	Anchor(0.0);
+	UpdateProfiles();
+}
+
+void RoadCursor::MoveTo(double s)
+{
+	if (road_ == 0)
+	{
+		LOG("RoadCursor::MoveTo Error: No road\n");
+		return;
+	}
+
+	s = CLAMP(s, 0.0, road_->GetLength());
+	double ds = s - s_;
+	s_ = s;
+
+	if (step_ != 0.0 && fabs(ds - step_) < SMALL_NUMBER && n_steps_ < ROAD_CURSOR_ANCHOR_INTERVAL &&
+		road_->GetGeometryIdxByS(s_, geometry_idx_) == geometry_idx_)
+	{
+		// Move along the chord, which is rotated half of the heading change from current heading
+		x_ += chord_ * (cos_h_ * cos_half_ - sin_h_ * sin_half_);
+		y_ += chord_ * (sin_h_ * cos_half_ + cos_h_ * sin_half_);
+
+		double cos_h = cos_h_ * cos_step_ - sin_h_ * sin_step_;
+		sin_h_ = sin_h_ * cos_step_ + cos_h_ * sin_step_;
+		cos_h_ = cos_h;
+		h_ += step_h_;
+		n_steps_++;
+	}
+	else
+	{
+		Anchor(ds);
+	}
+
+	UpdateProfiles();
+}
+
+void RoadCursor::Anchor(double step)
+{
+	geometry_idx_ = road_->GetGeometryIdxByS(s_, geometry_idx_);
+	Geometry *geom = road_->GetGeometry(geometry_idx_);
+	if (geom == 0)
+	{
+		LOG("RoadCursor::Anchor Error: No geometry in road %d\n", road_->GetId());
+		return;
+	}
+
+	geom->EvaluateDS(s_ - geom->GetS(), &x_, &y_, &h_);
+	cos_h_ = cos(h_);
+	sin_h_ = sin(h_);
+	n_steps_ = 0;
+	step_ = 0.0;
+
+	if (step != 0.0 && (geom->GetType() == Geometry::GEOMETRY_TYPE_LINE || geom->GetType() == Geometry::GEOMETRY_TYPE_ARC))
+	{
+		// Prepare recurrence for following steps of same length
+		double curvature = geom->EvaluateCurvatureDS(0.0);
+		step_ = step;
+		step_h_ = step * curvature;
+		chord_ = fabs(curvature) < CURV_ZERO ? step : 2.0 * sin(step_h_ / 2.0) / curvature;
+		cos_half_ = cos(step_h_ / 2.0);
+		sin_half_ = sin(step_h_ / 2.0);
+		cos_step_ = cos(step_h_);
+		sin_step_ = sin(step_h_);
+	}
+}
+
+void RoadCursor::UpdateProfiles()
+{
+	if (road_->GetNumberOfLaneSections() > 0)
+	{
+		lane_section_idx_ = road_->GetLaneSectionIdxByS(s_, lane_section_idx_);
+	}
+
+	if (road_->GetNumberOfElevations() > 0)
+	{
+		elevation_idx_ = road_->GetElevationIdxByS(s_, elevation_idx_);
+		Elevation *elevation = road_->GetElevation(elevation_idx_);
+		z_ = elevation->poly3_.Evaluate(s_ - elevation->GetS());
+		p_ = -elevation->poly3_.EvaluatePrim(s_ - elevation->GetS());
+	}
+
+	if (road_->lane_offset_.size() > 0)
+	{
+		lane_offset_idx_ = road_->GetLaneOffsetIdxByS(s_, lane_offset_idx_);
+		lane_offset_ = road_->lane_offset_[lane_offset_idx_]->GetLaneOffset(s_);
+		lane_offset_prim_ = road_->lane_offset_[lane_offset_idx_]->GetLaneOffsetPrim(s_);
+	}
+}
+
+void RoadCursor::GetLanePos(int lane_id, double offset, double *x, double *y, double *h)
+{
+	double t = offset;
+	double h_offset = 0.0;
+
+	LaneSection *lane_section = road_ ? road_->GetLaneSectionByIdx(lane_section_idx_) : 0;
+	if (lane_section != 0)
+	{
+		t += lane_section->GetCenterOffset(s_, lane_id) * (lane_id < 0 ? -1 : 1);
+		h_offset = lane_section->GetCenterOffsetHeading(s_, lane_id) * (lane_id < 0 ? -1 : 1);
+	}
+
+	// Lateral displacement perpendicular to the reference line, see Position::Track2XYZ()
+	*x = x_ - (t + lane_offset_) * sin_h_;
+	*y = y_ + (t + lane_offset_) * cos_h_;
+	*h = h_ + h_offset + (lane_offset_prim_ != 0.0 ? atan(lane_offset_prim_) : 0.0);
+
+	if (lane_id > 0)
+	{
+		*h += M_PI;
+	}
+}
+
+void Road::AddLine(const Line &line)
 {
-	geometry_.push_back((Geometry*)line);
+	geometry_.push_back(GeometryRecord(line));
+	geometry_s_.push_back(geometry_.back().GetGeometry()->GetS());
 }
 
-void Road::AddArc(Arc *arc)
+void Road::AddArc(const Arc &arc)
 {
-	geometry_.push_back((Geometry*)arc);
+	geometry_.push_back(GeometryRecord(arc));
+	geometry_s_.push_back(geometry_.back().GetGeometry()->GetS());
+	max_curvature_ = MAX(max_curvature_, geometry_.back().GetGeometry()->GetCurvatureBound());
 }
 
-void Road::AddSpiral(Spiral *spiral)
+void Road::AddSpiral(const Spiral &spiral_in)
 {
+	geometry_.push_back(GeometryRecord(spiral_in));
+	Spiral *spiral = (Spiral*)geometry_.back().GetGeometry();
+
 	if (abs(spiral->GetCurvEnd()) > CURV_ZERO && abs(spiral->GetCurvStart()) > CURV_ZERO)
 	{
 		// not starting from zero curvature (straight line)
@@ -837,13 +1724,16 @@ void Road::AddSpiral(Spiral *spiral)
 	{
 		spiral->SetCDot((spiral->GetCurvEnd() - spiral->GetCurvStart()) / spiral->GetLength());
 	}
-	geometry_.push_back((Geometry*)spiral);
+	spiral->Prepare(geometry_.get_allocator().GetArena());
+	geometry_s_.push_back(spiral->GetS());
+	max_curvature_ = MAX(max_curvature_, spiral->GetCurvatureBound());
 }
 
-void Road::AddPoly3(Poly3 *poly3)
+void Road::AddPoly3(const Poly3 &poly3)
 {
-	geometry_.push_back((Geometry*)poly3);
-	Poly3 *p3 = (Poly3*)geometry_.back();
+	geometry_.push_back(GeometryRecord(poly3));
+	Poly3 *p3 = (Poly3*)geometry_.back().GetGeometry();
+	geometry_s_.push_back(p3->GetS());
 	
 	// Calculate umax (valid interval)
 	int step_len = 1;
@@ -862,11 +1752,14 @@ void Road::AddPoly3(Poly3 *poly3)
 		y0 = y1;
 	}
 	p3->SetUMax(x0);
+	max_curvature_ = MAX(max_curvature_, p3->GetCurvatureBound());
 }
 
-void Road::AddParamPoly3(ParamPoly3 *param_poly3)
+void Road::AddParamPoly3(const ParamPoly3 &param_poly3)
 {
-	geometry_.push_back((Geometry*)param_poly3);
+	geometry_.push_back(GeometryRecord(param_poly3));
+	geometry_s_.push_back(geometry_.back().GetGeometry()->GetS());
+	max_curvature_ = MAX(max_curvature_, geometry_.back().GetGeometry()->GetCurvatureBound());
 }
 
 void Road::AddElevation(Elevation *elevation)
@@ -880,44 +1773,27 @@ void Road::AddElevation(Elevation *elevation)
 	elevation->SetLength(length_ - elevation->GetS());
 
 	elevation_profile_.push_back((Elevation*)elevation);
+	elevation_s_.push_back(elevation->GetS());
 }
 
 double Road::GetLaneOffset(double s)
 {
-	int i = 0;
-
 	if (lane_offset_.size() == 0)
 	{
 		return 0;
 	}
 
-	for (; i + 1 < (int)lane_offset_.size(); i++)
-	{
-		if (s < lane_offset_[i + 1]->GetS())
-		{
-			break;
-		}
-	}
-	return (lane_offset_[i]->GetLaneOffset(s));
+	return (lane_offset_[GetLaneOffsetIdxByS(s)]->GetLaneOffset(s));
 }
 
 double Road::GetLaneOffsetPrim(double s)
 {
-	int i = 0;
-
 	if (lane_offset_.size() == 0)
 	{
 		return 0;
 	}
 
-	for (; i + 1 < (int)lane_offset_.size(); i++)
-	{
-		if (s < lane_offset_[i + 1]->GetS())
-		{
-			break;
-		}
-	}
-	return (lane_offset_[i]->GetLaneOffsetPrim(s));
+	return (lane_offset_[GetLaneOffsetIdxByS(s)]->GetLaneOffsetPrim(s));
 }
 
 int Road::GetNumberOfLanes(double s)
@@ -935,29 +1811,103 @@ int Road::GetNumberOfLanes(double s)
 	return (lane_section_[i]->GetNumberOfLanes());
 }
 
-void Road::AddLaneOffset(LaneOffset *lane_offset)
+double Road::GetLaneOffsetAbsMax(double s0, double s1)
 {
-	// Adjust lane offset length
-	if (lane_offset_.size() > 0)
-	{
-		LaneOffset *lo_previous = lane_offset_.back();
-		lo_previous->SetLength(lane_offset->GetS() - lo_previous->GetS());
-	}
-	lane_offset->SetLength(length_ - lane_offset->GetS());
-	
-	lane_offset_.push_back((LaneOffset*)lane_offset);
-}
+	double max_offset = 0;
 
-double Road::GetCenterOffset(double s, int lane_id)
-{
-	// First find out what lane section 
-	LaneSection *lane_section = GetLaneSectionByS(s);
-	if (lane_section)
+	// Consider each lane offset entry within the interval, applying the same selection rule as GetLaneOffset()
+	for (int i = 0; i < (int)lane_offset_.size(); i++)
 	{
-		return lane_section->GetCenterOffset(s, lane_id);
+		double start = i == 0 ? s0 : MAX(s0, lane_offset_[i]->GetS());
+		double end = i == (int)lane_offset_.size() - 1 ? s1 : MIN(s1, lane_offset_[i + 1]->GetS());
+
+		if (start <= end)
+		{
+			max_offset = MAX(max_offset, lane_offset_[i]->GetLaneOffsetAbsMax(start, end));
+		}
 	}
 
-	return 0.0;
+	return max_offset;
+}
+
+double Road::GetLanesWidthAbsMax(double s0, double s1)
+{
+	double max_width = 0;
+
+	for (int i = 0; i < (int)lane_section_.size(); i++)
+	{
+		LaneSection *lane_section = lane_section_[i];
+		
+		// Skip lane sections not overlapping the interval. First and last section covers any s outside the road.
+		if ((i > 0 && lane_section->GetS() > s1) || 
+			(i < (int)lane_section_.size() - 1 && lane_section->GetS() + lane_section->GetLength() < s0))
+		{
+			continue;
+		}
+
+		// Local s interval within lane section
+		double ls0 = MAX(0.0, s0 - lane_section->GetS());
+		double ls1 = MIN(lane_section->GetLength(), s1 - lane_section->GetS());
+		double width_left = 0;
+		double width_right = 0;
+
+		for (int j = 0; j < lane_section->GetNumberOfLanes(); j++)
+		{
+			Lane *lane = lane_section->GetLaneByIdx(j);
+			double lane_width = 0;
+
+			// Apply same width entry selection rule as Lane::GetWidthByS()
+			for (int k = 0; k < lane->GetNumberOfLaneWidths(); k++)
+			{
+				LaneWidth *width = lane->GetWidthByIndex(k);
+				double start = k == 0 ? ls0 : MAX(ls0, width->GetSOffset());
+				double end = k == lane->GetNumberOfLaneWidths() - 1 ? ls1 : MIN(ls1, lane->GetWidthByIndex(k + 1)->GetSOffset());
+
+				if (start <= end)
+				{
+					lane_width = MAX(lane_width, width->poly3_.EvaluateAbsMax(start - width->GetSOffset(), end - width->GetSOffset()));
+				}
+			}
+
+			if (lane->GetId() > 0)
+			{
+				width_left += lane_width;
+			}
+			else if (lane->GetId() < 0)
+			{
+				width_right += lane_width;
+			}
+		}
+		max_width = MAX(max_width, MAX(width_left, width_right));
+	}
+
+	return max_width;
+}
+
+void Road::AddLaneOffset(LaneOffset *lane_offset)
+{
+	// Adjust lane offset length
+	if (lane_offset_.size() > 0)
+	{
+		LaneOffset *lo_previous = lane_offset_.back();
+		lo_previous->SetLength(lane_offset->GetS() - lo_previous->GetS());
+	}
+	lane_offset->SetLength(length_ - lane_offset->GetS());
+	
+	lane_offset_.push_back((LaneOffset*)lane_offset);
+	lane_offset_s_.push_back(lane_offset->GetS());
+}
+
+double Road::GetCenterOffset(double s, int lane_id)
+{
+	// First find out what lane section 
+	LaneSection *lane_section = GetLaneSectionByS(s);
+	if (lane_section)
+	{
+		return lane_section->GetCenterOffset(s, lane_id);
+	}
+
+	return 0.0;
 }
 
 RoadLink* Road::GetLink(LinkType type)
@@ -983,24 +1933,30 @@ void Road::AddLaneSection(LaneSection *lane_section)
 	lane_section->SetLength(length_ - lane_section->GetS());
 
 	lane_section_.push_back((LaneSection*)lane_section);
+	lane_section_s_.push_back(lane_section->GetS());
 }
 
 Road* OpenDrive::GetRoadById(int id)
 {
-	for (size_t i=0; i<road_.size(); i++)
+	std::unordered_map<int, int>::iterator it = road_idx_by_id_.find(id);
+
+	if (it == road_idx_by_id_.end())
 	{
-		if (road_[i]->GetId() == id)
-		{
-			return road_[i];
-		}
+		return 0;
 	}
-	return 0;
+	return GetRoadByIdx(it->second);
 }
 
 Road *OpenDrive::GetRoadByIdx(int idx)
 {
 	if (idx >= 0 && idx < (int)road_.size())
 	{
+		if (tile_cache_ != 0)
+		{
+			// Load on demand. Consider the tile used until next UpdateTiles(), so that it is not released before.
+			LoadTile(road_tile_[idx]);
+			tile_[road_tile_[idx]].last_used_ = tile_clock_;
+		}
 		return road_[idx];
 	}
 	else
@@ -1012,14 +1968,13 @@ Road *OpenDrive::GetRoadByIdx(int idx)
 
 Junction* OpenDrive::GetJunctionById(int id)
 {
-	for (size_t i=0; i<junction_.size(); i++)
+	std::unordered_map<int, int>::iterator it = junction_idx_by_id_.find(id);
+
+	if (it == junction_idx_by_id_.end())
 	{
-		if (junction_[i]->GetId() == id)
-		{
-			return junction_[i];
-		}
+		return 0;
 	}
-	return 0;
+	return junction_[it->second];
 }
 
 Junction *OpenDrive::GetJunctionByIdx(int idx)
@@ -1035,710 +1990,2747 @@ Junction *OpenDrive::GetJunctionByIdx(int idx)
 	}
 }
 
-OpenDrive::OpenDrive(const char *filename)
+// Compiled road network cache, see OpenDrive::LoadOpenDriveFile()
+#define ODR_CACHE_MAGIC "ESMODRC"
+#define ODR_CACHE_VERSION 7  // step at any change of the cache content, see OpenDriveCache::GetLayout()
+#define ODR_CACHE_ALIGNMENT 8
+
+namespace roadmanager
 {
-	if (!LoadOpenDriveFile(filename))
+	typedef struct
+	{
+		char magic[8];
+		int version;
+		unsigned int layout;            // sizes and member offsets of the binary copied classes, detecting incompatible builds
+		unsigned long long source_hash; // FNV-1a hash of the OpenDRIVE file
+		unsigned long long source_size;
+		unsigned long long data_size;   // number of bytes following the header
+		unsigned long long data_hash;   // for detection of corrupt files, see HashWords()
+	} OpenDriveCacheHeader;
+
+	/**
+	Read only memory mapping of a complete file. Pages are shared between processes mapping the same file.
+	*/
+	class MappedFile
+	{
+	public:
+		MappedFile() : data_(0), size_(0)
+#ifdef _WIN32
+			, file_(INVALID_HANDLE_VALUE), mapping_(0)
+#endif
+		{}
+		~MappedFile() { Close(); }
+
+		bool Open(const char *filename);
+		void Close();
+		const char *GetData() { return data_; }
+		size_t GetSize() { return size_; }
+
+	private:
+		const char *data_;
+		size_t size_;
+#ifdef _WIN32
+		HANDLE file_;
+		HANDLE mapping_;
+#endif
+	};
+
+	/**
+	Serialization of the data structure of a road network. All values are stored in native binary format,
+	trivially copyable classes as a whole. Each block is padded to ODR_CACHE_ALIGNMENT bytes, so that data 
+	can be copied directly from the mapped file.
+	*/
+	class OpenDriveCache
+	{
+	public:
+		static bool Write(OpenDrive *od, const char *filename, unsigned long long source_hash, unsigned long long source_size);
+		static bool Read(OpenDrive *od, const char *filename, unsigned long long source_hash, unsigned long long source_size);
+		static unsigned int GetLayout();
+
+		/**
+		Open cache for tiled loading. Roads are created without content, i.e. only ID, name, length, junction
+		and links, and the content is read on demand by ReadRoadContent(). Junctions and spatial index are 
+		read completely. The cache file stays mapped until the returned object is deleted.
+		@return The opened cache, or 0 if not available or invalid
+		*/
+		static OpenDriveCache *OpenTiled(OpenDrive *od, const char *filename, unsigned long long source_hash, unsigned long long source_size);
+
+		/**
+		Read content, i.e. geometries, elevations, lane offsets and lane sections, of a road created by OpenTiled()
+		@param road_idx Index of the road
+		@param arena Where to allocate road content objects
+		*/
+		bool ReadRoadContent(int road_idx, Arena &arena);
+
+		/**
+		Release content of a road. Objects allocated in arena are released with the arena. 
+		*/
+		static void ReleaseRoadContent(Road *road);
+
+		/**
+		Size of road content in the cache, e.g. as measure of memory usage
+		*/
+		size_t GetRoadContentSize(int road_idx) { return content_size_[road_idx]; }
+
+	private:
+		OpenDriveCache() : read_pos_(0), read_end_(0), ok_(true), od_(0) {}
+
+		bool Open(const char *filename, unsigned long long source_hash, unsigned long long source_size);
+		bool ReadNetwork(OpenDrive *od, bool tiled);
+
+		void WriteData(const void *data, size_t size);
+		template<class T> void WriteValue(const T &value) { WriteData(&value, sizeof(T)); }
+		template<class T, class A> void WriteVector(const std::vector<T, A> &v)
+		{
+			WriteValue((int)v.size());
+			WriteData(v.data(), v.size() * sizeof(T));
+		}
+		template<class T, class A> void WriteObjects(const std::vector<T*, A> &v)
+		{
+			WriteValue((int)v.size());
+			for (size_t i = 0; i < v.size(); i++)
+			{
+				WriteValue(*v[i]);
+			}
+		}
+		template<class A> void WriteString(const std::basic_string<char, std::char_traits<char>, A> &str)
+		{
+			WriteValue((int)str.size());
+			WriteData(str.data(), str.size());
+		}
+		void WriteRoad(Road *road);
+		void WriteRoadContent(Road *road);
+		void WriteLaneSection(LaneSection *lane_section);
+		void WriteLane(Lane *lane);
+		void WriteSpiral(Spiral *spiral);
+
+		const char *ReadData(size_t size);
+		template<class T> void ReadValue(T &value)
+		{
+			const char *data = ReadData(sizeof(T));
+			if (data)
+			{
+				memcpy(&value, data, sizeof(T));
+			}
+		}
+		template<class T, class A> void ReadVector(std::vector<T, A> &v)
+		{
+			int n = ReadCount();
+			const char *data = ReadData(n * sizeof(T));
+			if (data)
+			{
+				v.assign((const T*)data, (const T*)data + n);
+			}
+		}
+		template<class T, class A> void ReadObjects(std::vector<T*, A> &v, Arena &arena)
+		{
+			int n = ReadCount();
+			v.reserve(n);
+			for (int i = 0; i < n && ok_; i++)
+			{
+				const char *data = ReadData(sizeof(T));
+				if (data)
+				{
+					v.push_back(arena.New<T>(*(const T*)data));
+				}
+			}
+		}
+		int ReadCount();
+		template<class A> void ReadString(std::basic_string<char, std::char_traits<char>, A> &str)
+		{
+			int n = ReadCount();
+			const char *data = ReadData(n);
+			if (data)
+			{
+				str.assign(data, n);
+			}
+		}
+		Road *ReadRoad(Arena &arena, bool tiled);
+		void ReadRoadContentData(Road *road, Arena &arena);
+		LaneSection *ReadLaneSection(Arena &arena);
+		Lane *ReadLane(Arena &arena);
+		void ReadSpiral(Spiral *spiral, Arena &arena);
+
+		std::vector<char> buf_;
+		const char *read_pos_;
+		const char *read_end_;
+		bool ok_;  // false on any read out of bounds or inconsistency
+		MappedFile file_;
+		OpenDrive *od_;
+		std::vector<size_t> content_offset_;  // in tiled mode, position of road content in the file
+		std::vector<size_t> content_size_;
+	};
+}
+
+bool MappedFile::Open(const char *filename)
+{
+	Close();
+
+#ifdef _WIN32
+	file_ = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file_ == INVALID_HANDLE_VALUE)
 	{
-		LOG("Error loading OpenDrive %s\n", filename);
-		throw std::invalid_argument("Failed to load OpenDrive file");
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file_, &size) || size.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+	mapping_ = CreateFileMappingA(file_, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping_ == 0)
+	{
+		Close();
+		return false;
+	}
+	data_ = (const char*)MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+	if (data_ == 0)
+	{
+		Close();
+		return false;
+	}
+	size_ = (size_t)size.QuadPart;
+#else
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
 	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		close(fd);
+		return false;
+	}
+	void *data = mmap(0, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);  // the mapping stays valid
+	if (data == MAP_FAILED)
+	{
+		return false;
+	}
+	data_ = (const char*)data;
+	size_ = (size_t)st.st_size;
+#endif
+
+	return true;
 }
 
-bool OpenDrive::LoadOpenDriveFile(const char *filename, bool replace)
+void MappedFile::Close()
 {
-	mt_rand.seed((unsigned int)time(0));
+#ifdef _WIN32
+	if (data_)
+	{
+		UnmapViewOfFile(data_);
+	}
+	if (mapping_)
+	{
+		CloseHandle(mapping_);
+		mapping_ = 0;
+	}
+	if (file_ != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(file_);
+		file_ = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (data_)
+	{
+		munmap((void*)data_, size_);
+	}
+#endif
+	data_ = 0;
+	size_ = 0;
+}
 
-	if (replace)
+/**
+Read a complete file into memory
+@return false if not found or empty
+*/
+static bool ReadFileData(const char *filename, std::vector<char> &data)
+{
+	data.clear();
+	FILE *file = fopen(filename, "rb");
+	if (file == NULL)
 	{
-		for (size_t i=0; i<road_.size(); i++)
-		{
-			delete road_[i];
-		}
-		road_.clear();
+		return false;
+	}
 
-		for (size_t i=0; i<junction_.size(); i++)
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	if (size > 0)
+	{
+		data.resize(size);
+		if (fread(data.data(), size, 1, file) != 1)
 		{
-			delete junction_[i];
+			data.clear();
 		}
-		junction_.clear();
 	}
+	fclose(file);
 
-	pugi::xml_document doc;
+	return data.size() > 0;
+}
+
+static unsigned long long HashData(const char *data, size_t size)
+{
+	// 64 bit FNV-1a
+	unsigned long long hash = 14695981039346656037ULL;
 
-	pugi::xml_parse_result result = doc.load_file(filename);
-	if (!result)
+	for (size_t i = 0; i < size; i++)
 	{
-		throw std::invalid_argument(std::string("Failed to load OpenDRIVE file ") + std::string(filename));
+		hash ^= (unsigned char)data[i];
+		hash *= 1099511628211ULL;
+	}
 
-		return false;
+	return hash;
+}
+
+static unsigned long long HashWords(const char *data, size_t size)
+{
+	// FNV-1a on 64 bit words, fast enough to check the whole cache at every load. Size is a multiple of 8.
+	unsigned long long hash = 14695981039346656037ULL;
+	unsigned long long word;
+
+	for (size_t i = 0; i + sizeof(word) <= size; i += sizeof(word))
+	{
+		memcpy(&word, data + i, sizeof(word));
+		hash ^= word;
+		hash *= 1099511628211ULL;
 	}
 
-	odr_filename_ = filename;
+	return hash;
+}
 
-	pugi::xml_node node = doc.child("OpenDRIVE");
-	if (node == NULL)
+// Offset of a member in its class, also for classes that are not standard layout, e.g. geometries
+template<class T, class M> static int MemberOffset(M T::*member)
+{
+	alignas(T) static char buf[sizeof(T)];
+	return (int)((char*)&(((T*)buf)->*member) - buf);
+}
+
+unsigned int OpenDriveCache::GetLayout()
+{
+	// Any change in size or member placement of the binary copied classes invalidates the cache. 
+	// Changes not affecting the layout, e.g. member types of equal size, require ODR_CACHE_VERSION to be stepped.
+	int layout_values[] = { (int)sizeof(void*), 
+		(int)sizeof(Polynomial), MemberOffset(&Polynomial::a_), MemberOffset(&Polynomial::b_), MemberOffset(&Polynomial::c_), 
+		MemberOffset(&Polynomial::d_), MemberOffset(&Polynomial::s_max_),
+		(int)sizeof(RoadLink), MemberOffset(&RoadLink::type_), MemberOffset(&RoadLink::element_id_), 
+		MemberOffset(&RoadLink::element_type_), MemberOffset(&RoadLink::contact_point_type_),
+		(int)sizeof(Geometry), MemberOffset(&Geometry::s_), MemberOffset(&Geometry::x_), MemberOffset(&Geometry::y_), 
+		MemberOffset(&Geometry::hdg_), MemberOffset(&Geometry::length_), MemberOffset(&Geometry::type_),
+		(int)sizeof(Line), 
+		(int)sizeof(Arc), MemberOffset(&Arc::curvature_),
+		(int)sizeof(Poly3), MemberOffset(&Poly3::poly3_), MemberOffset(&Poly3::umax_),
+		(int)sizeof(ParamPoly3), MemberOffset(&ParamPoly3::poly3U_), MemberOffset(&ParamPoly3::poly3V_), MemberOffset(&ParamPoly3::p_range_),
+		(int)sizeof(Elevation), MemberOffset(&Elevation::poly3_), MemberOffset(&Elevation::s_), MemberOffset(&Elevation::length_),
+		(int)sizeof(LaneOffset), MemberOffset(&LaneOffset::polynomial_), MemberOffset(&LaneOffset::s_), MemberOffset(&LaneOffset::length_),
+		(int)sizeof(LaneLink), MemberOffset(&LaneLink::type_), MemberOffset(&LaneLink::id_),
+		(int)sizeof(LaneWidth), MemberOffset(&LaneWidth::poly3_), MemberOffset(&LaneWidth::s_offset_),
+		(int)sizeof(JunctionLaneLink), MemberOffset(&JunctionLaneLink::from_), MemberOffset(&JunctionLaneLink::to_),
+		(int)sizeof(LaneRoadLaneConnection), MemberOffset(&LaneRoadLaneConnection::contact_point_), 
+		MemberOffset(&LaneRoadLaneConnection::road_id_), MemberOffset(&LaneRoadLaneConnection::lane_id_), 
+		MemberOffset(&LaneRoadLaneConnection::connecting_road_id_), MemberOffset(&LaneRoadLaneConnection::connecting_lane_id_), 
+		MemberOffset(&LaneRoadLaneConnection::turn_), MemberOffset(&LaneRoadLaneConnection::exit_heading_), 
+		MemberOffset(&LaneRoadLaneConnection::turn_angle_),
+		(int)sizeof(SpatialIndex::Entry), MemberOffset(&SpatialIndex::Entry::road_idx_), MemberOffset(&SpatialIndex::Entry::geom_idx_), 
+		MemberOffset(&SpatialIndex::Entry::x_min_), MemberOffset(&SpatialIndex::Entry::y_min_), MemberOffset(&SpatialIndex::Entry::x_max_), 
+		MemberOffset(&SpatialIndex::Entry::y_max_), MemberOffset(&SpatialIndex::Entry::cx_min_), MemberOffset(&SpatialIndex::Entry::cy_min_), 
+		MemberOffset(&SpatialIndex::Entry::cx_max_), MemberOffset(&SpatialIndex::Entry::cy_max_),
+		(int)sizeof(LaneGraph::Node), MemberOffset(&LaneGraph::Node::road_idx_), MemberOffset(&LaneGraph::Node::lane_section_idx_), 
+		MemberOffset(&LaneGraph::Node::lane_id_), MemberOffset(&LaneGraph::Node::length_), MemberOffset(&LaneGraph::Node::x_), 
+		MemberOffset(&LaneGraph::Node::y_), MemberOffset(&LaneGraph::Node::first_edge_),
+		(int)sizeof(LaneGraph::Edge), MemberOffset(&LaneGraph::Edge::to_), MemberOffset(&LaneGraph::Edge::cost_) };
+	unsigned int layout = 0;
+
+	for (size_t i = 0; i < sizeof(layout_values) / sizeof(int); i++)
+	{
+		layout = layout * 31 + (unsigned int)layout_values[i];
+	}
+
+	return layout;
+}
+
+void OpenDriveCache::WriteData(const void *data, size_t size)
+{
+	size_t pos = buf_.size();
+	size_t padded_size = (size + ODR_CACHE_ALIGNMENT - 1) & ~(size_t)(ODR_CACHE_ALIGNMENT - 1);
+
+	buf_.resize(pos + padded_size, 0);
+	if (size > 0)
 	{
-		cout << "Root null" << endl;
-		throw std::invalid_argument("The file does not seem to be an OpenDRIVE");
+		memcpy(&buf_[pos], data, size);
 	}
+}
 
-	for (pugi::xml_node road_node = node.child("road"); road_node; road_node = road_node.next_sibling("road"))
+void OpenDriveCache::WriteSpiral(Spiral *spiral)
+{
+	WriteValue(*(Geometry*)spiral);
+	double values[] = { spiral->curv_start_, spiral->curv_end_, spiral->c_dot_, spiral->x0_, spiral->y0_, spiral->h0_, 
+		spiral->s0_, spiral->backwards_ ? 1.0 : 0.0, spiral->x_end_, spiral->y_end_, spiral->h_end_, spiral->cos_h0_,
+		spiral->sin_h0_, spiral->cos_h_start_, spiral->sin_h_start_, spiral->table_ds_ };
+	WriteValue(values);
+	WriteVector(spiral->table_);
+}
+
+void OpenDriveCache::WriteLane(Lane *lane)
+{
+	WriteValue(lane->id_);
+	WriteValue(lane->type_);
+	WriteValue(lane->level_);
+	WriteValue(lane->offset_from_ref_);
+	WriteObjects(lane->link_);
+	WriteObjects(lane->lane_width_);
+	WriteVector(lane->lane_width_s_);
+}
+
+void OpenDriveCache::WriteLaneSection(LaneSection *lane_section)
+{
+	WriteValue(lane_section->s_);
+	WriteValue(lane_section->length_);
+	WriteValue((int)lane_section->lane_.size());
+	for (size_t i = 0; i < lane_section->lane_.size(); i++)
 	{
-		Road *r = new Road(atoi(road_node.attribute("id").value()), road_node.attribute("name").value());
-		r->SetLength(atof(road_node.attribute("length").value()));
-		r->SetJunction(atoi(road_node.attribute("junction").value()));
+		WriteLane(lane_section->lane_[i]);
+	}
+	WriteVector(lane_section->lane_order_);
+	WriteVector(lane_section->inner_lane_idx_);
+}
 
-		pugi::xml_node link = road_node.child("link");
-		if (link != NULL)
+void OpenDriveCache::WriteRoad(Road *road)
+{
+	WriteValue(road->id_);
+	WriteString(road->name_);
+	WriteValue(road->length_);
+	WriteValue(road->junction_);
+	WriteValue(road->max_curvature_);
+	WriteObjects(road->link_);
+
+	// Content is preceded by its size, so that it can be skipped when reading in tiled mode
+	size_t size_pos = buf_.size();
+	WriteValue((unsigned long long)0);
+	size_t content_pos = buf_.size();
+	WriteRoadContent(road);
+	unsigned long long content_size = buf_.size() - content_pos;
+	memcpy(&buf_[size_pos], &content_size, sizeof(content_size));
+}
+
+void OpenDriveCache::WriteRoadContent(Road *road)
+{
+	WriteValue((int)road->geometry_.size());
+	for (size_t i = 0; i < road->geometry_.size(); i++)
+	{
+		Geometry *geom = road->geometry_[i].GetGeometry();
+		WriteValue(geom->GetType());
+		switch (geom->GetType())
 		{
-			pugi::xml_node successor = link.child("successor");
-			if (successor != NULL)
-			{
-				r->AddLink(new RoadLink(SUCCESSOR, successor));
-			}
-
-			pugi::xml_node predecessor = link.child("predecessor");
-			if (predecessor != NULL)
-			{
-				r->AddLink(new RoadLink(PREDECESSOR, predecessor));
-			}
+		case Geometry::GEOMETRY_TYPE_LINE: WriteValue(*(Line*)geom); break;
+		case Geometry::GEOMETRY_TYPE_ARC: WriteValue(*(Arc*)geom); break;
+		case Geometry::GEOMETRY_TYPE_SPIRAL: WriteSpiral((Spiral*)geom); break;
+		case Geometry::GEOMETRY_TYPE_POLY3: WriteValue(*(Poly3*)geom); break;
+		case Geometry::GEOMETRY_TYPE_PARAM_POLY3: WriteValue(*(ParamPoly3*)geom); break;
+		default: break;
 		}
+	}
 
-		pugi::xml_node plan_view = road_node.child("planView");
-		if (plan_view != NULL)
-		{
-			for (pugi::xml_node geometry = plan_view.child("geometry"); geometry; geometry = geometry.next_sibling())
-			{
-				double s = atof(geometry.attribute("s").value());
-				double x = atof(geometry.attribute("x").value());
-				double y = atof(geometry.attribute("y").value());
-				double hdg = atof(geometry.attribute("hdg").value());
-				double length = atof(geometry.attribute("length").value());
+	WriteObjects(road->elevation_profile_);
+	WriteObjects(road->lane_offset_);
+	WriteValue((int)road->lane_section_.size());
+	for (size_t i = 0; i < road->lane_section_.size(); i++)
+	{
+		WriteLaneSection(road->lane_section_[i]);
+	}
 
-				pugi::xml_node type = geometry.last_child();
-				if (type != NULL)
-				{
-					// Find out the type of geometry
-					if (!strcmp(type.name(), "line"))
-					{
-						r->AddLine(new Line(s, x, y, hdg, length));
-					}
-					else if (!strcmp(type.name(), "arc"))
-					{
-						double curvature = atof(type.attribute("curvature").value());
-						r->AddArc(new Arc(s, x, y, hdg, length, curvature));
-					}
-					else if (!strcmp(type.name(), "spiral"))
-					{
-						double curv_start = atof(type.attribute("curvStart").value());
-						double curv_end = atof(type.attribute("curvEnd").value());
-						r->AddSpiral(new Spiral(s, x, y, hdg, length, curv_start, curv_end));
-					}
-					else if (!strcmp(type.name(), "poly3"))
-					{
-						double a = atof(type.attribute("a").value());
-						double b = atof(type.attribute("b").value());
-						double c = atof(type.attribute("c").value());
-						double d = atof(type.attribute("d").value());
-						r->AddPoly3(new Poly3(s, x, y, hdg, length, a, b, c, d));
-					}
-					else if (!strcmp(type.name(), "paramPoly3"))
-					{
-						double aU = atof(type.attribute("aU").value());
-						double bU = atof(type.attribute("bU").value());
-						double cU = atof(type.attribute("cU").value());
-						double dU = atof(type.attribute("dU").value());
-						double aV = atof(type.attribute("aV").value());
-						double bV = atof(type.attribute("bV").value());
-						double cV = atof(type.attribute("cV").value());
-						double dV = atof(type.attribute("dV").value());
-						ParamPoly3::PRangeType p_range = ParamPoly3::P_RANGE_NORMALIZED;
-						
-						pugi::xml_attribute attr = type.attribute("pRange");
-						if (attr && !strcmp(attr.value(), "arcLength"))
-						{
-							p_range = ParamPoly3::P_RANGE_ARC_LENGTH;
-						}
+	WriteVector(road->geometry_s_);
+	WriteVector(road->elevation_s_);
+	WriteVector(road->lane_section_s_);
+	WriteVector(road->lane_offset_s_);
+}
 
-						ParamPoly3 *pp3 = new ParamPoly3(s, x, y, hdg, length, aU, bU, cU, dU, aV, bV, cV, dV, p_range);
-						if (pp3 != NULL)
-						{
-							r->AddParamPoly3(pp3);
-						}
-						else
-						{
-							LOG("ParamPoly3: Major error\n");
-						}
-					}
-					else
-					{
-						cout << "Unknown geometry type: " << type.name() << endl;
-					}
-				}
-				else
-				{
-					cout << "Type == NULL" << endl;
-				}
-			}
-		}
-		
-		pugi::xml_node elevation_profile = road_node.child("elevationProfile");
-		if (elevation_profile != NULL)
-		{
-			for (pugi::xml_node elevation = elevation_profile.child("elevation"); elevation; elevation = elevation.next_sibling())
-			{
-				double s = atof(elevation.attribute("s").value());
-				double a = atof(elevation.attribute("a").value());
-				double b = atof(elevation.attribute("b").value());
-				double c = atof(elevation.attribute("c").value());
-				double d = atof(elevation.attribute("d").value());
+bool OpenDriveCache::Write(OpenDrive *od, const char *filename, unsigned long long source_hash, unsigned long long source_size)
+{
+	OpenDriveCache cache;
 
-				Elevation *ep = new Elevation(s, a, b, c, d);
-				if (ep != NULL)
-				{
-					r->AddElevation(ep);
-				}
-				else
-				{
-					LOG("Elevation: Major error\n");
-				}
-			}
-		}
-		
-		pugi::xml_node lanes = road_node.child("lanes");
-		if (lanes != NULL)
-		{
-			for (pugi::xml_node_iterator child = lanes.children().begin(); child != lanes.children().end(); child++)
-			{
-				if (!strcmp(child->name(), "laneOffset"))
-				{
-					double s = atof(child->attribute("s").value());
-					double a = atof(child->attribute("a").value());
-					double b = atof(child->attribute("b").value());
-					double c = atof(child->attribute("c").value());
-					double d = atof(child->attribute("d").value());
-					r->AddLaneOffset(new LaneOffset(s, a, b, c, d));
-				}
-				else if (!strcmp(child->name(), "laneSection"))
-				{
-					double s = atof(child->attribute("s").value());
-					LaneSection *lane_section = new LaneSection(s);
-					r->AddLaneSection(lane_section);
+	cache.WriteValue((int)od->road_.size());
+	for (size_t i = 0; i < od->road_.size(); i++)
+	{
+		cache.WriteRoad(od->road_[i]);
+	}
 
-					for (pugi::xml_node_iterator child2 = child->children().begin(); child2 != child->children().end(); child2++)
-					{
-						if (!strcmp(child2->name(), "left"))
-						{
-							//LOG("Lane left\n");
-						}
-						else if (!strcmp(child2->name(), "right"))
-						{
-							//LOG("Lane right\n");
-						}
-						else if (!strcmp(child2->name(), "center"))
-						{
-							//LOG("Lane center\n");
-						}
-						else
-						{
-							LOG("Unsupported lane side: %s\n", child2->name());
-							continue;
-						}
-						for (pugi::xml_node_iterator lane_node = child2->children().begin(); lane_node != child2->children().end(); lane_node++)
-						{
-							if (strcmp(lane_node->name(), "lane"))
-							{
-								LOG("Unexpected element: %s, expected \"lane\"\n", lane_node->name());
-								continue;
-							}
+	cache.WriteValue((int)od->junction_.size());
+	for (size_t i = 0; i < od->junction_.size(); i++)
+	{
+		Junction *junction = od->junction_[i];
+		cache.WriteValue(junction->id_);
+		cache.WriteString(junction->name_);
+		cache.WriteValue((int)junction->connection_.size());
+		for (size_t j = 0; j < junction->connection_.size(); j++)
+		{
+			// Refer to roads by index
+			Connection *connection = junction->connection_[j];
+			cache.WriteValue(connection->incoming_road_ ? od->GetTrackIdxById(connection->incoming_road_->GetId()) : -1);
+			cache.WriteValue(connection->connecting_road_ ? od->GetTrackIdxById(connection->connecting_road_->GetId()) : -1);
+			cache.WriteValue(connection->contact_point_);
+			cache.WriteVector(connection->lane_link_);
+		}
+		cache.WriteVector(junction->lane_connection_);
+	}
+
+	SpatialIndex *index = &od->spatial_index_;
+	cache.WriteVector(index->entry_);
+	cache.WriteVector(index->road_entry_idx_);
+	cache.WriteVector(index->cell_start_);
+	cache.WriteVector(index->cell_entry_);
+	cache.WriteValue(index->x0_);
+	cache.WriteValue(index->y0_);
+	cache.WriteValue(index->cell_size_);
+	cache.WriteValue(index->nx_);
+	cache.WriteValue(index->ny_);
+
+	LaneGraph *graph = &od->lane_graph_;
+	cache.WriteVector(graph->node_);
+	cache.WriteVector(graph->edge_);
+	cache.WriteVector(graph->road_node_idx_);
+	cache.WriteValue(graph->heuristic_scale_);
+
+	OpenDriveCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	strncpy(header.magic, ODR_CACHE_MAGIC, sizeof(header.magic));
+	header.version = ODR_CACHE_VERSION;
+	header.layout = GetLayout();
+	header.source_hash = source_hash;
+	header.source_size = source_size;
+	header.data_size = cache.buf_.size();
+	header.data_hash = HashWords(cache.buf_.data(), cache.buf_.size());
+
+	// Write to a temporary file first, so that other processes never see a partially written cache
+	std::string tmp_filename = std::string(filename) + "." + std::to_string((unsigned long long)time(0)) + 
+		"." + std::to_string((unsigned long long)(size_t)&cache) + ".tmp";
+	FILE *file = fopen(tmp_filename.c_str(), "wb");
+	if (file == NULL)
+	{
+		LOG("Failed to create road network cache file %s\n", filename);
+		return false;
+	}
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1 && 
+		(cache.buf_.size() == 0 || fwrite(cache.buf_.data(), cache.buf_.size(), 1, file) == 1);
+	ok = (fclose(file) == 0) && ok;
 
-							Lane::LaneType lane_type = Lane::LANE_TYPE_NONE;
-							if (lane_node->attribute("type") == 0 || !strcmp(lane_node->attribute("type").value(), ""))
-							{
-								LOG("Lane type error");
-							}
-							if (!strcmp(lane_node->attribute("type").value(), "none"))
-							{
-								lane_type = Lane::LANE_TYPE_NONE;
-							}
-							else  if (!strcmp(lane_node->attribute("type").value(), "driving"))
-							{
-								lane_type = Lane::LANE_TYPE_DRIVING;
-							}
-							else if (!strcmp(lane_node->attribute("type").value(), "stop"))
-							{
-								lane_type = Lane::LANE_TYPE_STOP;
-							}
-							else if (!strcmp(lane_node->attribute("type").value(), "shoulder"))
-							{
-								lane_type = Lane::LANE_TYPE_SHOULDER;
-							}
-							else if (!strcmp(lane_node->attribute("type").value(), "biking"))
-							{
-								lane_type = Lane::LANE_TYPE_BIKING;
-							}
-							else if (!strcmp(lane_node->attribute("type").value(), "sidewalk"))
-							{
-								lane_type = Lane::LANE_TYPE_SIDEWALK;
-							}
-							else if (!strcmp(lane_node->attribute("type").value(), "border"))
-							{
-								lane_type = Lane::LANE_TYPE_BORDER;
-							}
-							else if (!strcmp(lane_node->attribute("type").value(), "restricted"))
-							{
-								lane_type = Lane::LANE_TYPE_RESTRICTED;
-							}
-							else if (!strcmp(lane_node->attribute("type").value(), "parking"))
-							{
-								lane_type = Lane::LANE_TYPE_PARKING;
-							}
-							else if (!strcmp(lane_node->attribute("type").value(), "bidirectional"))
-							{
-								lane_type = Lane::LANE_TYPE_BIDIRECTIONAL;
-							}
-							else if (!strcmp(lane_node->attribute("type").value(), "medcian"))
-							{
-								lane_type = Lane::LANE_TYPE_MEDIAN;
-							}
-							else if (!strcmp(lane_node->attribute("type").value(), "special1"))
-							{
-								lane_type = Lane::LANE_TYPE_SPECIAL1;
-							}
-							else if (!strcmp(lane_node->attribute("type").value(), "special2"))
-							{
-								lane_type = Lane::LANE_TYPE_SPECIAL2;
-							}
-							else if (!strcmp(lane_node->attribute("type").value(), "special3"))
-							{
-								lane_type = Lane::LANE_TYPE_SPECIAL3;
-							}
-							else if (!strcmp(lane_node->attribute("type").value(), "roadmarks"))
-							{
-								lane_type = Lane::LANE_TYPE_ROADMARKS;
-							}
-							else if (!strcmp(lane_node->attribute("type").value(), "tram"))
-							{
-								lane_type = Lane::LANE_TYPE_TRAM;
-							}
-							else if (!strcmp(lane_node->attribute("type").value(), "rail"))
-							{
-								lane_type = Lane::LANE_TYPE_RAIL;
-							}
-							else if (!strcmp(lane_node->attribute("type").value(), "entry") ||
-								!strcmp(lane_node->attribute("type").value(), "mwyEntry"))
-							{
-								lane_type = Lane::LANE_TYPE_ENTRY;
-							}
-							else if (!strcmp(lane_node->attribute("type").value(), "exit") ||
-								!strcmp(lane_node->attribute("type").value(), "mwyExit"))
-							{
-								lane_type = Lane::LANE_TYPE_EXIT;
-							}
-							else if (!strcmp(lane_node->attribute("type").value(), "offRamp"))
-							{
-								lane_type = Lane::LANE_TYPE_OFF_RAMP;
-							}
-							else if (!strcmp(lane_node->attribute("type").value(), "onRamp"))
+	if (ok)
+	{
+		remove(filename);  // rename does not replace existing files on all platforms
+		ok = rename(tmp_filename.c_str(), filename) == 0;
+	}
+	if (!ok)
+	{
+		LOG("Failed to write road network cache file %s\n", filename);
+		remove(tmp_filename.c_str());
+	}
+
+	return ok;
+}
+
+const char *OpenDriveCache::ReadData(size_t size)
+{
+	size_t padded_size = (size + ODR_CACHE_ALIGNMENT - 1) & ~(size_t)(ODR_CACHE_ALIGNMENT - 1);
+
+	if (!ok_ || padded_size > (size_t)(read_end_ - read_pos_))
+	{
+		ok_ = false;
+		return 0;
+	}
+	const char *data = read_pos_;
+	read_pos_ += padded_size;
+
+	return data;
+}
+
+int OpenDriveCache::ReadCount()
+{
+	int n = 0;
+	ReadValue(n);
+	if (n < 0 || (size_t)n > (size_t)(read_end_ - read_pos_))
+	{
+		// Each element occupies at least one byte, i.e. more than remaining bytes is not possible
+		ok_ = false;
+		return 0;
+	}
+
+	return n;
+}
+
+void OpenDriveCache::ReadSpiral(Spiral *spiral, Arena &arena)
+{
+	ReadValue(*(Geometry*)spiral);
+	double values[16];
+	ReadValue(values);
+	spiral->curv_start_ = values[0];
+	spiral->curv_end_ = values[1];
+	spiral->c_dot_ = values[2];
+	spiral->x0_ = values[3];
+	spiral->y0_ = values[4];
+	spiral->h0_ = values[5];
+	spiral->s0_ = values[6];
+	spiral->backwards_ = values[7] != 0.0;
+	spiral->x_end_ = values[8];
+	spiral->y_end_ = values[9];
+	spiral->h_end_ = values[10];
+	spiral->cos_h0_ = values[11];
+	spiral->sin_h0_ = values[12];
+	spiral->cos_h_start_ = values[13];
+	spiral->sin_h_start_ = values[14];
+	spiral->table_ds_ = values[15];
+	spiral->table_ = ArenaVector<double>(&arena);
+	ReadVector(spiral->table_);
+}
+
+Lane *OpenDriveCache::ReadLane(Arena &arena)
+{
+	Lane *lane = arena.New<Lane>(0, Lane::LANE_TYPE_NONE, &arena);
+
+	ReadValue(lane->id_);
+	ReadValue(lane->type_);
+	ReadValue(lane->level_);
+	ReadValue(lane->offset_from_ref_);
+	ReadObjects(lane->link_, arena);
+	ReadObjects(lane->lane_width_, arena);
+	ReadVector(lane->lane_width_s_);
+
+	return lane;
+}
+
+LaneSection *OpenDriveCache::ReadLaneSection(Arena &arena)
+{
+	LaneSection *lane_section = arena.New<LaneSection>(0.0, &arena);
+
+	ReadValue(lane_section->s_);
+	ReadValue(lane_section->length_);
+	int n = ReadCount();
+	lane_section->lane_.reserve(n);
+	for (int i = 0; i < n && ok_; i++)
+	{
+		lane_section->lane_.push_back(ReadLane(arena));
+	}
+	ReadVector(lane_section->lane_order_);
+	ReadVector(lane_section->inner_lane_idx_);
+
+	if (lane_section->lane_order_.size() != lane_section->lane_.size() || 
+		lane_section->inner_lane_idx_.size() != lane_section->lane_.size())
+	{
+		ok_ = false;
+	}
+
+	return lane_section;
+}
+
+Road *OpenDriveCache::ReadRoad(Arena &arena, bool tiled)
+{
+	Road *road = arena.New<Road>(0, "", &arena);
+
+	ReadValue(road->id_);
+	ReadString(road->name_);
+	ReadValue(road->length_);
+	ReadValue(road->junction_);
+	ReadValue(road->max_curvature_);
+	ReadObjects(road->link_, arena);
+
+	unsigned long long content_size = 0;
+	ReadValue(content_size);
+	if (!ok_ || content_size > (unsigned long long)(read_end_ - read_pos_))
+	{
+		ok_ = false;
+		return road;
+	}
+
+	if (tiled)
+	{
+		// Skip content, just register where to find it
+		content_offset_.push_back((size_t)(read_pos_ - file_.GetData()));
+		content_size_.push_back((size_t)content_size);
+		read_pos_ += content_size;
+	}
+	else
+	{
+		const char *content_pos = read_pos_;
+		ReadRoadContentData(road, arena);
+		if (read_pos_ != content_pos + content_size)
+		{
+			ok_ = false;
+		}
+	}
+
+	return road;
+}
+
+void OpenDriveCache::ReadRoadContentData(Road *road, Arena &arena)
+{
+	// In tiled mode the road is created in the network arena, while its content goes to the tile arena
+	road->geometry_ = ArenaVector<GeometryRecord>(&arena);
+	road->elevation_profile_ = ArenaVector<Elevation*>(&arena);
+	road->lane_section_ = ArenaVector<LaneSection*>(&arena);
+	road->lane_offset_ = ArenaVector<LaneOffset*>(&arena);
+	road->geometry_s_ = ArenaVector<double>(&arena);
+	road->elevation_s_ = ArenaVector<double>(&arena);
+	road->lane_section_s_ = ArenaVector<double>(&arena);
+	road->lane_offset_s_ = ArenaVector<double>(&arena);
+
+	int n = ReadCount();
+	road->geometry_.reserve(n);
+	for (int i = 0; i < n && ok_; i++)
+	{
+		Geometry::GeometryType type = Geometry::GEOMETRY_TYPE_UNKNOWN;
+		ReadValue(type);
+		const char *data = 0;
+		switch (type)
+		{
+		case Geometry::GEOMETRY_TYPE_LINE: 
+			if ((data = ReadData(sizeof(Line))) != 0) road->geometry_.push_back(GeometryRecord(*(const Line*)data));
+			break;
+		case Geometry::GEOMETRY_TYPE_ARC: 
+			if ((data = ReadData(sizeof(Arc))) != 0) road->geometry_.push_back(GeometryRecord(*(const Arc*)data));
+			break;
+		case Geometry::GEOMETRY_TYPE_SPIRAL:
+			road->geometry_.push_back(GeometryRecord(Spiral(0, 0, 0, 0, 0, 0, 0)));
+			ReadSpiral((Spiral*)road->geometry_.back().GetGeometry(), arena);
+			break;
+		case Geometry::GEOMETRY_TYPE_POLY3: 
+			if ((data = ReadData(sizeof(Poly3))) != 0) road->geometry_.push_back(GeometryRecord(*(const Poly3*)data));
+			break;
+		case Geometry::GEOMETRY_TYPE_PARAM_POLY3: 
+			if ((data = ReadData(sizeof(ParamPoly3))) != 0) road->geometry_.push_back(GeometryRecord(*(const ParamPoly3*)data));
+			break;
+		default: 
+			ok_ = false;
+		}
+	}
+
+	ReadObjects(road->elevation_profile_, arena);
+	ReadObjects(road->lane_offset_, arena);
+	n = ReadCount();
+	road->lane_section_.reserve(n);
+	for (int i = 0; i < n && ok_; i++)
+	{
+		road->lane_section_.push_back(ReadLaneSection(arena));
+	}
+
+	ReadVector(road->geometry_s_);
+	ReadVector(road->elevation_s_);
+	ReadVector(road->lane_section_s_);
+	ReadVector(road->lane_offset_s_);
+
+	if (road->geometry_s_.size() != road->geometry_.size() || road->elevation_s_.size() != road->elevation_profile_.size() ||
+		road->lane_section_s_.size() != road->lane_section_.size() || road->lane_offset_s_.size() != road->lane_offset_.size())
+	{
+		ok_ = false;
+	}
+}
+
+bool OpenDriveCache::ReadRoadContent(int road_idx, Arena &arena)
+{
+	Road *road = od_->road_[road_idx];
+
+	read_pos_ = file_.GetData() + content_offset_[road_idx];
+	read_end_ = read_pos_ + content_size_[road_idx];
+	ok_ = true;
+	ReadRoadContentData(road, arena);
+
+	if (!ok_ || read_pos_ != read_end_)
+	{
+		LOG("Failed to read road %d from road network cache\n", road->GetId());
+		ReleaseRoadContent(road);
+		return false;
+	}
+
+	return true;
+}
+
+void OpenDriveCache::ReleaseRoadContent(Road *road)
+{
+	// Replace by empty vectors, the memory is released with the arena it was read into
+	road->geometry_ = ArenaVector<GeometryRecord>();
+	road->elevation_profile_ = ArenaVector<Elevation*>();
+	road->lane_section_ = ArenaVector<LaneSection*>();
+	road->lane_offset_ = ArenaVector<LaneOffset*>();
+	road->geometry_s_ = ArenaVector<double>();
+	road->elevation_s_ = ArenaVector<double>();
+	road->lane_section_s_ = ArenaVector<double>();
+	road->lane_offset_s_ = ArenaVector<double>();
+}
+
+bool OpenDriveCache::Open(const char *filename, unsigned long long source_hash, unsigned long long source_size)
+{
+	MappedFile &file = file_;
+
+	if (!file.Open(filename))
+	{
+		return false;
+	}
+
+	OpenDriveCacheHeader header;
+	if (file.GetSize() < sizeof(header))
+	{
+		LOG("Road network cache %s is corrupt, ignored\n", filename);
+		return false;
+	}
+	memcpy(&header, file.GetData(), sizeof(header));
+
+	if (strncmp(header.magic, ODR_CACHE_MAGIC, sizeof(header.magic)) || header.version != ODR_CACHE_VERSION || 
+		header.layout != GetLayout() || header.data_size != file.GetSize() - sizeof(header))
+	{
+		LOG("Road network cache %s is of incompatible format, ignored\n", filename);
+		return false;
+	}
+	if (header.source_hash != source_hash || header.source_size != source_size)
+	{
+		// OpenDRIVE file has changed since the cache was written
+		return false;
+	}
+	if (header.data_hash != HashWords(file.GetData() + sizeof(header), header.data_size))
+	{
+		LOG("Road network cache %s is corrupt, ignored\n", filename);
+		return false;
+	}
+
+	read_pos_ = file.GetData() + sizeof(header);
+	read_end_ = read_pos_ + header.data_size;
+
+	return true;
+}
+
+bool OpenDriveCache::Read(OpenDrive *od, const char *filename, unsigned long long source_hash, unsigned long long source_size)
+{
+	OpenDriveCache cache;
+
+	if (!cache.Open(filename, source_hash, source_size))
+	{
+		return false;
+	}
+
+	if (!cache.ReadNetwork(od, false))
+	{
+		LOG("Road network cache %s is corrupt, ignored\n", filename);
+		return false;
+	}
+
+	return true;
+}
+
+OpenDriveCache *OpenDriveCache::OpenTiled(OpenDrive *od, const char *filename, unsigned long long source_hash, unsigned long long source_size)
+{
+	OpenDriveCache *cache = new OpenDriveCache;
+
+	if (!cache->Open(filename, source_hash, source_size))
+	{
+		delete cache;
+		return 0;
+	}
+
+	if (!cache->ReadNetwork(od, true))
+	{
+		LOG("Road network cache %s is corrupt, ignored\n", filename);
+		delete cache;
+		return 0;
+	}
+
+	return cache;
+}
+
+bool OpenDriveCache::ReadNetwork(OpenDrive *od, bool tiled)
+{
+	od_ = od;
+
+	int n = ReadCount();
+	od->road_.reserve(n);
+	for (int i = 0; i < n && ok_; i++)
+	{
+		Road *road = ReadRoad(od->arena_, tiled);
+		od->road_idx_by_id_.insert(std::make_pair(road->GetId(), (int)od->road_.size()));
+		od->road_.push_back(road);
+		od->max_curvature_ = MAX(od->max_curvature_, road->max_curvature_);
+	}
+
+	n = ReadCount();
+	od->junction_.reserve(n);
+	for (int i = 0; i < n && ok_; i++)
+	{
+		int id = 0;
+		std::string name;
+		ReadValue(id);
+		ReadString(name);
+		Junction *junction = od->arena_.New<Junction>(id, name, &od->arena_);
+
+		int n_connections = ReadCount();
+		for (int j = 0; j < n_connections && ok_; j++)
+		{
+			int incoming_road_idx = -1;
+			int connecting_road_idx = -1;
+			ContactPointType contact_point = CONTACT_POINT_UNKNOWN;
+			ReadValue(incoming_road_idx);
+			ReadValue(connecting_road_idx);
+			ReadValue(contact_point);
+			if (incoming_road_idx >= (int)od->road_.size() || connecting_road_idx >= (int)od->road_.size())
+			{
+				ok_ = false;
+				break;
+			}
+			Connection *connection = od->arena_.New<Connection>(
+				incoming_road_idx < 0 ? (Road*)0 : od->road_[incoming_road_idx], 
+				connecting_road_idx < 0 ? (Road*)0 : od->road_[connecting_road_idx], contact_point, &od->arena_);
+			ReadVector(connection->lane_link_);
+			junction->AddConnection(connection);
+		}
+		ReadVector(junction->lane_connection_);
+		od->junction_idx_by_id_.insert(std::make_pair(junction->GetId(), (int)od->junction_.size()));
+		od->junction_.push_back(junction);
+	}
+
+	SpatialIndex *index = &od->spatial_index_;
+	ReadVector(index->entry_);
+	ReadVector(index->road_entry_idx_);
+	ReadVector(index->cell_start_);
+	ReadVector(index->cell_entry_);
+	ReadValue(index->x0_);
+	ReadValue(index->y0_);
+	ReadValue(index->cell_size_);
+	ReadValue(index->nx_);
+	ReadValue(index->ny_);
+
+	LaneGraph *graph = &od->lane_graph_;
+	ReadVector(graph->node_);
+	ReadVector(graph->edge_);
+	ReadVector(graph->road_node_idx_);
+	ReadValue(graph->heuristic_scale_);
+
+	if (!ok_ || read_pos_ != read_end_ || index->road_entry_idx_.size() != od->road_.size() ||
+		index->cell_start_.size() != (index->entry_.size() == 0 ? 0 : (size_t)index->nx_ * index->ny_ + 1) ||
+		graph->road_node_idx_.size() != od->road_.size() || graph->node_.size() == 0 || 
+		graph->node_.back().first_edge_ != (int)graph->edge_.size())
+	{
+		return false;
+	}
+
+	return true;
+}
+
+OpenDrive::OpenDrive(const char *filename) : random_seed_(0), random_seed_set_(false), loader_threads_(1), closest_point_tolerance_(CLOSEST_POINT_TOLERANCE),
+	max_curvature_(0), tile_cache_(0), tile_memory_budget_(0), tile_clock_(0)
+{
+	if (!LoadOpenDriveFile(filename))
+	{
+		LOG("Error loading OpenDrive %s\n", filename);
+		throw std::invalid_argument("Failed to load OpenDrive file");
+	}
+}
+
+bool OpenDrive::LoadOpenDriveFile(const char *filename, bool replace)
+{
+	random_mutex_.lock();
+	random_generator_.seed(random_seed_set_ ? random_seed_ : (unsigned int)time(0));
+	random_mutex_.unlock();
+
+	if (replace)
+	{
+		Clear();
+	}
+	else if (tile_cache_ != 0)
+	{
+		// Adding roads to a tiled road network, turn it into a plain one by loading all tiles
+		for (size_t i = 0; i < tile_.size(); i++)
+		{
+			LoadTile((int)i);
+		}
+		delete tile_cache_;
+		tile_cache_ = 0;
+		tile_.clear();
+		road_tile_.clear();
+		tile_idx_by_cell_.clear();
+	}
+
+	// Read the complete file, for identification of corresponding cache and for XML parsing
+	std::vector<char> data;
+	ReadFileData(filename, data);
+
+	// Cache covers a complete road network, hence only applicable when not adding to existing roads 
+	std::string cache_filename = GetCacheFilename(filename);
+	bool use_cache = !cache_filename.empty() && road_.size() == 0 && junction_.size() == 0 && data.size() > 0;
+	unsigned long long source_hash = use_cache ? HashData(data.data(), data.size()) : 0;
+
+	if (use_cache)
+	{
+		if (OpenDriveCache::Read(this, cache_filename.c_str(), source_hash, data.size()))
+		{
+			odr_filename_ = filename;
+			return true;
+		}
+
+		// Discard anything read from an invalid cache
+		Clear();
+	}
+
+	pugi::xml_document doc;
+
+	pugi::xml_parse_result result = doc.load_buffer(data.data(), data.size());
+	if (data.size() == 0 || !result)
+	{
+		throw std::invalid_argument(std::string("Failed to load OpenDRIVE file ") + std::string(filename));
+
+		return false;
+	}
+
+	odr_filename_ = filename;
+
+	pugi::xml_node node = doc.child("OpenDRIVE");
+	if (node == NULL)
+	{
+		cout << "Root null" << endl;
+		throw std::invalid_argument("The file does not seem to be an OpenDRIVE");
+	}
+
+	// Build roads, in parallel if requested. Each road is built independently of others.
+	std::vector<pugi::xml_node> road_nodes;
+	for (pugi::xml_node road_node = node.child("road"); road_node; road_node = road_node.next_sibling("road"))
+	{
+		road_nodes.push_back(road_node);
+	}
+	std::vector<Road*> roads(road_nodes.size(), (Road*)0);
+	
+	if (loader_threads_ > 1 && road_nodes.size() > 1)
+	{
+		LoadRoadsParallel(road_nodes, roads);
+	}
+	else
+	{
+		for (size_t i = 0; i < road_nodes.size(); i++)
+		{
+			roads[i] = LoadRoad(road_nodes[i], arena_);
+		}
+	}
+
+	// Register roads in file order
+	for (size_t i = 0; i < roads.size(); i++)
+	{
+		Road *r = roads[i];
+		if (r == 0)
+		{
+			return false;
+		}
+
+		// In case of duplicate IDs, e.g. when adding roads from multiple files, first one found is used
+		road_idx_by_id_.insert(std::make_pair(r->GetId(), (int)road_.size()));
+		road_.push_back(r);
+		max_curvature_ = MAX(max_curvature_, r->GetMaxCurvature());
+	}
+
+	size_t first_new_junction = junction_.size();
+	for (pugi::xml_node junction_node = node.child("junction"); junction_node; junction_node = junction_node.next_sibling("junction"))
+	{
+		int id = atoi(junction_node.attribute("id").value());
+		std::string name = junction_node.attribute("name").value();
+
+		Junction *j = arena_.New<Junction>(id, name, &arena_);
+
+		for (pugi::xml_node connection_node = junction_node.child("connection"); connection_node; connection_node = connection_node.next_sibling("connection"))
+		{
+			if (connection_node != NULL)
+			{
+				int id = atoi(connection_node.attribute("id").value());
+				(void)id;
+				int incoming_road_id = atoi(connection_node.attribute("incomingRoad").value());
+				int connecting_road_id = atoi(connection_node.attribute("connectingRoad").value());
+				Road *incoming_road = GetRoadById(incoming_road_id);
+				Road *connecting_road = GetRoadById(connecting_road_id);
+				ContactPointType contact_point = CONTACT_POINT_UNKNOWN;
+				std::string contact_point_str = connection_node.attribute("contactPoint").value();
+				if (contact_point_str == "start")
+				{
+					contact_point = CONTACT_POINT_START;
+				}
+				else if (contact_point_str == "end")
+				{
+					contact_point = CONTACT_POINT_END;
+				}
+				else
+				{
+					LOG("Unsupported contact point: %s\n", contact_point_str.c_str());
+				}
+
+				Connection *connection = arena_.New<Connection>(incoming_road, connecting_road, contact_point, &arena_);
+
+				for (pugi::xml_node lane_link_node = connection_node.child("laneLink"); lane_link_node; lane_link_node = lane_link_node.next_sibling("laneLink"))
+				{
+					int from_id = atoi(lane_link_node.attribute("from").value());
+					int to_id = atoi(lane_link_node.attribute("to").value());
+					connection->AddJunctionLaneLink(from_id, to_id);
+				}
+				j->AddConnection(connection);
+			}
+		}
+		junction_idx_by_id_.insert(std::make_pair(j->GetId(), (int)junction_.size()));
+		junction_.push_back(j);
+	}
+
+	spatial_index_.Build(this);
+
+	for (size_t i = first_new_junction; i < junction_.size(); i++)
+	{
+		junction_[i]->BuildConnectionTable(this);
+	}
+
+	lane_graph_.Build(this);
+
+	if (use_cache)
+	{
+		OpenDriveCache::Write(this, cache_filename.c_str(), source_hash, data.size());
+	}
+
+	return true;
+}
+
+std::string OpenDrive::GetCacheFilename(const char *filename)
+{
+	if (cache_dir_.empty())
+	{
+		return "";
+	}
+
+	std::string name = filename;
+	size_t pos = name.find_last_of("\\/");
+
+	return cache_dir_ + "/" + (pos == std::string::npos ? name : name.substr(pos + 1)) + ".cache";
+}
+
+bool OpenDrive::LoadOpenDriveFileTiled(const char *filename, double tile_size)
+{
+	random_mutex_.lock();
+	random_generator_.seed(random_seed_set_ ? random_seed_ : (unsigned int)time(0));
+	random_mutex_.unlock();
+	Clear();
+
+	std::vector<char> data;
+	if (!ReadFileData(filename, data))
+	{
+		LOG("Failed to read OpenDRIVE file %s\n", filename);
+		return false;
+	}
+
+	std::string cache_filename = GetCacheFilename(filename);
+	if (cache_filename.empty())
+	{
+		LOG("No road network cache directory set, loading complete road network instead\n");
+		return LoadOpenDriveFile(filename);
+	}
+	unsigned long long source_hash = HashData(data.data(), data.size());
+
+	if ((tile_cache_ = OpenDriveCache::OpenTiled(this, cache_filename.c_str(), source_hash, data.size())) == 0)
+	{
+		// Compile the cache by a complete load, then open it tiled
+		Clear();
+		if (!LoadOpenDriveFile(filename))
+		{
+			return false;
+		}
+
+		Clear();
+		if ((tile_cache_ = OpenDriveCache::OpenTiled(this, cache_filename.c_str(), source_hash, data.size())) == 0)
+		{
+			LOG("Failed to create road network cache %s, loading complete road network instead\n", cache_filename.c_str());
+			Clear();
+			return LoadOpenDriveFile(filename);
+		}
+	}
+
+	odr_filename_ = filename;
+	BuildTiles(tile_size);
+
+	return true;
+}
+
+/**
+Key of a tile grid cell, for lookup of tiles
+*/
+static long long GetTileKey(long long cx, long long cy)
+{
+	return (long long)(((unsigned long long)cx << 32) ^ (unsigned int)cy);
+}
+
+void OpenDrive::BuildTiles(double tile_size)
+{
+	tile_size_ = tile_size;
+	tile_margin_ = 0;
+	road_tile_.resize(road_.size());
+
+	for (int i = 0; i < (int)road_.size(); i++)
+	{
+		// Bounding box of the road, from its geometry entries of the spatial index
+		int first = spatial_index_.GetEntryIdx(i, 0);
+		int last = i < (int)road_.size() - 1 ? spatial_index_.GetEntryIdx(i + 1, 0) : spatial_index_.GetNumberOfEntries();
+		double x_min = 0;
+		double y_min = 0;
+		double x_max = 0;
+		double y_max = 0;
+
+		for (int j = first; j < last; j++)
+		{
+			SpatialIndex::Entry *entry = spatial_index_.GetEntry(j);
+			x_min = j == first ? entry->x_min_ : MIN(x_min, entry->x_min_);
+			y_min = j == first ? entry->y_min_ : MIN(y_min, entry->y_min_);
+			x_max = j == first ? entry->x_max_ : MAX(x_max, entry->x_max_);
+			y_max = j == first ? entry->y_max_ : MAX(y_max, entry->y_max_);
+		}
+
+		// Road belongs to the tile containing the center of its bounding box
+		long long cx = (long long)floor((x_min + x_max) / (2 * tile_size_));
+		long long cy = (long long)floor((y_min + y_max) / (2 * tile_size_));
+		std::unordered_map<long long, int>::iterator it = tile_idx_by_cell_.find(GetTileKey(cx, cy));
+		if (it == tile_idx_by_cell_.end())
+		{
+			Tile tile;
+			tile.arena_ = 0;
+			tile.loaded_ = false;
+			tile.size_ = 0;
+			tile.last_used_ = 0;
+			tile.x_min_ = x_min;
+			tile.y_min_ = y_min;
+			tile.x_max_ = x_max;
+			tile.y_max_ = y_max;
+			it = tile_idx_by_cell_.insert(std::make_pair(GetTileKey(cx, cy), (int)tile_.size())).first;
+			tile_.push_back(tile);
+		}
+
+		Tile *tile = &tile_[it->second];
+		tile->road_idx_.push_back(i);
+		tile->size_ += tile_cache_->GetRoadContentSize(i);
+		tile->x_min_ = MIN(tile->x_min_, x_min);
+		tile->y_min_ = MIN(tile->y_min_, y_min);
+		tile->x_max_ = MAX(tile->x_max_, x_max);
+		tile->y_max_ = MAX(tile->y_max_, y_max);
+		road_tile_[i] = it->second;
+
+		// Keep track of how far roads extend outside the grid cell of their tile
+		tile_margin_ = MAX(tile_margin_, MAX(cx * tile_size_ - tile->x_min_, tile->x_max_ - (cx + 1) * tile_size_));
+		tile_margin_ = MAX(tile_margin_, MAX(cy * tile_size_ - tile->y_min_, tile->y_max_ - (cy + 1) * tile_size_));
+	}
+
+	for (size_t i = 0; i < tile_.size(); i++)
+	{
+		// Content of a tile is typically somewhat larger in memory than in the cache
+		tile_[i].arena_ = arena_.New<Arena>(MIN((size_t)ARENA_BLOCK_SIZE, MAX((size_t)1024, tile_[i].size_)));
+	}
+}
+
+bool OpenDrive::LoadTile(int tile_idx)
+{
+	Tile *tile = &tile_[tile_idx];
+
+	if (tile->loaded_)
+	{
+		return true;
+	}
+
+	// Make room within the budget first, so that also loads on demand respect it
+	ReleaseUnusedTiles(tile->size_);
+
+	bool result = true;
+	for (size_t i = 0; i < tile->road_idx_.size(); i++)
+	{
+		if (!tile_cache_->ReadRoadContent(tile->road_idx_[i], *tile->arena_))
+		{
+			result = false;
+		}
+	}
+
+	// Mark as loaded also on failure, not to retry over and over again
+	tile->loaded_ = true;
+
+	return result;
+}
+
+void OpenDrive::ReleaseTile(int tile_idx)
+{
+	Tile *tile = &tile_[tile_idx];
+
+	for (size_t i = 0; i < tile->road_idx_.size(); i++)
+	{
+		OpenDriveCache::ReleaseRoadContent(road_[tile->road_idx_[i]]);
+	}
+	tile->arena_->Clear();
+	tile->loaded_ = false;
+}
+
+void OpenDrive::UpdateTiles(int n, const double *x, const double *y, double radius)
+{
+	if (tile_cache_ == 0)
+	{
+		return;
+	}
+
+	tile_clock_++;
+
+	for (int i = 0; i < n; i++)
+	{
+		// Look up grid cells within reach, unless more than the tiles themselves
+		long long cx_min = (long long)floor((x[i] - radius - tile_margin_) / tile_size_);
+		long long cx_max = (long long)floor((x[i] + radius + tile_margin_) / tile_size_);
+		long long cy_min = (long long)floor((y[i] - radius - tile_margin_) / tile_size_);
+		long long cy_max = (long long)floor((y[i] + radius + tile_margin_) / tile_size_);
+		std::vector<int> candidates;
+
+		if ((double)(cx_max - cx_min + 1) * (cy_max - cy_min + 1) > tile_.size())
+		{
+			for (int j = 0; j < (int)tile_.size(); j++)
+			{
+				candidates.push_back(j);
+			}
+		}
+		else
+		{
+			for (long long cx = cx_min; cx <= cx_max; cx++)
+			{
+				for (long long cy = cy_min; cy <= cy_max; cy++)
+				{
+					std::unordered_map<long long, int>::iterator it = tile_idx_by_cell_.find(GetTileKey(cx, cy));
+					if (it != tile_idx_by_cell_.end())
+					{
+						candidates.push_back(it->second);
+					}
+				}
+			}
+		}
+
+		for (size_t j = 0; j < candidates.size(); j++)
+		{
+			Tile *tile = &tile_[candidates[j]];
+			double dx = MAX(0, MAX(tile->x_min_ - x[i], x[i] - tile->x_max_));
+			double dy = MAX(0, MAX(tile->y_min_ - y[i], y[i] - tile->y_max_));
+
+			if (dx * dx + dy * dy <= radius * radius)
+			{
+				LoadTile(candidates[j]);
+				tile->last_used_ = tile_clock_;
+			}
+		}
+	}
+
+	ReleaseUnusedTiles(0);
+}
+
+void OpenDrive::ReleaseUnusedTiles(size_t size)
+{
+	if (tile_memory_budget_ == 0)
+	{
+		return;
+	}
+
+	// Release least recently used tiles, not in use since last UpdateTiles(), until within budget
+	size_t usage = GetTileMemoryUsage();
+	if (usage + size <= tile_memory_budget_)
+	{
+		return;
+	}
+
+	std::vector<std::pair<unsigned long long, int> > unused;
+	for (int i = 0; i < (int)tile_.size(); i++)
+	{
+		if (tile_[i].loaded_ && tile_[i].last_used_ < tile_clock_)
+		{
+			unused.push_back(std::make_pair(tile_[i].last_used_, i));
+		}
+	}
+	std::sort(unused.begin(), unused.end());
+
+	for (size_t i = 0; i < unused.size() && usage + size > tile_memory_budget_; i++)
+	{
+		usage -= tile_[unused[i].second].size_;
+		ReleaseTile(unused[i].second);
+	}
+}
+
+size_t OpenDrive::GetTileMemoryUsage()
+{
+	size_t usage = 0;
+
+	for (size_t i = 0; i < tile_.size(); i++)
+	{
+		if (tile_[i].loaded_)
+		{
+			usage += tile_[i].size_;
+		}
+	}
+
+	return usage;
+}
+
+int OpenDrive::GetNumberOfLoadedTiles()
+{
+	int counter = 0;
+
+	for (size_t i = 0; i < tile_.size(); i++)
+	{
+		if (tile_[i].loaded_)
+		{
+			counter++;
+		}
+	}
+
+	return counter;
+}
+
+void OpenDrive::Clear()
+{
+	delete tile_cache_;
+	tile_cache_ = 0;
+	tile_.clear();
+	road_tile_.clear();
+	tile_idx_by_cell_.clear();
+	road_.clear();
+	road_idx_by_id_.clear();
+	max_curvature_ = 0;
+	junction_.clear();
+	junction_idx_by_id_.clear();
+	spatial_index_.Clear();
+	lane_graph_.Clear();
+	arena_.Clear();
+}
+
+Road *OpenDrive::LoadRoad(pugi::xml_node road_node, Arena &arena)
+{
+	Road *r = arena.New<Road>(atoi(road_node.attribute("id").value()), road_node.attribute("name").value(), &arena);
+	r->SetLength(atof(road_node.attribute("length").value()));
+	r->SetJunction(atoi(road_node.attribute("junction").value()));
+
+	pugi::xml_node link = road_node.child("link");
+	if (link != NULL)
+	{
+		pugi::xml_node successor = link.child("successor");
+		if (successor != NULL)
+		{
+			r->AddLink(arena.New<RoadLink>(SUCCESSOR, successor));
+		}
+
+		pugi::xml_node predecessor = link.child("predecessor");
+		if (predecessor != NULL)
+		{
+			r->AddLink(arena.New<RoadLink>(PREDECESSOR, predecessor));
+		}
+	}
+
+	pugi::xml_node plan_view = road_node.child("planView");
+	if (plan_view != NULL)
+	{
+		for (pugi::xml_node geometry = plan_view.child("geometry"); geometry; geometry = geometry.next_sibling())
+		{
+			double s = atof(geometry.attribute("s").value());
+			double x = atof(geometry.attribute("x").value());
+			double y = atof(geometry.attribute("y").value());
+			double hdg = atof(geometry.attribute("hdg").value());
+			double length = atof(geometry.attribute("length").value());
+
+			pugi::xml_node type = geometry.last_child();
+			if (type != NULL)
+			{
+				// Find out the type of geometry
+				if (!strcmp(type.name(), "line"))
+				{
+					r->AddLine(Line(s, x, y, hdg, length));
+				}
+				else if (!strcmp(type.name(), "arc"))
+				{
+					double curvature = atof(type.attribute("curvature").value());
+					r->AddArc(Arc(s, x, y, hdg, length, curvature));
+				}
+				else if (!strcmp(type.name(), "spiral"))
+				{
+					double curv_start = atof(type.attribute("curvStart").value());
+					double curv_end = atof(type.attribute("curvEnd").value());
+					r->AddSpiral(Spiral(s, x, y, hdg, length, curv_start, curv_end));
+				}
+				else if (!strcmp(type.name(), "poly3"))
+				{
+					double a = atof(type.attribute("a").value());
+					double b = atof(type.attribute("b").value());
+					double c = atof(type.attribute("c").value());
+					double d = atof(type.attribute("d").value());
+					r->AddPoly3(Poly3(s, x, y, hdg, length, a, b, c, d));
+				}
+				else if (!strcmp(type.name(), "paramPoly3"))
+				{
+					double aU = atof(type.attribute("aU").value());
+					double bU = atof(type.attribute("bU").value());
+					double cU = atof(type.attribute("cU").value());
+					double dU = atof(type.attribute("dU").value());
+					double aV = atof(type.attribute("aV").value());
+					double bV = atof(type.attribute("bV").value());
+					double cV = atof(type.attribute("cV").value());
+					double dV = atof(type.attribute("dV").value());
+					ParamPoly3::PRangeType p_range = ParamPoly3::P_RANGE_NORMALIZED;
+					
+					pugi::xml_attribute attr = type.attribute("pRange");
+					if (attr && !strcmp(attr.value(), "arcLength"))
+					{
+						p_range = ParamPoly3::P_RANGE_ARC_LENGTH;
+					}
+
+					r->AddParamPoly3(ParamPoly3(s, x, y, hdg, length, aU, bU, cU, dU, aV, bV, cV, dV, p_range));
+				}
+				else
+				{
+					cout << "Unknown geometry type: " << type.name() << endl;
+				}
+			}
+			else
+			{
+				cout << "Type == NULL" << endl;
+			}
+		}
+	}
+	
+	pugi::xml_node elevation_profile = road_node.child("elevationProfile");
+	if (elevation_profile != NULL)
+	{
+		for (pugi::xml_node elevation = elevation_profile.child("elevation"); elevation; elevation = elevation.next_sibling())
+		{
+			double s = atof(elevation.attribute("s").value());
+			double a = atof(elevation.attribute("a").value());
+			double b = atof(elevation.attribute("b").value());
+			double c = atof(elevation.attribute("c").value());
+			double d = atof(elevation.attribute("d").value());
+
+			Elevation *ep = arena.New<Elevation>(s, a, b, c, d);
+			if (ep != NULL)
+			{
+				r->AddElevation(ep);
+			}
+			else
+			{
+				LOG("Elevation: Major error\n");
+			}
+		}
+	}
+	
+	pugi::xml_node lanes = road_node.child("lanes");
+	if (lanes != NULL)
+	{
+		for (pugi::xml_node_iterator child = lanes.children().begin(); child != lanes.children().end(); child++)
+		{
+			if (!strcmp(child->name(), "laneOffset"))
+			{
+				double s = atof(child->attribute("s").value());
+				double a = atof(child->attribute("a").value());
+				double b = atof(child->attribute("b").value());
+				double c = atof(child->attribute("c").value());
+				double d = atof(child->attribute("d").value());
+				r->AddLaneOffset(arena.New<LaneOffset>(s, a, b, c, d));
+			}
+			else if (!strcmp(child->name(), "laneSection"))
+			{
+				double s = atof(child->attribute("s").value());
+				LaneSection *lane_section = arena.New<LaneSection>(s, &arena);
+				r->AddLaneSection(lane_section);
+
+				for (pugi::xml_node_iterator child2 = child->children().begin(); child2 != child->children().end(); child2++)
+				{
+					if (!strcmp(child2->name(), "left"))
+					{
+						//LOG("Lane left\n");
+					}
+					else if (!strcmp(child2->name(), "right"))
+					{
+						//LOG("Lane right\n");
+					}
+					else if (!strcmp(child2->name(), "center"))
+					{
+						//LOG("Lane center\n");
+					}
+					else
+					{
+						LOG("Unsupported lane side: %s\n", child2->name());
+						continue;
+					}
+					for (pugi::xml_node_iterator lane_node = child2->children().begin(); lane_node != child2->children().end(); lane_node++)
+					{
+						if (strcmp(lane_node->name(), "lane"))
+						{
+							LOG("Unexpected element: %s, expected \"lane\"\n", lane_node->name());
+							continue;
+						}
+
+						Lane::LaneType lane_type = Lane::LANE_TYPE_NONE;
+						if (lane_node->attribute("type") == 0 || !strcmp(lane_node->attribute("type").value(), ""))
+						{
+							LOG("Lane type error");
+						}
+						if (!strcmp(lane_node->attribute("type").value(), "none"))
+						{
+							lane_type = Lane::LANE_TYPE_NONE;
+						}
+						else  if (!strcmp(lane_node->attribute("type").value(), "driving"))
+						{
+							lane_type = Lane::LANE_TYPE_DRIVING;
+						}
+						else if (!strcmp(lane_node->attribute("type").value(), "stop"))
+						{
+							lane_type = Lane::LANE_TYPE_STOP;
+						}
+						else if (!strcmp(lane_node->attribute("type").value(), "shoulder"))
+						{
+							lane_type = Lane::LANE_TYPE_SHOULDER;
+						}
+						else if (!strcmp(lane_node->attribute("type").value(), "biking"))
+						{
+							lane_type = Lane::LANE_TYPE_BIKING;
+						}
+						else if (!strcmp(lane_node->attribute("type").value(), "sidewalk"))
+						{
+							lane_type = Lane::LANE_TYPE_SIDEWALK;
+						}
+						else if (!strcmp(lane_node->attribute("type").value(), "border"))
+						{
+							lane_type = Lane::LANE_TYPE_BORDER;
+						}
+						else if (!strcmp(lane_node->attribute("type").value(), "restricted"))
+						{
+							lane_type = Lane::LANE_TYPE_RESTRICTED;
+						}
+						else if (!strcmp(lane_node->attribute("type").value(), "parking"))
+						{
+							lane_type = Lane::LANE_TYPE_PARKING;
+						}
+						else if (!strcmp(lane_node->attribute("type").value(), "bidirectional"))
+						{
+							lane_type = Lane::LANE_TYPE_BIDIRECTIONAL;
+						}
+						else if (!strcmp(lane_node->attribute("type").value(), "medcian"))
+						{
+							lane_type = Lane::LANE_TYPE_MEDIAN;
+						}
+						else if (!strcmp(lane_node->attribute("type").value(), "special1"))
+						{
+							lane_type = Lane::LANE_TYPE_SPECIAL1;
+						}
+						else if (!strcmp(lane_node->attribute("type").value(), "special2"))
+						{
+							lane_type = Lane::LANE_TYPE_SPECIAL2;
+						}
+						else if (!strcmp(lane_node->attribute("type").value(), "special3"))
+						{
+							lane_type = Lane::LANE_TYPE_SPECIAL3;
+						}
+						else if (!strcmp(lane_node->attribute("type").value(), "roadmarks"))
+						{
+							lane_type = Lane::LANE_TYPE_ROADMARKS;
+						}
+						else if (!strcmp(lane_node->attribute("type").value(), "tram"))
+						{
+							lane_type = Lane::LANE_TYPE_TRAM;
+						}
+						else if (!strcmp(lane_node->attribute("type").value(), "rail"))
+						{
+							lane_type = Lane::LANE_TYPE_RAIL;
+						}
+						else if (!strcmp(lane_node->attribute("type").value(), "entry") ||
+							!strcmp(lane_node->attribute("type").value(), "mwyEntry"))
+						{
+							lane_type = Lane::LANE_TYPE_ENTRY;
+						}
+						else if (!strcmp(lane_node->attribute("type").value(), "exit") ||
+							!strcmp(lane_node->attribute("type").value(), "mwyExit"))
+						{
+							lane_type = Lane::LANE_TYPE_EXIT;
+						}
+						else if (!strcmp(lane_node->attribute("type").value(), "offRamp"))
+						{
+							lane_type = Lane::LANE_TYPE_OFF_RAMP;
+						}
+						else if (!strcmp(lane_node->attribute("type").value(), "onRamp"))
+						{
+							lane_type = Lane::LANE_TYPE_ON_RAMP;
+						}
+						else
+						{
+							LOG("unknown lane type: %s (road id=%d)\n", lane_node->attribute("type").value(), r->GetId());
+						}
+
+						int lane_id = atoi(lane_node->attribute("id").value());
+						Lane *lane = arena.New<Lane>(lane_id, lane_type, &arena);
+						if (lane == NULL)
+						{
+							LOG("Error: creating lane\n");
+							return 0;
+						}
+						lane_section->AddLane(lane);
+
+						// Link
+						pugi::xml_node link = lane_node->child("link");
+						if (link != NULL)
+						{
+							pugi::xml_node successor = link.child("successor");
+							if (successor != NULL)
 							{
-								lane_type = Lane::LANE_TYPE_ON_RAMP;
+								lane->AddLink(arena.New<LaneLink>(SUCCESSOR, atoi(successor.attribute("id").value())));
 							}
-							else
+							pugi::xml_node predecessor = link.child("predecessor");
+							if (predecessor != NULL)
 							{
-								LOG("unknown lane type: %s (road id=%d)\n", lane_node->attribute("type").value(), r->GetId());
+								lane->AddLink(arena.New<LaneLink>(PREDECESSOR, atoi(predecessor.attribute("id").value())));
 							}
+						}
+
+						// Width
+						for (pugi::xml_node width = lane_node->child("width"); width; width = width.next_sibling("width"))
+						{
+							double s_offset = atof(width.attribute("sOffset").value());
+							double a = atof(width.attribute("a").value());
+							double b = atof(width.attribute("b").value());
+							double c = atof(width.attribute("c").value());
+							double d = atof(width.attribute("d").value());
+							lane->AddLaneWIdth(arena.New<LaneWidth>(s_offset, a, b, c, d));
+						}
+					}
+				}
+			}
+			else
+			{
+				LOG("Unsupported lane type: %s\n", child->name());
+			}
+		}
+	}
+
+	if (r->GetNumberOfLaneSections() == 0)
+	{
+		// Add empty center reference lane
+		LaneSection *lane_section = arena.New<LaneSection>(0.0, &arena);
+		lane_section->AddLane(arena.New<Lane>(0, Lane::LANE_TYPE_NONE, &arena));
+		r->AddLaneSection(lane_section);
+	}
+
+	return r;
+}
+
+typedef struct
+{
+	OpenDrive *od;
+	std::vector<pugi::xml_node> *road_nodes;
+	std::vector<Road*> *roads;
+	std::atomic<int> *next_idx;
+	Arena *arena;  // each thread has its own arena, since arena allocation is not thread safe
+} RoadLoaderThreadData;
+
+void OpenDrive::LoadRoadsThread(void *arg)
+{
+	RoadLoaderThreadData *data = (RoadLoaderThreadData*)arg;
+
+	// Pick roads one by one, balancing the load between threads. Result is stored by index, hence 
+	// independent of which thread that built it.
+	for (int i = (*data->next_idx)++; i < (int)data->road_nodes->size(); i = (*data->next_idx)++)
+	{
+		(*data->roads)[i] = data->od->LoadRoad((*data->road_nodes)[i], *data->arena);
+	}
+}
+
+void OpenDrive::LoadRoadsParallel(std::vector<pugi::xml_node> &road_nodes, std::vector<Road*> &roads)
+{
+	int n_threads = MIN(loader_threads_, (int)road_nodes.size());
+	std::vector<RoadLoaderThreadData> data(n_threads);
+	std::vector<std::thread> thread;  // joined below, SE_Thread::Wait() may time out on some platforms
+	std::atomic<int> next_idx(0);
+
+	for (int i = 0; i < n_threads; i++)
+	{
+		data[i].od = this;
+		data[i].road_nodes = &road_nodes;
+		data[i].roads = &roads;
+		data[i].next_idx = &next_idx;
+		data[i].arena = arena_.New<Arena>();  // lives as long as the road network, like the roads in it
+		thread.push_back(std::thread(LoadRoadsThread, &data[i]));
+	}
+
+	for (int i = 0; i < n_threads; i++)
+	{
+		thread[i].join();
+	}
+}
+
+Connection::Connection(Road* incoming_road, Road *connecting_road, ContactPointType contact_point, Arena *arena) : lane_link_(arena)
+{
+	// Find corresponding road objects
+	incoming_road_ = incoming_road;
+	connecting_road_ = connecting_road;
+	contact_point_ = contact_point;
+}
+
+void Connection::AddJunctionLaneLink(int from, int to)
+{
+	lane_link_.push_back(JunctionLaneLink(from, to));
+}
+
+int Connection::GetConnectingLaneId(int incoming_lane_id)
+{
+	for (size_t i = 0; i < lane_link_.size(); i++)
+	{
+		if (lane_link_[i].from_ == incoming_lane_id)
+		{
+			return lane_link_[i].to_;
+		}
+	}
+	return 0;
+}
+
+void Connection::Print()
+{
+	LOG("Connection: incoming %d connecting %d\n", incoming_road_->GetId(), connecting_road_->GetId());
+	for (size_t i = 0; i < lane_link_.size(); i++)
+	{
+		lane_link_[i].Print();
+	}
+}
+
+// Comparison of lane connections by incoming road and lane, for ordering and lookup of the connection table
+static bool LaneConnectionLess(LaneRoadLaneConnection a, LaneRoadLaneConnection b)
+{
+	return a.GetRoadId() < b.GetRoadId() || (a.GetRoadId() == b.GetRoadId() && a.GetLaneId() < b.GetLaneId());
+}
+
+void Junction::BuildConnectionTable(OpenDrive *od)
+{
+	lane_connection_.clear();
+
+	for (int i = 0; i < GetNumberOfConnections(); i++)
+	{
+		Connection *connection = GetConnectionByIdx(i);
+		if (connection->GetIncomingRoad() == 0 || connection->GetConnectingRoad() == 0)
+		{
+			LOG("Junction::BuildConnectionTable junction %d connection %d missing road\n", id_, i);
+			continue;
+		}
+		Road *connecting_road = od->GetRoadById(connection->GetConnectingRoad()->GetId());
+
+		// Heading at start and end of the connecting road reference line
+		Position test_pos(od);
+		test_pos.SetLanePos(connecting_road->GetId(), 0, 0, 0);
+		double h_start = test_pos.GetH();
+		test_pos.SetLanePos(connecting_road->GetId(), 0, connecting_road->GetLength(), 0);
+		double h_end = test_pos.GetH();
+
+		double exit_heading = connection->GetContactPoint() == CONTACT_POINT_END ? h_start : h_end;
+		double turn_angle = connection->GetContactPoint() == CONTACT_POINT_END ? h_start - h_end : h_end - h_start;
+		turn_angle = fmod(turn_angle + 3 * M_PI, 2 * M_PI) - M_PI;  // normalize into [-pi, pi)
+
+		for (int j = 0; j < connection->GetNumberOfLaneLinks(); j++)
+		{
+			JunctionLaneLink *lane_link = connection->GetLaneLink(j);
+			LaneRoadLaneConnection lane_connection(lane_link->from_, connecting_road->GetId(), lane_link->to_);
+
+			lane_connection.SetRoad(connection->GetIncomingRoad()->GetId());
+			lane_connection.contact_point_ = connection->GetContactPoint();
+			lane_connection.exit_heading_ = exit_heading;
+			lane_connection.turn_angle_ = turn_angle;
+			if (fabs(turn_angle) < JUNCTION_STRAIGHT_MAX_ANGLE)
+			{
+				lane_connection.turn_ = LaneRoadLaneConnection::TURN_STRAIGHT;
+			}
+			else
+			{
+				lane_connection.turn_ = turn_angle > 0 ? LaneRoadLaneConnection::TURN_LEFT : LaneRoadLaneConnection::TURN_RIGHT;
+			}
 
-							int lane_id = atoi(lane_node->attribute("id").value());
-							Lane *lane = new Lane(lane_id, lane_type);
-							if (lane == NULL)
-							{
-								LOG("Error: creating lane\n");
-								return false;
-							}
-							lane_section->AddLane(lane);
+			// find out driving direction
+			int laneSectionId;
+			if (lane_link->to_ < 0)
+			{
+				laneSectionId = 0;
+			}
+			else
+			{
+				laneSectionId = connecting_road->GetNumberOfLaneSections() - 1;
+			}
+			LaneSection *lane_section = connecting_road->GetLaneSectionByIdx(laneSectionId);
+			Lane *lane = lane_section ? lane_section->GetLaneById(lane_link->to_) : 0;
+			if (lane && !lane->IsDriving())
+			{
+				LOG("Junction::BuildConnectionTable target lane not driving! from %d, %d to %d, %d\n",
+					connection->GetIncomingRoad()->GetId(), lane_link->from_, connecting_road->GetId(), lane_link->to_);
+			}
 
-							// Link
-							pugi::xml_node link = lane_node->child("link");
-							if (link != NULL)
-							{
-								pugi::xml_node successor = link.child("successor");
-								if (successor != NULL)
-								{
-									lane->AddLink(new LaneLink(SUCCESSOR, atoi(successor.attribute("id").value())));
-								}
-								pugi::xml_node predecessor = link.child("predecessor");
-								if (predecessor != NULL)
-								{
-									lane->AddLink(new LaneLink(PREDECESSOR, atoi(predecessor.attribute("id").value())));
-								}
-							}
+			lane_connection_.push_back(lane_connection);
+		}
+	}
 
-							// Width
-							for (pugi::xml_node width = lane_node->child("width"); width; width = width.next_sibling("width"))
-							{
-								double s_offset = atof(width.attribute("sOffset").value());
-								double a = atof(width.attribute("a").value());
-								double b = atof(width.attribute("b").value());
-								double c = atof(width.attribute("c").value());
-								double d = atof(width.attribute("d").value());
-								lane->AddLaneWIdth(new LaneWidth(s_offset, a, b, c, d));
-							}
-						}
-					}
-				}
-				else
-				{
-					LOG("Unsupported lane type: %s\n", child->name());
-				}
-			}
+	// Order by incoming road and lane, keeping the order of connections and lane links
+	std::stable_sort(lane_connection_.begin(), lane_connection_.end(), LaneConnectionLess);
+}
+
+LaneRoadLaneConnection *Junction::GetRoadConnections(int roadId, int laneId, int &n_connections)
+{
+	LaneRoadLaneConnection key(laneId, -1, 0);
+	key.SetRoad(roadId);
+
+	ArenaVector<LaneRoadLaneConnection>::iterator first = 
+		std::lower_bound(lane_connection_.begin(), lane_connection_.end(), key, LaneConnectionLess);
+	ArenaVector<LaneRoadLaneConnection>::iterator last = 
+		std::upper_bound(first, lane_connection_.end(), key, LaneConnectionLess);
+
+	n_connections = (int)(last - first);
+
+	return n_connections > 0 ? &(*first) : 0;
+}
+
+int Junction::GetNumberOfRoadConnections(int roadId, int laneId)
+{
+	int n_connections = 0;
+
+	GetRoadConnections(roadId, laneId, n_connections);
+
+	return n_connections;
+}
+
+LaneRoadLaneConnection Junction::GetRoadConnectionByIdx(int roadId, int laneId, int idx)
+{
+	int n_connections = 0;
+	LaneRoadLaneConnection *lane_connection = GetRoadConnections(roadId, laneId, n_connections);
+
+	if (idx < 0 || idx >= n_connections)
+	{
+		return LaneRoadLaneConnection();
+	}
+
+	return lane_connection[idx];
+}
+
+int Junction::GetRoadConnectionIdxByTurn(int roadId, int laneId, LaneRoadLaneConnection::TurnType turn)
+{
+	int n_connections = 0;
+	LaneRoadLaneConnection *lane_connection = GetRoadConnections(roadId, laneId, n_connections);
+	double target_angle = turn == LaneRoadLaneConnection::TURN_LEFT ? M_PI_2 : (turn == LaneRoadLaneConnection::TURN_RIGHT ? -M_PI_2 : 0);
+	double min_diff = std::numeric_limits<double>::infinity();
+	int best_idx = -1;
+
+	for (int i = 0; i < n_connections; i++)
+	{
+		if (lane_connection[i].GetTurnType() == turn && fabs(lane_connection[i].GetTurnAngle() - target_angle) < min_diff)
+		{
+			min_diff = fabs(lane_connection[i].GetTurnAngle() - target_angle);
+			best_idx = i;
+		}
+	}
+
+	return best_idx;
+}
+
+void Junction::Print()
+{
+	LOG("Junction %d %s: \n", id_, name_.c_str());
+
+	for (size_t i=0; i<connection_.size(); i++)
+	{
+		connection_[i]->Print();
+	}
+}
+
+void *Arena::Allocate(size_t size, size_t alignment)
+{
+	size_t offset = (used_ + alignment - 1) & ~(alignment - 1);
+
+	if (block_.size() == 0 || offset + size > block_size_)
+	{
+		// Start a new block. Oversized requests get a block of their own.
+		block_.push_back(new char[MAX(size, block_size_)]);
+		offset = 0;
+	}
+	used_ = offset + size;
+	size_ += size;
+
+	return block_.back() + offset;
+}
+
+void Arena::Clear()
+{
+	for (DtorEntry *entry = dtor_list_; entry != 0; entry = entry->next_)
+	{
+		entry->dtor_(entry->obj_);
+	}
+	dtor_list_ = 0;
+
+	for (size_t i = 0; i < block_.size(); i++)
+	{
+		delete[] block_[i];
+	}
+	block_.clear();
+	used_ = block_size_;
+	size_ = 0;
+}
+
+void OpenDrive::SetRandomSeed(unsigned int seed)
+{
+	std::lock_guard<std::mutex> lock(random_mutex_);
+	random_seed_ = seed;
+	random_seed_set_ = true;
+	random_generator_.seed(seed);
+}
+
+unsigned int OpenDrive::DrawRandomSeed()
+{
+	std::lock_guard<std::mutex> lock(random_mutex_);
+	return (unsigned int)random_generator_();
+}
+
+OpenDrive::~OpenDrive()
+{
+	// All road network elements are released with the arena
+	delete tile_cache_;
+}
+
+int OpenDrive::GetTrackIdxById(int id)
+{
+	std::unordered_map<int, int>::iterator it = road_idx_by_id_.find(id);
+
+	if (it != road_idx_by_id_.end())
+	{
+		return it->second;
+	}
+	LOG("OpenDrive::GetTrackIdxById Error: Road id %d not found\n", id);
+	return -1;
+}
+
+int OpenDrive::GetTrackIdByIdx(int idx)
+{
+	if (idx >= 0 && idx < (int)road_.size())
+	{
+		return (road_[idx]->GetId());
+	}
+	LOG("OpenDrive::GetTrackIdByIdx: idx %d out of range [0:%d]\n", idx, (int)road_.size());
+	return 0;
+}
+
+/**
+Distance from entry of the lane graph node containing a position, in driving direction, to the position
+@return Distance, or -1 if the position is not in a driving lane
+*/
+static double GetLaneGraphNodeProgress(OpenDrive *od, Position *pos, int &node_idx)
+{
+	int road_idx = od->GetTrackIdxById(pos->GetTrackId());
+	Road *road = od->GetRoadByIdx(road_idx);
+
+	node_idx = -1;
+	if (road == 0)
+	{
+		return -1;
+	}
+
+	int lane_section_idx = road->GetLaneSectionIdxByS(pos->GetS());
+	LaneSection *lane_section = road->GetLaneSectionByIdx(lane_section_idx);
+	if (lane_section == 0 || (node_idx = od->GetLaneGraph()->GetNodeIdx(road_idx, lane_section_idx, pos->GetLaneId())) < 0)
+	{
+		return -1;
+	}
+
+	if (pos->GetLaneId() < 0)
+	{
+		return pos->GetS() - lane_section->GetS();
+	}
+	else
+	{
+		return lane_section->GetS() + lane_section->GetLength() - pos->GetS();
+	}
+}
+
+double OpenDrive::FindRoute(Position *from, Position *to, Route *route)
+{
+	int from_node = -1;
+	int to_node = -1;
+	double from_progress = GetLaneGraphNodeProgress(this, from, from_node);
+	double to_progress = GetLaneGraphNodeProgress(this, to, to_node);
+
+	if (from_node < 0 || to_node < 0)
+	{
+		LOG("OpenDrive::FindRoute Error: Position not in a driving lane (%d, %d) -> (%d, %d)\n",
+			from->GetTrackId(), from->GetLaneId(), to->GetTrackId(), to->GetLaneId());
+		return -1;
+	}
+
+	std::vector<int> path;
+	double length;
+
+	if (from_node == to_node && to_progress >= from_progress)
+	{
+		// Destination ahead in the same lane section
+		path.push_back(from_node);
+		length = to_progress - from_progress;
+	}
+	else if ((length = lane_graph_.FindPath(from_node, to_node, path, to_progress < from_progress && 
+		lane_graph_.GetNode(from_node)->road_idx_ == lane_graph_.GetNode(to_node)->road_idx_ &&
+		lane_graph_.GetNode(from_node)->lane_section_idx_ == lane_graph_.GetNode(to_node)->lane_section_idx_)) < 0)
+	{
+		LOG("OpenDrive::FindRoute No route found (%d, %d) -> (%d, %d)\n",
+			from->GetTrackId(), from->GetLaneId(), to->GetTrackId(), to->GetLaneId());
+		return -1;
+	}
+	else
+	{
+		length += to_progress - from_progress;
+	}
+
+	// Start of the last road along the path
+	size_t last_road_start = path.size() - 1;
+	while (last_road_start > 0 && lane_graph_.GetNode(path[last_road_start - 1])->road_idx_ == lane_graph_.GetNode(path.back())->road_idx_)
+	{
+		last_road_start--;
+	}
+
+	// One waypoint per road. Start and destination positions on first and last road, else entry of the lane. 
+	// Waypoints are not added by Route::AddWaypoint(), since its validation by IsConnected() assumes one lane 
+	// per road and junctions passed by connecting roads in their own direction. The path is connected already, 
+	// each step following a lane link, junction connection or lane change of the lane graph.
+	Position *pos = new Position(*from);
+	pos->SetRoute(0);
+	route->waypoint_.push_back(pos);
+	for (size_t i = 1; i < path.size(); i++)
+	{
+		LaneGraph::Node *node = lane_graph_.GetNode(path[i]);
+
+		if (node->road_idx_ == lane_graph_.GetNode(path[i - 1])->road_idx_)
+		{
+			continue;
 		}
 
-		if (r->GetNumberOfLaneSections() == 0)
+		if (i == last_road_start)
 		{
-			// Add empty center reference lane
-			LaneSection *lane_section = new LaneSection(0.0);
-			lane_section->AddLane(new Lane(0, Lane::LANE_TYPE_NONE));
-			r->AddLaneSection(lane_section);
+			pos = new Position(*to);
+			pos->SetRoute(0);
 		}
-			
-		road_.push_back(r);
+		else
+		{
+			pos = new Position(this);
+			LaneSection *lane_section = GetRoadByIdx(node->road_idx_)->GetLaneSectionByIdx(node->lane_section_idx_);
+			pos->SetLanePos(GetTrackIdByIdx(node->road_idx_), node->lane_id_, 
+				node->lane_id_ < 0 ? lane_section->GetS() : lane_section->GetS() + lane_section->GetLength(), 0);
+		}
+		route->waypoint_.push_back(pos);
 	}
 
-	for (pugi::xml_node junction_node = node.child("junction"); junction_node; junction_node = junction_node.next_sibling("junction"))
+	return length;
+}
+
+bool OpenDrive::IsConnected(int road1_id, int road2_id, int* &connecting_road_id, int* &connecting_lane_id, int lane1_id, int lane2_id)
+{
+	Road *road1 = GetRoadById(road1_id);
+	Road *road2 = GetRoadById(road2_id);
+
+	LinkType link_type;
+	RoadLink *link = 0;
+
+	// Look from road 1, both ends, for road 2
+	if (lane1_id < 0)
 	{
-		int id = atoi(junction_node.attribute("id").value());
-		std::string name = junction_node.attribute("name").value();
+		link_type = SUCCESSOR;
+		link = road1->GetLink(link_type);
+	}
+	else if (lane1_id > 0)
+	{
+		link_type = PREDECESSOR;
+		link = road1->GetLink(link_type);
+	}
+	else
+	{
+		// Try both ends
+		link_type = SUCCESSOR;
+		link = road1->GetLink(link_type);
+		if (link == 0)
+		{
+			link_type = PREDECESSOR;
+			link = road1->GetLink(link_type);
+			if (link == 0)
+			{
+				LOG("OpenDrive::IsConnected Link not found!\n");
+				return false;
+			}
+		}
+	}
+	if (link == 0)
+	{
+		return false;
+	}
 
-		Junction *j = new Junction(id, name);
+	LaneSection *lane_section = 0;
 
-		for (pugi::xml_node connection_node = junction_node.child("connection"); connection_node; connection_node = connection_node.next_sibling("connection"))
+	if (link->GetElementType() == RoadLink::ELEMENT_TYPE_ROAD)
+	{
+		if (link->GetElementId() == road2->GetId())
 		{
-			if (connection_node != NULL)
+			if (lane1_id != 0 && lane2_id != 0)
 			{
-				int id = atoi(connection_node.attribute("id").value());
-				(void)id;
-				int incoming_road_id = atoi(connection_node.attribute("incomingRoad").value());
-				int connecting_road_id = atoi(connection_node.attribute("connectingRoad").value());
-				Road *incoming_road = GetRoadById(incoming_road_id);
-				Road *connecting_road = GetRoadById(connecting_road_id);
-				ContactPointType contact_point = CONTACT_POINT_UNKNOWN;
-				std::string contact_point_str = connection_node.attribute("contactPoint").value();
-				if (contact_point_str == "start")
+				// Check lane connected
+				if (link_type == SUCCESSOR)
 				{
-					contact_point = CONTACT_POINT_START;
+					lane_section = road1->GetLaneSectionByIdx(road1->GetNumberOfLaneSections() - 1);
 				}
-				else if (contact_point_str == "end")
+				else if (link_type == PREDECESSOR)
 				{
-					contact_point = CONTACT_POINT_END;
+					lane_section = road1->GetLaneSectionByIdx(0);
 				}
 				else
 				{
-					LOG("Unsupported contact point: %s\n", contact_point_str.c_str());
+					LOG("OpenDrive::IsConnected Error LinkType %d not suppoered\n", link_type);
+					return false;
+				}
+				if (lane_section == 0)
+				{
+					LOG("OpenDrive::IsConnected Error lane section == 0\n");
+					return false;
+				}
+				Lane *lane = lane_section->GetLaneById(lane1_id);
+				(void)lane;
+				if (!(lane_section->GetConnectingLaneId(lane1_id, link_type) == lane2_id))
+				{
+					return false;
 				}
+				// Now, check other end lane connectivitiy
+			}
+			return true;
+		}
+	}
+	// check whether the roads are connected via a junction connecting road and specified lane
+	else if (link->GetElementType() == RoadLink::ELEMENT_TYPE_JUNCTION)
+	{
+		Junction *junction = GetJunctionById(link->GetElementId());
 
-				Connection *connection = new Connection(incoming_road, connecting_road, contact_point);
+		for (int i = 0; i < junction->GetNumberOfConnections(); i++)
+		{
+			Connection *connection = junction->GetConnectionByIdx(i);
 
-				for (pugi::xml_node lane_link_node = connection_node.child("laneLink"); lane_link_node; lane_link_node = lane_link_node.next_sibling("laneLink"))
+			if (connection->GetIncomingRoad()->GetId() == road1_id)
+			{
+				// Found a connecting road - now check if it connects to second road
+				Road *connecting_road = GetRoadById(connection->GetConnectingRoad()->GetId());
+				RoadLink *exit_link = connecting_road->GetLink(SUCCESSOR);
+
+				if (exit_link->GetElementId() == road2_id)
 				{
-					int from_id = atoi(lane_link_node.attribute("from").value());
-					int to_id = atoi(lane_link_node.attribute("to").value());
-					connection->AddJunctionLaneLink(from_id, to_id);
+					// Finally check that lanes are connected through the junction
+					// Look at lane section and locate lane connecting both roads
+					// Assume connecting road has only one lane section 
+					lane_section = connecting_road->GetLaneSectionByIdx(0);
+					if (lane_section == 0)
+					{
+						LOG("OpenDrive::IsConnected Error lane section == 0\n");
+						return false;
+					}
+					for (int j = 0; j < lane_section->GetNumberOfLanes(); j++)
+					{
+						Lane *lane = lane_section->GetLaneByIdx(j);
+						LaneLink *lane_link_predecessor = lane->GetLink(PREDECESSOR);
+						LaneLink *lane_link_successor = lane->GetLink(SUCCESSOR);
+						if (lane_link_predecessor == 0 || lane_link_successor == 0)
+						{
+							continue;
+						}
+						if (lane_link_predecessor->GetId() == lane1_id && lane_link_successor->GetId() == lane2_id)
+						{
+							// Found link
+							if (connecting_road_id != 0)
+							{
+								*connecting_road_id = connection->GetConnectingRoad()->GetId();
+							}
+							if (connecting_lane_id != 0)
+							{
+								*connecting_lane_id = connection->GetConnectingLaneId(lane1_id);
+							}
+							return true;
+						}
+					}
 				}
-				j->AddConnection(connection);
 			}
 		}
-		junction_.push_back(j);
 	}
-	return true;
+	else
+	{
+		LOG("OpenDrive::IsConnected Error: LinkElementType %d unsupported\n", link->GetElementType());
+	}
+
+	return false;
 }
 
-Connection::Connection(Road* incoming_road, Road *connecting_road, ContactPointType contact_point)
+void OpenDrive::Print()
 {
-	// Find corresponding road objects
-	incoming_road_ = incoming_road;
-	connecting_road_ = connecting_road;
-	contact_point_ = contact_point;
-}
+	LOG("Roads:\n");
+	for (size_t i=0; i<road_.size(); i++)
+	{
+		road_[i]->Print();
+	}
 
-Connection::~Connection()
-{ 
-	for (size_t i=0; i<lane_link_.size(); i++) 
+	LOG("junctions\n");
+	for (size_t i=0; i<junction_.size(); i++)
 	{
-		delete lane_link_[i];
+		junction_[i]->Print();
 	}
 }
 
-void Connection::AddJunctionLaneLink(int from, int to)
+void SpatialIndex::Clear()
 {
-	lane_link_.push_back(new JunctionLaneLink(from, to));
+	entry_.clear();
+	road_entry_idx_.clear();
+	cell_start_.clear();
+	cell_entry_.clear();
+	nx_ = 0;
+	ny_ = 0;
 }
 
-int Connection::GetConnectingLaneId(int incoming_lane_id)
+void SpatialIndex::Build(OpenDrive *od)
 {
-	for (size_t i = 0; i < lane_link_.size(); i++)
+	double x_min = std::numeric_limits<double>::infinity();
+	double y_min = std::numeric_limits<double>::infinity();
+	double x_max = -std::numeric_limits<double>::infinity();
+	double y_max = -std::numeric_limits<double>::infinity();
+
+	std::vector<double> samples;  // ds, x, y and h of geometry sample points
+
+	Clear();
+
+	for (int i = 0; i < od->GetNumOfRoads(); i++)
 	{
-		if (lane_link_[i]->from_ == incoming_lane_id)
+		Road *road = od->GetRoadByIdx(i);
+		road_entry_idx_.push_back((int)entry_.size());
+
+		for (int j = 0; j < road->GetNumberOfGeometries(); j++)
 		{
-			return lane_link_[i]->to_;
+			Geometry *geom = road->GetGeometry(j);
+			Entry entry;
+			double x, y;
+			double x_prev = 0;
+			double y_prev = 0;
+			double margin = 0;
+
+			entry.road_idx_ = i;
+			entry.geom_idx_ = j;
+			entry.x_min_ = entry.y_min_ = std::numeric_limits<double>::infinity();
+			entry.x_max_ = entry.y_max_ = -std::numeric_limits<double>::infinity();
+
+			// Sample the geometry. For curved ones, any point in between samples is within 
+			// distance of the longest sample step.
+			int n_steps = 1;
+			if (geom->GetType() != Geometry::GEOMETRY_TYPE_LINE)
+			{
+				n_steps = MAX(1, (int)ceil(geom->GetLength() / SPATIAL_INDEX_SAMPLE_DIST));
+			}
+
+			samples.resize(4 * (n_steps + 1));
+			double *ds = &samples[0];
+			double *xs = &samples[n_steps + 1];
+			double *ys = &samples[2 * (n_steps + 1)];
+			double *hs = &samples[3 * (n_steps + 1)];
+			for (int k = 0; k < n_steps + 1; k++)
+			{
+				ds[k] = k * geom->GetLength() / n_steps;
+			}
+			geom->EvaluateDSBatch(n_steps + 1, ds, xs, ys, hs);
+
+			for (int k = 0; k < n_steps + 1; k++)
+			{
+				x = xs[k];
+				y = ys[k];
+				entry.x_min_ = MIN(entry.x_min_, x);
+				entry.y_min_ = MIN(entry.y_min_, y);
+				entry.x_max_ = MAX(entry.x_max_, x);
+				entry.y_max_ = MAX(entry.y_max_, y);
+				if (k > 0 && geom->GetType() != Geometry::GEOMETRY_TYPE_LINE)
+				{
+					margin = MAX(margin, PointDistance(x_prev, y_prev, x, y));
+				}
+				x_prev = x;
+				y_prev = y;
+			}
+
+			// Widen by lane offset and lanes. Lane offset is evaluated by road s, and by local (geometry) s 
+			// in chord approximation mode, see GetDistToTrackGeom().
+			margin += MAX(road->GetLaneOffsetAbsMax(geom->GetS(), geom->GetS() + geom->GetLength()),
+				road->GetLaneOffsetAbsMax(0, geom->GetLength()));
+			margin += road->GetLanesWidthAbsMax(geom->GetS(), geom->GetS() + geom->GetLength());
+			margin += SPATIAL_INDEX_MARGIN;
+
+			entry.x_min_ -= margin;
+			entry.y_min_ -= margin;
+			entry.x_max_ += margin;
+			entry.y_max_ += margin;
+
+			x_min = MIN(x_min, entry.x_min_);
+			y_min = MIN(y_min, entry.y_min_);
+			x_max = MAX(x_max, entry.x_max_);
+			y_max = MAX(y_max, entry.y_max_);
+
+			entry_.push_back(entry);
 		}
 	}
-	return 0;
-}
 
-void Connection::Print()
-{
-	LOG("Connection: incoming %d connecting %d\n", incoming_road_->GetId(), connecting_road_->GetId());
-	for (size_t i = 0; i < lane_link_.size(); i++)
+	if (entry_.size() == 0)
 	{
-		lane_link_[i]->Print();
+		return;
 	}
-}
 
-Junction::~Junction()
-{ 
-	for (size_t i=0; i<connection_.size(); i++)
+	// Aim for roughly one cell per geometry
+	x0_ = x_min;
+	y0_ = y_min;
+	cell_size_ = MAX(1.0, sqrt((x_max - x_min) * (y_max - y_min) / entry_.size()));
+	nx_ = (int)((x_max - x_min) / cell_size_) + 1;
+	ny_ = (int)((y_max - y_min) / cell_size_) + 1;
+
+	// Register entries in all cells covered by the bounding box
+	cell_start_.assign(nx_ * ny_ + 1, 0);
+	for (size_t i = 0; i < entry_.size(); i++)
 	{
-		delete connection_[i];
+		Entry *entry = &entry_[i];
+		GetCell(entry->x_min_, entry->y_min_, entry->cx_min_, entry->cy_min_);
+		GetCell(entry->x_max_, entry->y_max_, entry->cx_max_, entry->cy_max_);
+
+		for (int cy = entry->cy_min_; cy <= entry->cy_max_; cy++)
+		{
+			for (int cx = entry->cx_min_; cx <= entry->cx_max_; cx++)
+			{
+				cell_start_[cy * nx_ + cx + 1]++;
+			}
+		}
 	}
-}
 
-int Junction::GetNumberOfRoadConnections(int roadId, int laneId)
-{
-	int counter = 0;
+	for (int i = 0; i < nx_ * ny_; i++)
+	{
+		cell_start_[i + 1] += cell_start_[i];
+	}
 
-	for (int i = 0; i < GetNumberOfConnections(); i++)
+	std::vector<int> counter(cell_start_.begin(), cell_start_.end() - 1);
+	cell_entry_.resize(cell_start_.back());
+	for (int i = 0; i < (int)entry_.size(); i++)
 	{
-		Connection * connection = GetConnectionByIdx(i);
-		if (roadId == connection->GetIncomingRoad()->GetId())
+		Entry *entry = &entry_[i];
+		for (int cy = entry->cy_min_; cy <= entry->cy_max_; cy++)
 		{
-			for (int j = 0; j < connection->GetNumberOfLaneLinks(); j++)
+			for (int cx = entry->cx_min_; cx <= entry->cx_max_; cx++)
 			{
-				JunctionLaneLink *lane_link = connection->GetLaneLink(j);
-				if (laneId == lane_link->from_)
-				{
-					counter++;
-				}
+				cell_entry_[counter[cy * nx_ + cx]++] = i;
 			}
 		}
 	}
-	return counter;
 }
 
-LaneRoadLaneConnection Junction::GetRoadConnectionByIdx(int roadId, int laneId, int idx)
+void SpatialIndex::GetCell(double x, double y, int &cx, int &cy)
 {
-	int counter = 0;
-	LaneRoadLaneConnection lane_road_lane_connection;
+	cx = CLAMP((int)floor((x - x0_) / cell_size_), 0, nx_ - 1);
+	cy = CLAMP((int)floor((y - y0_) / cell_size_), 0, ny_ - 1);
+}
 
-	for (int i = 0; i < GetNumberOfConnections(); i++)
+int SpatialIndex::GetMaxRing(int cx, int cy)
+{
+	return MAX(MAX(cx, nx_ - 1 - cx), MAX(cy, ny_ - 1 - cy));
+}
+
+void SpatialIndex::GetRingEntries(int cx, int cy, int ring, std::vector<int> &entries)
+{
+	for (int y = MAX(0, cy - ring); y <= MIN(ny_ - 1, cy + ring); y++)
 	{
-		Connection * connection = GetConnectionByIdx(i);
-		if (roadId == connection->GetIncomingRoad()->GetId())
+		// Visit complete top and bottom rows, only end cells of rows in between
+		int step = (y == cy - ring || y == cy + ring) ? 1 : 2 * ring;
+
+		for (int x = cx - ring; x <= cx + ring; x += step)
 		{
-			for (int j = 0; j < connection->GetNumberOfLaneLinks(); j++)
+			if (x >= 0 && x < nx_)
 			{
-				JunctionLaneLink *lane_link = connection->GetLaneLink(j);
-				if (laneId == lane_link->from_)
+				for (int i = cell_start_[y * nx_ + x]; i < cell_start_[y * nx_ + x + 1]; i++)
 				{
-					if (counter == idx)
+					Entry *entry = &entry_[cell_entry_[i]];
+
+					// Skip entries overlapping the inner rings, already reported
+					if (ring > 0 &&
+						entry->cx_max_ >= cx - ring + 1 && entry->cx_min_ <= cx + ring - 1 &&
+						entry->cy_max_ >= cy - ring + 1 && entry->cy_min_ <= cy + ring - 1)
 					{
-						lane_road_lane_connection.SetLane(laneId);
-						lane_road_lane_connection.contact_point_ = connection->GetContactPoint();
-						lane_road_lane_connection.SetConnectingRoad(connection->GetConnectingRoad()->GetId());
-						lane_road_lane_connection.SetConnectingLane(lane_link->to_);
-						// find out driving direction
-						int laneSectionId;
-						if (lane_link->to_ < 0)
-						{
-							laneSectionId = 0;
-						}
-						else
-						{
-							laneSectionId = connection->GetConnectingRoad()->GetNumberOfLaneSections() - 1;
-						}
-						if (!connection->GetConnectingRoad()->GetLaneSectionByIdx(laneSectionId)->GetLaneById(lane_link->to_)->IsDriving())
-						{
-							LOG("OpenDrive::GetJunctionConnection target lane not driving! from %d, %d to %d, %d\n",
-								roadId, laneId, connection->GetConnectingRoad()->GetId(), lane_link->to_);
-						}
+						continue;
+					}
 
-						return lane_road_lane_connection;
+					// Report entry only in its lower left cell within the ring
+					if (x == MAX(entry->cx_min_, cx - ring) && y == MAX(entry->cy_min_, cy - ring))
+					{
+						entries.push_back(cell_entry_[i]);
 					}
-					counter++;
 				}
 			}
+			if (step == 0)
+			{
+				break;
+			}
 		}
 	}
-
-	return lane_road_lane_connection;
 }
 
-void Junction::Print()
+double SpatialIndex::GetRingDistance(double x, double y, int cx, int cy, int ring)
 {
-	LOG("Junction %d %s: \n", id_, name_.c_str());
+	double dist = std::numeric_limits<double>::infinity();
 
-	for (size_t i=0; i<connection_.size(); i++)
+	if (cx - ring > 0)
 	{
-		connection_[i]->Print();
+		dist = MIN(dist, x - (x0_ + (cx - ring) * cell_size_));
+	}
+	if (cx + ring < nx_ - 1)
+	{
+		dist = MIN(dist, x0_ + (cx + ring + 1) * cell_size_ - x);
+	}
+	if (cy - ring > 0)
+	{
+		dist = MIN(dist, y - (y0_ + (cy - ring) * cell_size_));
+	}
+	if (cy + ring < ny_ - 1)
+	{
+		dist = MIN(dist, y0_ + (cy + ring + 1) * cell_size_ - y);
 	}
+
+	return dist;
 }
 
-OpenDrive::~OpenDrive()
+double SpatialIndex::GetDistLowerBound(int idx, double x, double y)
 {
-	for (size_t i=0; i<road_.size(); i++)
-	{
-		delete(road_[i]);
-	}
+	Entry *entry = &entry_[idx];
+	double dx = MAX(0.0, MAX(entry->x_min_ - x, x - entry->x_max_));
+	double dy = MAX(0.0, MAX(entry->y_min_ - y, y - entry->y_max_));
+
+	return sqrt(dx * dx + dy * dy);
 }
 
-int OpenDrive::GetTrackIdxById(int id)
+void LaneGraph::Clear()
+{
+	node_.clear();
+	edge_.clear();
+	road_node_idx_.clear();
+	heuristic_scale_ = 1.0;
+	visit_.clear();
+	cost_.clear();
+	prev_.clear();
+	closed_.clear();
+	search_id_ = 0;
+}
+
+int LaneGraph::GetNodeIdx(int road_idx, int lane_section_idx, int lane_id)
 {
-	for (int i = 0; i<(int)road_.size(); i++)
+	if (road_idx < 0 || road_idx >= (int)road_node_idx_.size())
+	{
+		return -1;
+	}
+
+	int last = road_idx < (int)road_node_idx_.size() - 1 ? road_node_idx_[road_idx + 1] : GetNumberOfNodes();
+	for (int i = road_node_idx_[road_idx]; i < last; i++)
 	{
-		if (road_[i]->GetId() == id)
+		if (node_[i].lane_section_idx_ == lane_section_idx && node_[i].lane_id_ == lane_id)
 		{
 			return i;
 		}
 	}
-	LOG("OpenDrive::GetTrackIdxById Error: Road id %d not found\n", id);
-	return -1;
-}
 
-int OpenDrive::GetTrackIdByIdx(int idx)
-{
-	if (idx >= 0 && idx < (int)road_.size())
-	{
-		return (road_[idx]->GetId());
-	}
-	LOG("OpenDrive::GetTrackIdByIdx: idx %d out of range [0:%d]\n", idx, (int)road_.size());
-	return 0;
+	return -1;
 }
 
-bool OpenDrive::IsConnected(int road1_id, int road2_id, int* &connecting_road_id, int* &connecting_lane_id, int lane1_id, int lane2_id)
+void LaneGraph::Build(OpenDrive *od)
 {
-	Road *road1 = GetRoadById(road1_id);
-	Road *road2 = GetRoadById(road2_id);
-
-	LinkType link_type;
-	RoadLink *link = 0;
+	Clear();
 
-	// Look from road 1, both ends, for road 2
-	if (lane1_id < 0)
-	{
-		link_type = SUCCESSOR;
-		link = road1->GetLink(link_type);
-	}
-	else if (lane1_id > 0)
-	{
-		link_type = PREDECESSOR;
-		link = road1->GetLink(link_type);
-	}
-	else
+	// Nodes, one per driving lane and lane section
+	Position pos(od);
+	for (int i = 0; i < od->GetNumOfRoads(); i++)
 	{
-		// Try both ends
-		link_type = SUCCESSOR;
-		link = road1->GetLink(link_type);
-		if (link == 0)
+		Road *road = od->GetRoadByIdx(i);
+		road_node_idx_.push_back((int)node_.size());
+
+		for (int j = 0; j < road->GetNumberOfLaneSections(); j++)
 		{
-			link_type = PREDECESSOR;
-			link = road1->GetLink(link_type);
-			if (link == 0)
+			LaneSection *lane_section = road->GetLaneSectionByIdx(j);
+			for (int k = 0; k < lane_section->GetNumberOfLanes(); k++)
 			{
-				LOG("OpenDrive::IsConnected Link not found!\n");
-				return false;
+				Lane *lane = lane_section->GetLaneByIdx(k);
+				if (lane->GetId() == 0 || !lane->IsDriving())
+				{
+					continue;
+				}
+
+				Node node;
+				node.road_idx_ = i;
+				node.lane_section_idx_ = j;
+				node.lane_id_ = lane->GetId();
+				node.length_ = lane_section->GetLength();
+				pos.SetTrackPos(road->GetId(), lane->GetId() < 0 ? lane_section->GetS() : lane_section->GetS() + lane_section->GetLength(), 0);
+				node.x_ = pos.GetX();
+				node.y_ = pos.GetY();
+				node.first_edge_ = 0;
+				node_.push_back(node);
 			}
 		}
 	}
-	if (link == 0)
-	{
-		return false;
-	}
 
-	LaneSection *lane_section = 0;
+	// Edges, collected per node in order
+	Node terminator;
+	terminator.road_idx_ = -1;
+	terminator.lane_section_idx_ = -1;
+	terminator.lane_id_ = 0;
+	terminator.length_ = 0;
+	terminator.x_ = 0;
+	terminator.y_ = 0;
+	terminator.first_edge_ = 0;
+	node_.push_back(terminator);
 
-	if (link->GetElementType() == RoadLink::ELEMENT_TYPE_ROAD)
+	for (int i = 0; i < GetNumberOfNodes(); i++)
 	{
-		if (link->GetElementId() == road2->GetId())
+		Node *node = &node_[i];
+		Road *road = od->GetRoadByIdx(node->road_idx_);
+		LaneSection *lane_section = road->GetLaneSectionByIdx(node->lane_section_idx_);
+		Lane *lane = lane_section->GetLaneById(node->lane_id_);
+		LinkType link_type = node->lane_id_ < 0 ? SUCCESSOR : PREDECESSOR;
+		int next_lane_section_idx = node->lane_section_idx_ + (node->lane_id_ < 0 ? 1 : -1);
+		std::vector<int> to;
+
+		node->first_edge_ = (int)edge_.size();
+
+		if (next_lane_section_idx >= 0 && next_lane_section_idx < road->GetNumberOfLaneSections())
 		{
-			if (lane1_id != 0 && lane2_id != 0)
+			// Next lane section of same road. Lane ID is kept unless linked otherwise.
+			LaneLink *lane_link = lane->GetLink(link_type);
+			to.push_back(GetNodeIdx(node->road_idx_, next_lane_section_idx, lane_link ? lane_link->GetId() : node->lane_id_));
+		}
+		else if (road->GetLink(link_type) != 0)
+		{
+			RoadLink *link = road->GetLink(link_type);
+
+			if (link->GetElementType() == RoadLink::ELEMENT_TYPE_ROAD)
 			{
-				// Check lane connected
-				if (link_type == SUCCESSOR)
-				{
-					lane_section = road1->GetLaneSectionByIdx(road1->GetNumberOfLaneSections() - 1);
-				}
-				else if (link_type == PREDECESSOR)
+				Road *next_road = od->GetRoadById(link->GetElementId());
+				LaneLink *lane_link = lane->GetLink(link_type);
+				if (next_road && lane_link)
 				{
-					lane_section = road1->GetLaneSectionByIdx(0);
-				}
-				else
-				{
-					LOG("OpenDrive::IsConnected Error LinkType %d not suppoered\n", link_type);
-					return false;
+					int ls_idx = link->GetContactPointType() == CONTACT_POINT_END ? next_road->GetNumberOfLaneSections() - 1 : 0;
+					to.push_back(GetNodeIdx(od->GetTrackIdxById(next_road->GetId()), ls_idx, lane_link->GetId()));
 				}
-				if (lane_section == 0)
+			}
+			else if (link->GetElementType() == RoadLink::ELEMENT_TYPE_JUNCTION)
+			{
+				Junction *junction = od->GetJunctionById(link->GetElementId());
+				int n_connections = 0;
+				LaneRoadLaneConnection *lane_connection = junction ? junction->GetRoadConnections(road->GetId(), node->lane_id_, n_connections) : 0;
+
+				for (int j = 0; j < n_connections; j++)
 				{
-					LOG("OpenDrive::IsConnected Error lane section == 0\n");
-					return false;
+					Road *next_road = od->GetRoadById(lane_connection[j].GetConnectingRoadId());
+					if (next_road)
+					{
+						int ls_idx = lane_connection[j].contact_point_ == CONTACT_POINT_END ? next_road->GetNumberOfLaneSections() - 1 : 0;
+						to.push_back(GetNodeIdx(od->GetTrackIdxById(next_road->GetId()), ls_idx, lane_connection[j].GetConnectinglaneId()));
+					}
 				}
-				Lane *lane = lane_section->GetLaneById(lane1_id);
-				(void)lane;
-				if (!(lane_section->GetConnectingLaneId(lane1_id, link_type) == lane2_id))
+			}
+		}
+
+		for (size_t j = 0; j < to.size(); j++)
+		{
+			if (to[j] >= 0)
+			{
+				Edge edge = { to[j], node->length_ };
+				edge_.push_back(edge);
+			}
+		}
+
+		// Lane changes to neighbouring lanes of same driving direction
+		for (int d = -1; d <= 1; d += 2)
+		{
+			int neighbour_id = node->lane_id_ + d;
+			if (neighbour_id != 0 && SIGN(neighbour_id) == SIGN(node->lane_id_))
+			{
+				int idx = GetNodeIdx(node->road_idx_, node->lane_section_idx_, neighbour_id);
+				if (idx >= 0)
 				{
-					return false;
+					Edge edge = { idx, ROUTE_LANE_CHANGE_COST };
+					edge_.push_back(edge);
 				}
-				// Now, check other end lane connectivitiy
 			}
-			return true;
 		}
 	}
-	// check whether the roads are connected via a junction connecting road and specified lane
-	else if (link->GetElementType() == RoadLink::ELEMENT_TYPE_JUNCTION)
+	node_.back().first_edge_ = (int)edge_.size();
+
+	// Straight line distance to the destination is a consistent A* heuristic if no edge is shorter than the 
+	// distance between the entry points of its nodes (triangle inequality). That holds along a reference line,
+	// but not where the reference lines of linked roads are apart, so scale the distance to hold for all edges.
+	// Then the first visit of a node when it is closed is along a shortest path.
+	heuristic_scale_ = 1.0;
+	for (int i = 0; i < GetNumberOfNodes(); i++)
+	{
+		for (int j = node_[i].first_edge_; j < node_[i + 1].first_edge_; j++)
+		{
+			Node *to = &node_[edge_[j].to_];
+			double dist = PointDistance(node_[i].x_, node_[i].y_, to->x_, to->y_);
+			if (heuristic_scale_ * dist > edge_[j].cost_)
+			{
+				heuristic_scale_ = edge_[j].cost_ / dist;
+			}
+		}
+	}
+}
+
+bool LaneGraph::IsLaneChange(int from, int to)
+{
+	return from != to && node_[from].road_idx_ == node_[to].road_idx_ && node_[from].lane_section_idx_ == node_[to].lane_section_idx_;
+}
+
+double LaneGraph::FindPath(int from, int to, std::vector<int> &path, bool leave_section)
+{
+	path.clear();
+
+	if (from < 0 || from >= GetNumberOfNodes() || to < 0 || to >= GetNumberOfNodes())
+	{
+		return -1;
+	}
+
+	if (visit_.size() != node_.size())
+	{
+		visit_.assign(node_.size(), 0);
+		cost_.resize(node_.size());
+		prev_.resize(node_.size());
+		closed_.resize(node_.size());
+	}
+	if (++search_id_ == 0)
 	{
-		Junction *junction = GetJunctionById(link->GetElementId());
+		// Stamp counter wrapped, reset all
+		visit_.assign(node_.size(), 0);
+		search_id_ = 1;
+	}
 
-		for (int i = 0; i < junction->GetNumberOfConnections(); i++)
-		{
-			Connection *connection = junction->GetConnectionByIdx(i);
+	// Open set as a min heap of (estimated total cost, node)
+	std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int> >, std::greater<std::pair<double, int> > > open;
+	Node *target = &node_[to];
 
-			if (connection->GetIncomingRoad()->GetId() == road1_id)
+	if (leave_section)
+	{
+		// Start from the lanes following the lane section of the start node, or any lane reachable by lane 
+		// changes within it. Previous node of these is encoded as -2 - (node in the start lane section).
+		std::vector<std::pair<int, double> > section_nodes(1, std::make_pair(from, 0.0));
+		for (size_t i = 0; i < section_nodes.size(); i++)
+		{
+			int n = section_nodes[i].first;
+			for (int j = node_[n].first_edge_; j < node_[n + 1].first_edge_; j++)
 			{
-				// Found a connecting road - now check if it connects to second road
-				Road *connecting_road = connection->GetConnectingRoad();
-				RoadLink *exit_link = connecting_road->GetLink(SUCCESSOR);
-
-				if (exit_link->GetElementId() == road2_id)
+				int m = edge_[j].to_;
+				if (IsLaneChange(n, m))
 				{
-					// Finally check that lanes are connected through the junction
-					// Look at lane section and locate lane connecting both roads
-					// Assume connecting road has only one lane section 
-					lane_section = connecting_road->GetLaneSectionByIdx(0);
-					if (lane_section == 0)
+					bool found = false;
+					for (size_t k = 0; k < section_nodes.size() && !found; k++)
 					{
-						LOG("OpenDrive::IsConnected Error lane section == 0\n");
-						return false;
+						found = section_nodes[k].first == m;
 					}
-					for (int j = 0; j < lane_section->GetNumberOfLanes(); j++)
+					if (!found)
 					{
-						Lane *lane = lane_section->GetLaneByIdx(j);
-						LaneLink *lane_link_predecessor = lane->GetLink(PREDECESSOR);
-						LaneLink *lane_link_successor = lane->GetLink(SUCCESSOR);
-						if (lane_link_predecessor == 0 || lane_link_successor == 0)
-						{
-							continue;
-						}
-						if (lane_link_predecessor->GetId() == lane1_id && lane_link_successor->GetId() == lane2_id)
-						{
-							// Found link
-							if (connecting_road_id != 0)
-							{
-								*connecting_road_id = connection->GetConnectingRoad()->GetId();
-							}
-							if (connecting_lane_id != 0)
-							{
-								*connecting_lane_id = connection->GetConnectingLaneId(lane1_id);
-							}
-							return true;
-						}
+						section_nodes.push_back(std::make_pair(m, section_nodes[i].second + edge_[j].cost_));
+					}
+				}
+				else
+				{
+					double cost = section_nodes[i].second + edge_[j].cost_;
+					if (visit_[m] != search_id_ || cost < cost_[m])
+					{
+						visit_[m] = search_id_;
+						cost_[m] = cost;
+						prev_[m] = -2 - n;
+						closed_[m] = false;
+						open.push(std::make_pair(cost + heuristic_scale_ * PointDistance(node_[m].x_, node_[m].y_, target->x_, target->y_), m));
 					}
 				}
 			}
@@ -1746,25 +4738,65 @@ bool OpenDrive::IsConnected(int road1_id, int road2_id, int* &connecting_road_id
 	}
 	else
 	{
-		LOG("OpenDrive::IsConnected Error: LinkElementType %d unsupported\n", link->GetElementType());
+		visit_[from] = search_id_;
+		cost_[from] = 0;
+		prev_[from] = -1;
+		closed_[from] = false;
+		open.push(std::make_pair(0.0, from));
 	}
 
-	return false;
-}
-
-void OpenDrive::Print()
-{
-	LOG("Roads:\n");
-	for (size_t i=0; i<road_.size(); i++)
+	while (!open.empty())
 	{
-		road_[i]->Print();
-	}
+		int n = open.top().second;
+		open.pop();
 
-	LOG("junctions\n");
-	for (size_t i=0; i<junction_.size(); i++)
-	{
-		junction_[i]->Print();
+		if (closed_[n])
+		{
+			continue;  // outdated heap entry
+		}
+		closed_[n] = true;
+
+		if (n == to)
+		{
+			int i = to;
+			for (; prev_[i] >= 0; i = prev_[i])
+			{
+				path.push_back(i);
+			}
+			path.push_back(i);
+			if (prev_[i] < -1)
+			{
+				// Lane changes within the start lane section
+				int last = -2 - prev_[i];
+				for (int lane_id = node_[last].lane_id_; lane_id != node_[from].lane_id_; lane_id -= SIGN(lane_id - node_[from].lane_id_))
+				{
+					path.push_back(GetNodeIdx(node_[from].road_idx_, node_[from].lane_section_idx_, lane_id));
+				}
+				path.push_back(from);
+			}
+			std::reverse(path.begin(), path.end());
+
+			return cost_[to];
+		}
+
+		for (int i = node_[n].first_edge_; i < node_[n + 1].first_edge_; i++)
+		{
+			int m = edge_[i].to_;
+			double cost = cost_[n] + edge_[i].cost_;
+
+			// Closed nodes are reopened if reached cheaper, which only rounding errors of the heuristic can cause
+			if (visit_[m] != search_id_ || cost < cost_[m])
+			{
+				visit_[m] = search_id_;
+				cost_[m] = cost;
+				prev_[m] = n;
+				closed_[m] = false;
+				open.push(std::make_pair(cost + heuristic_scale_ * PointDistance(node_[m].x_, node_[m].y_, target->x_, target->y_), m));
+			}
+		}
 	}
+
+	return -1;
 }
 
 void Position::Init()
@@ -1790,6 +4822,14 @@ void Position::Init()
 	lane_idx_ = 0;
 	elevation_idx_ = 0;
 	route_ = 0;
+	od_ = 0;
+	lane_offsets_serial_ = 0;
+	lane_offsets_s_ = 0.0;
+	random_seeded_ = false;
+	xyz_dirty_ = false;
+	xyz_lane_dir_ = false;
+	xyz_reverse_ = false;
+	track_dirty_ = false;
 }
 
 Position::Position()
@@ -1815,6 +4855,12 @@ Position::Position(double x, double y, double z, double h, double p, double r)
 	SetInertiaPos(x, y, z, h, p, r);
 }
 
+Position::Position(OpenDrive *od)
+{
+	Init();
+	od_ = od;
+}
+
 Position::~Position()
 {
 	
@@ -1822,15 +4868,36 @@ Position::~Position()
 
 bool Position::LoadOpenDrive(const char *filename)
 {
-	return(GetOpenDrive()->LoadOpenDriveFile(filename));
+	return(GetDefaultOpenDrive()->LoadOpenDriveFile(filename));
 }
 
-OpenDrive* Position::GetOpenDrive()
+OpenDrive* Position::GetDefaultOpenDrive()
 {
 	static OpenDrive od;
 	return &od; 
 }
 
+void Position::SetRandomSeed(unsigned int seed, unsigned int stream)
+{
+	// Mix seed and stream, so that nearby values give unrelated sequences
+	std::seed_seq seq = { seed, stream };
+	unsigned int mixed;
+	seq.generate(&mixed, &mixed + 1);
+
+	random_generator_.seed(mixed);
+	random_seeded_ = true;
+}
+
+std::minstd_rand &Position::GetRandomGenerator()
+{
+	if (!random_seeded_)
+	{
+		SetRandomSeed(GetOpenDrive()->DrawRandomSeed());
+	}
+
+	return random_generator_;
+}
+
 void Position::Track2Lane()
 {
 	Road *road = GetOpenDrive()->GetRoadByIdx(track_idx_);
@@ -1864,10 +4931,13 @@ void Position::Track2Lane()
 
 	if (n_lanes > 0)
 	{
+		double *outer_offsets = GetLaneOuterOffsets(lane_section, s_);
+
 		for (int i = 0; i < n_lanes; i++)  // Search through all lanes
 		{
 			int lane_id = lane_section->GetLaneIdByIdx(i);
-			double laneCenterOffset = SIGN(lane_id) * lane_section->GetCenterOffset(s_, lane_id);
+			double laneCenterOffset = SIGN(lane_id) * (outer_offsets ? 
+				lane_section->GetCenterOffsetFromOuterOffsets(outer_offsets, i) : lane_section->GetCenterOffset(s_, lane_id));
 						
 			if (lane_section->GetLaneById(lane_id)->IsDriving() && (candidate_lane_id == 0 || fabs(t_ - laneCenterOffset) < fabs(min_offset)))
 			{
@@ -1879,20 +4949,9 @@ void Position::Track2Lane()
 
 	offset_ = min_offset;
 
-	if (candidate_lane_id != lane_id_)
-	{
-		//LOG("change lane: %d -> %d\n", lane_id_, candidate_lane_id);
-		// Update cache indices
-		lane_id_ = candidate_lane_id;
-		lane_idx_ = lane_section->GetLaneIdxById(lane_id_);
-	}
-}
-
-static double PointDistance(double x0, double y0, double x1, double y1)
-{
-	// https://en.wikipedia.org/wiki/Distance
-
-	return sqrt((x1 - x0)*(x1 - x0) + (y1 - y0) * (y1 - y0));
+	// Update cache indices. Also when lane ID is unchanged, since road or lane section may have changed.
+	lane_id_ = candidate_lane_id;
+	lane_idx_ = lane_section->GetLaneIdxById(lane_id_);
 }
 
 static bool PointInBetween(double x3, double y3, double x1, double y1, double x2, double y2, double &sNorm)
@@ -1935,69 +4994,94 @@ static int PointSideOfVec(double px, double py, double vx1, double vy1, double v
 
 double Position::GetDistToTrackGeom(double x3, double y3, double h, Road *road, Geometry *geom, bool &inside, double &sNorm)
 {
-	// Find vector from point perpendicular to line segment
-	// https://stackoverflow.com/questions/1811549/perpendicular-on-a-line-from-a-given-point
-
 	x_ = x3;
 	y_ = y3;
 	h_ = h;
 	r_ = 0;
-	double x1, y1, h1;
-	double x2, y2, h2;
 	int side;
-
-//	double line_dist = 0;
 	double dist = 0;
-	geom->EvaluateDS(0, &x1, &y1, &h1);
-	geom->EvaluateDS(geom->GetLength(), &x2, &y2, &h2);
-
-	// Apply lane offset
-	x1 += road->GetLaneOffset(0) * cos(h1 + M_PI_2);
-	y1 += road->GetLaneOffset(geom->GetLength()) * sin(h1 + M_PI_2);
-	x2 += road->GetLaneOffset(0) * cos(h2 + M_PI_2);
-	y2 += road->GetLaneOffset(geom->GetLength()) * sin(h2 + M_PI_2);
-
-
-	double x4, y4, k;
-	k = ((y2 - y1) * (x3 - x1) - (x2 - x1) * (y3 - y1)) / ((y2 - y1)*(y2 - y1) + (x2 - x1)*(x2 - x1));
-	x4 = x3 - k * (y2 - y1);
-	y4 = y3 + k * (x2 - x1);
-
-	// Check whether the projected point is inside or outside line segment
-	inside = PointInBetween(x4, y4, x1, y1, x2, y2, sNorm);
-	if (inside)
-	{
-		dist = PointDistance(x3, y3, x4, y4);
-	}
-	else
-	{
-		// Distance is mesared between point to closest endpoint of line
-		double d1, d2;
-		d1 = PointDistance(x3, y3, x1, y1);
-		d2 = PointDistance(x3, y3, x2, y2);
-		dist = MIN(d1, d2);
-	}
-	side = PointSideOfVec(x3, y3, x1, y1, x2, y2);
-
-#if 1
-	// Now, calculate actual distance to road geometry - not to a straight line
-
-	double dsMin = sNorm * geom->GetLength();
-	double sMin = geom->GetS() + dsMin;
+	double dsMin;
+	double sMin;
 	double x, y;
+	double tolerance = GetOpenDrive()->GetClosestPointTolerance();
 
-	if (inside)  // else stick with line approximation
+	if (tolerance > 0)
 	{
+		// Closest point of the reference line geometry. Same as closest point of the lane offset curve, 
+		// as long as lane offset is constant.
+		dsMin = geom->FindClosestDS(x3, y3, tolerance);
+		sMin = geom->GetS() + dsMin;
+		sNorm = geom->GetLength() > SMALL_NUMBER ? dsMin / geom->GetLength() : 0;
+		inside = dsMin > 0 && dsMin < geom->GetLength();
+
 		geom->EvaluateDS(dsMin, &x, &y, &h);
 		// Apply lane offset
-		x += road->GetLaneOffset(dsMin) * cos(h + M_PI_2);
-		y += road->GetLaneOffset(dsMin) * sin(h + M_PI_2);
+		x += road->GetLaneOffset(sMin) * cos(h + M_PI_2);
+		y += road->GetLaneOffset(sMin) * sin(h + M_PI_2);
 		dist = PointDistance(x3, y3, x, y);
 
 		// Check whether the point is left or right side of road
 		// x3, y3 is the point checked against a vector aligned with heading
 		side = PointSideOfVec(x3, y3, x, y, x + cos(h), y + sin(h));
 	}
+	else
+	{
+		// Approximate geometry by the chord between its end points.
+		// Find vector from point perpendicular to line segment
+		// https://stackoverflow.com/questions/1811549/perpendicular-on-a-line-from-a-given-point
+		double x1, y1, h1;
+		double x2, y2, h2;
+
+		geom->EvaluateDS(0, &x1, &y1, &h1);
+		geom->EvaluateDS(geom->GetLength(), &x2, &y2, &h2);
+
+		// Apply lane offset
+		x1 += road->GetLaneOffset(0) * cos(h1 + M_PI_2);
+		y1 += road->GetLaneOffset(geom->GetLength()) * sin(h1 + M_PI_2);
+		x2 += road->GetLaneOffset(0) * cos(h2 + M_PI_2);
+		y2 += road->GetLaneOffset(geom->GetLength()) * sin(h2 + M_PI_2);
+
+		double x4, y4, k;
+		k = ((y2 - y1) * (x3 - x1) - (x2 - x1) * (y3 - y1)) / ((y2 - y1)*(y2 - y1) + (x2 - x1)*(x2 - x1));
+		x4 = x3 - k * (y2 - y1);
+		y4 = y3 + k * (x2 - x1);
+
+		// Check whether the projected point is inside or outside line segment
+		inside = PointInBetween(x4, y4, x1, y1, x2, y2, sNorm);
+		if (inside)
+		{
+			dist = PointDistance(x3, y3, x4, y4);
+		}
+		else
+		{
+			// Distance is mesared between point to closest endpoint of line
+			double d1, d2;
+			d1 = PointDistance(x3, y3, x1, y1);
+			d2 = PointDistance(x3, y3, x2, y2);
+			dist = MIN(d1, d2);
+		}
+		side = PointSideOfVec(x3, y3, x1, y1, x2, y2);
+
+		// Now, calculate actual distance to road geometry - not to a straight line
+
+		// Evaluate lanes at the closest point of the geometry, i.e. at the end point when projected outside
+		dsMin = CLAMP(sNorm, 0.0, 1.0) * geom->GetLength();
+		sMin = geom->GetS() + dsMin;
+
+		if (inside)  // else stick with line approximation
+		{
+			geom->EvaluateDS(dsMin, &x, &y, &h);
+			// Apply lane offset
+			x += road->GetLaneOffset(dsMin) * cos(h + M_PI_2);
+			y += road->GetLaneOffset(dsMin) * sin(h + M_PI_2);
+			dist = PointDistance(x3, y3, x, y);
+
+			// Check whether the point is left or right side of road
+			// x3, y3 is the point checked against a vector aligned with heading
+			side = PointSideOfVec(x3, y3, x, y, x + cos(h), y + sin(h));
+		}
+	}
+
 	// dist is now actually the lateral distance from reference lane, e.g. track coordinate t-value
 	// Finally find closest lane
 
@@ -2007,12 +5091,16 @@ double Position::GetDistToTrackGeom(double x3, double y3, double h, Road *road,
 	LaneSection *lane_section = road->GetLaneSectionByS(sMin);
 	if (lane_section != 0)
 	{
+		double *outer_offsets = GetLaneOuterOffsets(lane_section, sMin);
+
 		for (int i = 0; i < lane_section->GetNumberOfLanes(); i++)
 		{
 			if (lane_section->GetLaneByIdx(i)->IsDriving())
 			{
+				int lane_id = lane_section->GetLaneIdByIdx(i);
 				double signed_offset = dist * SIGN(side);
-				double signed_lane_center_offset = SIGN(lane_section->GetLaneIdByIdx(i)) * lane_section->GetCenterOffset(sMin, lane_section->GetLaneIdByIdx(i));
+				double signed_lane_center_offset = SIGN(lane_id) * (outer_offsets ? 
+					lane_section->GetCenterOffsetFromOuterOffsets(outer_offsets, i) : lane_section->GetCenterOffset(sMin, lane_id));
 				double lane_dist = signed_offset - signed_lane_center_offset;
 
 				if (fabs(lane_dist) < fabs(min_lane_dist))
@@ -2023,9 +5111,79 @@ double Position::GetDistToTrackGeom(double x3, double y3, double h, Road *road,
 		}
 	}
 	return fabs(min_lane_dist);
-#else
-	return dist;
-#endif
+}
+
+double *Position::GetLaneOuterOffsets(LaneSection *lane_section, double s)
+{
+	if (lane_section->GetNumberOfLanes() > LANE_OFFSETS_MAX_LANES)
+	{
+		return 0;
+	}
+
+	if (lane_section->GetSerial() != lane_offsets_serial_ || s != lane_offsets_s_)
+	{
+		lane_section->GetOuterOffsets(s, lane_offsets_);
+		lane_offsets_serial_ = lane_section->GetSerial();
+		lane_offsets_s_ = s;
+	}
+
+	return lane_offsets_;
+}
+
+void Position::GetNeighbourGeometries(std::vector<int> &entries)
+{
+	SpatialIndex *index = GetOpenDrive()->GetSpatialIndex();
+	Road *road = GetOpenDrive()->GetRoadByIdx(track_idx_);
+
+	if (road == 0 || geometry_idx_ < 0 || geometry_idx_ >= road->GetNumberOfGeometries())
+	{
+		return;
+	}
+
+	// Current geometry and its neighbours along the same road
+	for (int i = MAX(0, geometry_idx_ - 1); i <= MIN(road->GetNumberOfGeometries() - 1, geometry_idx_ + 1); i++)
+	{
+		entries.push_back(index->GetEntryIdx(track_idx_, i));
+	}
+
+	// At first or last geometry, look at connected roads as well
+	LinkType link_types[2] = { PREDECESSOR, SUCCESSOR };
+	for (int i = 0; i < 2; i++)
+	{
+		RoadLink *link = road->GetLink(link_types[i]);
+
+		if (link == 0 || 
+			(link_types[i] == PREDECESSOR && geometry_idx_ > 0) || 
+			(link_types[i] == SUCCESSOR && geometry_idx_ < road->GetNumberOfGeometries() - 1))
+		{
+			continue;
+		}
+
+		if (link->GetElementType() == RoadLink::ELEMENT_TYPE_ROAD)
+		{
+			Road *next_road = GetOpenDrive()->GetRoadById(link->GetElementId());
+			if (next_road && next_road->GetNumberOfGeometries() > 0)
+			{
+				int geom_idx = link->GetContactPointType() == CONTACT_POINT_END ? next_road->GetNumberOfGeometries() - 1 : 0;
+				entries.push_back(index->GetEntryIdx(GetOpenDrive()->GetTrackIdxById(next_road->GetId()), geom_idx));
+			}
+		}
+		else if (link->GetElementType() == RoadLink::ELEMENT_TYPE_JUNCTION)
+		{
+			Junction *junction = GetOpenDrive()->GetJunctionById(link->GetElementId());
+			for (int j = 0; junction && j < junction->GetNumberOfConnections(); j++)
+			{
+				Connection *connection = junction->GetConnectionByIdx(j);
+				Road *next_road = connection->GetConnectingRoad();
+				if (connection->GetIncomingRoad() == road && next_road && (next_road = GetOpenDrive()->GetRoadById(next_road->GetId())) && 
+					next_road->GetNumberOfGeometries() > 0)
+				{
+					int geom_idx = connection->GetContactPoint() == CONTACT_POINT_END ? next_road->GetNumberOfGeometries() - 1 : 0;
+					entries.push_back(index->GetEntryIdx(GetOpenDrive()->GetTrackIdxById(next_road->GetId()), geom_idx));
+				}
+			}
+		}
+	}
 }
 
 void Position::XYH2TrackPos(double x3, double y3, double h3, bool evaluateZAndPitch)
@@ -2043,6 +5201,9 @@ void Position::XYH2TrackPos(double x3, double y3, double h3, bool evaluateZAndPi
 
 	(void)insideMin;
 
+	// New track position replaces any pending evaluation
+	track_dirty_ = false;
+
 	if ((road = GetOpenDrive()->GetRoadByIdx(track_idx_)) == 0)
 	{
 		LOG("Invalid road index %d\n", track_idx_);
@@ -2055,28 +5216,57 @@ void Position::XYH2TrackPos(double x3, double y3, double h3, bool evaluateZAndPi
 		return;
 	}
 
-	// Search all road and lanes. Inefficient - but simple. Todo: Optimize
+	// First look at the geometries around current position, which is where the point is most likely 
+	// found when moving in small steps. Then search candidate geometries ring by ring around the grid 
+	// cell of the point. Skip geometries which bounding box is further away than the closest distance 
+	// found so far, and stop when remaining cells are all out of reach. Hence, a close hit in the 
+	// neighbourhood will rule out most of the global search.
+	SpatialIndex *index = GetOpenDrive()->GetSpatialIndex();
+	std::vector<int> candidates;
+	int idxMin = -1;
+	int cx, cy;
 	bool found = false;
-	(void)found;
 
-	for (int i = 0; i < GetOpenDrive()->GetNumOfRoads(); i++)
+	GetNeighbourGeometries(candidates);
+	index->GetCell(x3, y3, cx, cy);
+
+	for (int ring = -1; ring <= index->GetMaxRing(cx, cy); ring++)
 	{
-		road = GetOpenDrive()->GetRoadByIdx(i);
-		for (int j = 0; j < road->GetNumberOfGeometries(); j++)
+		if (ring > -1)
 		{
-			geom = road->GetGeometry(j);
+			candidates.clear();
+			index->GetRingEntries(cx, cy, ring, candidates);
+		}
+
+		for (size_t i = 0; i < candidates.size(); i++)
+		{
+			if (candidates[i] == idxMin || index->GetDistLowerBound(candidates[i], x3, y3) > distMin)
+			{
+				continue;
+			}
+
+			SpatialIndex::Entry *entry = index->GetEntry(candidates[i]);
+			road = GetOpenDrive()->GetRoadByIdx(entry->road_idx_);
+			geom = road->GetGeometry(entry->geom_idx_);
 			dist = GetDistToTrackGeom(x3, y3, h3, road, geom, inside, sNorm);
-	
-			if (dist < distMin)  // First value (min_dist = -1) is always the closest so far
+
+			// On equal distance pick lowest index, i.e. first one in road and geometry order
+			if (dist < distMin || (dist == distMin && candidates[i] < idxMin))
 			{
 				geomMin = geom;
 				roadMin = road;
 				sNormMin = CLAMP(sNorm, 0.0, 1.0);
 				distMin = dist;
 				insideMin = inside;
+				idxMin = candidates[i];
 				found = true;
 			}
 		}
+
+		if (ring > -1 && index->GetRingDistance(x3, y3, cx, cy, ring) > distMin)
+		{
+			break;
+		}
 	}
 
 	if (!found)
@@ -2091,9 +5281,10 @@ void Position::XYH2TrackPos(double x3, double y3, double h3, bool evaluateZAndPi
 
 	// Found closest geometry. Now calculate exact distance to geometry. First find point perpendicular on geometry.
 	geomMin->EvaluateDS(dsMin, &x, &y, &h);
-	// Apply lane offset
-	x += roadMin->GetLaneOffset(dsMin) * cos(h + M_PI_2);
-	y += roadMin->GetLaneOffset(dsMin) * sin(h + M_PI_2);
+	// Apply lane offset. Chord approximation mode evaluates lane offset at ds, as earlier versions did.
+	double lane_offset = roadMin->GetLaneOffset(GetOpenDrive()->GetClosestPointTolerance() > 0 ? sMin : dsMin);
+	x += lane_offset * cos(h + M_PI_2);
+	y += lane_offset * sin(h + M_PI_2);
 	distMin = PointDistance(x3, y3, x, y);
 
 	// Check whether the point is left or right side of road
@@ -2115,27 +5306,9 @@ bool Position::EvaluateZAndPitch()
 	Road *road = GetOpenDrive()->GetRoadByIdx(track_idx_);
 	if (road && road->GetNumberOfElevations() > 0)
 	{
+		// Look up elevation section, starting from current one
+		elevation_idx_ = road->GetElevationIdxByS(s_, elevation_idx_);
 		Elevation *elevation = road->GetElevation(elevation_idx_);
-		if (elevation == NULL)
-		{
-			LOG("Elevation error NULL, nelev: %d elev_idx: %d\n", road->GetNumberOfElevations(), elevation_idx_);
-		}
-		if (elevation && s_ > elevation->GetS() + elevation->GetLength())
-		{
-			while (s_ > elevation->GetS() + elevation->GetLength() && elevation_idx_ < road->GetNumberOfElevations() - 1)
-			{
-				// Move to next elevation section
-				elevation = road->GetElevation(++elevation_idx_);
-			}
-		}
-		else if (elevation && s_ < elevation->GetS())
-		{
-			while (s_ < elevation->GetS() && elevation_idx_ > 0)
-			{
-				// Move to previous elevation section
-				elevation = road->GetElevation(--elevation_idx_);
-			}
-		}
 
 		if (elevation)
 		{
@@ -2152,6 +5325,30 @@ bool Position::EvaluateZAndPitch()
 	}
 }
 
+void Position::EvaluateXYZ()
+{
+	xyz_dirty_ = false;
+	Track2XYZ();
+
+	// Apply heading adjustments of the lane or movement direction, in the order they were requested
+	if (xyz_lane_dir_)
+	{
+		h_ += M_PI;
+		p_ *= -1;
+	}
+
+	if (xyz_reverse_)
+	{
+		h_ = fmod(h_ + M_PI, 2 * M_PI);
+	}
+}
+
+void Position::EvaluateTrackPos()
+{
+	track_dirty_ = false;
+	XYZ2Track();
+}
+
 void Position::Track2XYZ()
 {
 	Road *road = GetOpenDrive()->GetRoadByIdx(track_idx_);
@@ -2171,8 +5368,9 @@ void Position::Track2XYZ()
 	geometry->EvaluateDS(s_ - geometry->GetS(), &x_, &y_, &h_);
 	
 	// Consider lateral t position, perpendicular to track heading
-	double x_local = (t_ + road->GetLaneOffset(s_)) * cos(h_ + M_PI_2);
-	double y_local = (t_ + road->GetLaneOffset(s_)) * sin(h_ + M_PI_2);
+	double lane_offset = road->GetLaneOffset(s_);
+	double x_local = (t_ + lane_offset) * cos(h_ + M_PI_2);
+	double y_local = (t_ + lane_offset) * sin(h_ + M_PI_2);
 	h_ += atan(road->GetLaneOffsetPrim(s_)) + h_offset_ + h_relative_;
 	x_ += x_local;
 	y_ += y_local;
@@ -2200,7 +5398,7 @@ void Position::Lane2Track()
 
 void Position::XYZ2Track()
 {
-	XYH2TrackPos(GetX(), GetY(), GetH(), false);
+	XYH2TrackPos(x_, y_, h_, false);
 }
 
 void Position::SetLongitudinalTrackPos(int track_id, double s)
@@ -2232,40 +5430,35 @@ void Position::SetLongitudinalTrackPos(int track_id, double s)
 		s_ = s;
 	}
 
-	Geometry *geometry = road->GetGeometry(geometry_idx_);
-	// check if still on same geometry
-	if (s_ > geometry->GetS() + geometry->GetLength())
-	{
-		while (s_ > geometry->GetS() + geometry->GetLength() && geometry_idx_ < road->GetNumberOfGeometries() - 1)
-		{
-			// Move to next geometry
-			geometry = road->GetGeometry(++geometry_idx_);
-		}
-	}
-	else if (s_ < geometry->GetS())
-	{
-		while (s_ < geometry->GetS() && geometry_idx_ > 0)
-		{
-			// Move to previous geometry
-			geometry = road->GetGeometry(--geometry_idx_);
-		}
-	}
+	// Look up geometry, starting from current one
+	geometry_idx_ = road->GetGeometryIdxByS(s_, geometry_idx_);
 }
 
 void Position::SetTrackPos(int track_id, double s, double t, bool calculateXYZ)
 {
+	EnsureTrackPos();
+	if (!calculateXYZ)
+	{
+		// Keep current inertial coordinates
+		EnsureXYZ();
+	}
+
 	SetLongitudinalTrackPos(track_id, s);
 
 	t_ = t;
 	Track2Lane();
 	if (calculateXYZ)
 	{
-		Track2XYZ();
+		xyz_dirty_ = true;
+		xyz_lane_dir_ = false;
+		xyz_reverse_ = false;
 	}
 }
 
 int Position::MoveToConnectingRoad(RoadLink *road_link, double ds, double &s_remains, Junction::JunctionStrategyType strategy)
 {
+	EnsureTrackPos();
+
 	double s_new;
 	Road *road = GetOpenDrive()->GetRoadByIdx(track_idx_);
 	Road *next_road = 0;
@@ -2344,7 +5537,8 @@ int Position::MoveToConnectingRoad(RoadLink *road_link, double ds, double &s_rem
 		}
 	
 		int connection_idx;
-		int n_connections = junction->GetNumberOfRoadConnections(road->GetId(), lane->GetId());
+		int n_connections = 0;
+		LaneRoadLaneConnection *lane_connection = junction->GetRoadConnections(road->GetId(), lane->GetId(), n_connections);
 
 		if (n_connections == 0)
 		{
@@ -2366,27 +5560,8 @@ int Position::MoveToConnectingRoad(RoadLink *road_link, double ds, double &s_rem
 				double min_heading_diff = 1E10; // set huge number
 				for (int i = 0; i < n_connections; i++)
 				{
-					LaneRoadLaneConnection lane_road_lane_connection = 
-						junction->GetRoadConnectionByIdx(road->GetId(), lane->GetId(), i);
-					next_road = GetOpenDrive()->GetRoadById(lane_road_lane_connection.GetConnectingRoadId()); 
-
-					Position test_pos;
-					if (lane_road_lane_connection.contact_point_ == CONTACT_POINT_START)
-					{
-						// Inspect heading at the connecting road
-						test_pos.SetLanePos(next_road->GetId(), new_lane_id, next_road->GetLength(), 0);
-					}
-					else if (lane_road_lane_connection.contact_point_ == CONTACT_POINT_END)
-					{
-						test_pos.SetLanePos(next_road->GetId(), new_lane_id, 0, 0);
-					}
-					else
-					{
-						LOG("Unexpected contact point type: %d", road_link->GetContactPointType());
-					}
-
 					// Transform angle into a comparable format
-					double heading_diff = fmod(test_pos.GetH() - GetH(), M_PI);
+					double heading_diff = fmod(lane_connection[i].GetExitHeading() - GetH(), M_PI);
 					if (heading_diff > 180)
 					{
 						heading_diff = 360 - heading_diff;
@@ -2406,15 +5581,16 @@ int Position::MoveToConnectingRoad(RoadLink *road_link, double ds, double &s_rem
 			}
 			else if (strategy == Junction::JunctionStrategyType::RANDOM)
 			{
-				connection_idx = (int)(n_connections * (double)mt_rand() / mt_rand.max());
+				std::minstd_rand &random_generator = GetRandomGenerator();
+				connection_idx = (int)(n_connections * (double)random_generator() / random_generator.max());
 			}
 		}
 
-		LaneRoadLaneConnection lane_road_lane_connection = junction->GetRoadConnectionByIdx(road->GetId(), lane->GetId(), connection_idx);
-		contact_point = lane_road_lane_connection.contact_point_;
+		LaneRoadLaneConnection *lane_road_lane_connection = &lane_connection[MIN(connection_idx, n_connections - 1)];
+		contact_point = lane_road_lane_connection->contact_point_;
 
-		new_lane_id = lane_road_lane_connection.GetConnectinglaneId();
-		next_road = GetOpenDrive()->GetRoadById(lane_road_lane_connection.GetConnectingRoadId());
+		new_lane_id = lane_road_lane_connection->GetConnectinglaneId();
+		next_road = GetOpenDrive()->GetRoadById(lane_road_lane_connection->GetConnectingRoadId());
 	}
 
 	if (new_lane_id == 0)
@@ -2517,6 +5693,8 @@ int Position::MoveAlongS(double ds, double dLaneOffset, Junction::JunctionStrate
 {
 	RoadLink *link;
 	int max_links = 4;  // limit lookahead through junctions/links 
+
+	EnsureTrackPos();
 	
 	// EG: If offset_ is not along reference line, but instead along lane direction then we dont need
 	// the SIGN() adjustment. But for now this adjustment means that a positive dLaneOffset always moves left?
@@ -2530,7 +5708,7 @@ int Position::MoveAlongS(double ds, double dLaneOffset, Junction::JunctionStrate
 		double h, diff;
 
 		h = GetDrivingDirection();
-		diff = GetAbsAngleDifference(h, h_);
+		diff = GetAbsAngleDifference(h, GetH());
 
 		if (diff > M_PI_2)
 		{
@@ -2549,10 +5727,10 @@ int Position::MoveAlongS(double ds, double dLaneOffset, Junction::JunctionStrate
 		{
 			SetLanePos(track_id_, lane_id_, s_ + ds, offset_);
 
-			// make sure heading is aligned with driving direction
+			// make sure heading is aligned with driving direction, applied when heading is evaluated
 			if (diff > M_PI_2)   
 			{
-				h_ = fmod(h_ + M_PI, 2 * M_PI);
+				xyz_reverse_ = true;
 			}
 			return 0;
 		}
@@ -2580,6 +5758,8 @@ int Position::MoveAlongS(double ds, double dLaneOffset, Junction::JunctionStrate
 
 void Position::SetLanePos(int track_id, int lane_id, double s, double offset, int lane_section_idx)
 {
+	EnsureTrackPos();
+
 	offset_ = offset;
 
 	SetLongitudinalTrackPos(track_id, s);
@@ -2631,33 +5811,39 @@ void Position::SetLanePos(int track_id, int lane_id, double s, double offset, in
 	}
 
 	Lane2Track();
-	Track2XYZ();
 
-	// Adjust heading to lane direction
-	if (lane_id > 0)
-	{
-		h_ += M_PI;
-		p_ *= -1;
-	}
+	// Inertial coordinates evaluated on request, then adjusting heading to lane direction
+	xyz_dirty_ = true;
+	xyz_lane_dir_ = lane_id > 0;
+	xyz_reverse_ = false;
 }
 
 void Position::SetInertiaPos(double x, double y, double z, double h, double p, double r, bool updateTrackPos)
 {
+	if (!updateTrackPos)
+	{
+		// Keep track coordinates of current inertial position
+		EnsureTrackPos();
+	}
+
 	x_ = x;
 	y_ = y;
 	z_ = z;
 	h_ = h;
 	p_ = p;
 	r_ = r;
+	xyz_dirty_ = false;
 
 	if (updateTrackPos)
 	{
-		XYZ2Track();
+		// Track coordinates evaluated on request
+		track_dirty_ = true;
 	}
 }
 
 double Position::GetCurvature()
 {
+	EnsureTrackPos();
 	Geometry *geom = GetOpenDrive()->GetRoadByIdx(track_idx_)->GetGeometry(geometry_idx_);
 
 	return(geom->EvaluateCurvatureDS(GetS() - geom->GetS()));
@@ -2665,6 +5851,8 @@ double Position::GetCurvature()
 
 double Position::GetDrivingDirection()
 {
+	EnsureTrackPos();
+
 	double x, y, h;
 	Geometry *geom = GetOpenDrive()->GetRoadByIdx(track_idx_)->GetGeometry(geometry_idx_);
 
@@ -2699,16 +5887,19 @@ double Position::GetAbsAngleDifference(double angle1, double angle2)
 
 void Position::PrintTrackPos()
 {
+	EnsureTrackPos();
 	LOG("	Track pos: (%d, %.2f, %.2f)", track_id_, s_, t_);
 }
 
 void Position::PrintLanePos()
 {
+	EnsureTrackPos();
 	LOG("	Lane pos: (%d, %d, %.2f, %.2f)", track_id_, lane_id_, s_, offset_);
 }
 
 void Position::PrintInertialPos()
 {
+	EnsureXYZ();
 	LOG("	Inertial pos: (%.2f, %.2f, %.2f, %.2f, %.2f, %.2f)", x_, y_, z_, h_, p_, r_);
 }
 
@@ -2722,10 +5913,11 @@ void Position::Print()
 
 void Position::PrintXY()
 {
+	EnsureXYZ();
 	LOG("%.2f, %.2f\n", x_, y_);
 }
 
-double Position::getRelativeDistance(Position target_position, double &x, double &y)
+double Position::getRelativeDistance(Position &target_position, double &x, double &y)
 {
 	// Calculate diff vector from current to target
 	double diff_x, diff_y;
@@ -2744,7 +5936,7 @@ double Position::getRelativeDistance(Position target_position, double &x, double
 	return sign * sqrt((x * x) + (y * y));
 }
 
-bool Position::IsAheadOf(Position target_position)
+bool Position::IsAheadOf(Position &target_position)
 {
 	// Calculate diff vector from current to target
 	double diff_x, diff_y;
@@ -2763,6 +5955,10 @@ bool Position::IsAheadOf(Position target_position)
 
 int Position::GetSteeringTargetPos(double lookahead_distance, double *target_pos_local, double *target_pos_global, double *angle, double *curvature)
 {
+	// Evaluate current position before copying, so that it is not evaluated by the copy only
+	EnsureTrackPos();
+	EnsureXYZ();
+
 	Position target(*this);  // Make a copy of current position
 	target.offset_ = 0.0;  // Fix to lane center
 
@@ -2815,8 +6011,12 @@ int Position::SetRoutePosition(Position *position)
 		{
 			// Update current position 
 			Route *tmp = route_;  // save route pointer, copy the 
+			std::minstd_rand random_generator = random_generator_;
+			bool random_seeded = random_seeded_;
 			*this = *position;
 			route_ = tmp;
+			random_generator_ = random_generator;
+			random_seeded_ = random_seeded;
 			return 0;
 		}
 	}
@@ -2845,7 +6045,7 @@ int Position::SetRouteLanePosition(double route_s, int laneId, double  laneOffse
 	SetRouteLaneOffset(route_s);
 
 	// Override lane data
-	SetLanePos(track_id_, laneId, s_, laneOffset);
+	SetLanePos(GetTrackId(), laneId, GetS(), laneOffset);
 
 	return 0;
 }
@@ -2909,7 +6109,8 @@ int Route::AddWaypoint(Position *position)
 				if (connecting_road_id != 0)
 				{
 					// Adding waypoint for junction connecting road
-					Position *connected_pos = new Position(connecting_road_id, connecting_lane_id, 0, 0);
+					Position *connected_pos = new Position(position->GetOpenDrive());
+					connected_pos->SetLanePos(connecting_road_id, connecting_lane_id, 0, 0);
 					waypoint_.push_back(connected_pos);
 					LOG("Route::AddWaypoint Added connecting waypoint %d: %d, %d, %.2f\n",
 						(int)waypoint_.size() - 1, connecting_road_id, connecting_lane_id, 0.0);
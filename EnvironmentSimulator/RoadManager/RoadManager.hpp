@@ -17,10 +17,134 @@
 #include <string>
 #include <vector>
 #include <list>
+#include <unordered_map>
+#include <random>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <type_traits>
 #include "pugixml.hpp"
 
 namespace roadmanager
 {
+	// Reads and writes the compiled road network cache, see OpenDrive::SetCacheDir()
+	class OpenDriveCache;
+
+	// Default size of the memory blocks of the arena allocator
+	#define ARENA_BLOCK_SIZE (64 * 1024)
+
+	/**
+	Objects that need no destruction when created in an arena, since all their memory is taken from 
+	the arena, see ArenaAllocator. Specialized for such classes.
+	*/
+	template<class T> struct ArenaReleased : std::is_trivially_destructible<T> {};
+
+	/**
+	Region (bump) allocator. Objects are placed one after the other in large memory blocks, 
+	and they are all released at once by Clear() or when the arena is destroyed. Objects that hold
+	other memory than from the arena are destructed first, in reverse order of creation.
+	*/
+	class Arena
+	{
+	public:
+		Arena(size_t block_size = ARENA_BLOCK_SIZE) : block_size_(block_size), used_(block_size), dtor_list_(0), size_(0) {}
+		~Arena() { Clear(); }
+
+		/**
+		Create an object in the arena. It must not be deleted, it lives until the arena is cleared.
+		@param args Arguments passed on to the constructor of T
+		*/
+		template<class T, class... Args> T *New(Args&&... args)
+		{
+			T *obj = new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+			if (!ArenaReleased<T>::value)
+			{
+				DtorEntry *entry = new (Allocate(sizeof(DtorEntry), alignof(DtorEntry))) DtorEntry;
+				entry->dtor_ = &Destruct<T>;
+				entry->obj_ = obj;
+				entry->next_ = dtor_list_;
+				dtor_list_ = entry;
+			}
+			return obj;
+		}
+
+		/**
+		Allocate raw memory, released with the arena
+		@param size Number of bytes
+		@param alignment Alignment of the memory, power of two
+		*/
+		void *Allocate(size_t size, size_t alignment);
+
+		/**
+		Destruct objects that need it and release the memory blocks
+		*/
+		void Clear();
+
+		/**
+		Get the total number of bytes allocated from the arena
+		*/
+		size_t GetSize() { return size_; }
+
+	private:
+		typedef struct DtorEntry
+		{
+			void(*dtor_)(void *obj);
+			void *obj_;
+			DtorEntry *next_;
+		} DtorEntry;
+
+		template<class T> static void Destruct(void *obj) { static_cast<T*>(obj)->~T(); }
+
+		Arena(const Arena&) = delete;
+		Arena &operator=(const Arena&) = delete;
+
+		std::vector<char*> block_;
+		size_t block_size_;
+		size_t used_;  // number of bytes used in the last block
+		DtorEntry *dtor_list_;  // objects to destruct, latest first
+		size_t size_;
+	};
+
+	/**
+	Standard library allocator taking memory from an arena, for containers of objects created in the arena. 
+	Deallocation does nothing, memory is released with the arena. Memory of a growing container is not 
+	reused, so reserve its size when known. Without arena, e.g. for objects created on the stack, it 
+	falls back to the heap.
+	*/
+	template<class T> class ArenaAllocator
+	{
+	public:
+		typedef T value_type;
+		typedef std::true_type propagate_on_container_copy_assignment;
+		typedef std::true_type propagate_on_container_move_assignment;
+		typedef std::true_type propagate_on_container_swap;
+
+		ArenaAllocator(Arena *arena = 0) noexcept : arena_(arena) {}
+		template<class U> ArenaAllocator(const ArenaAllocator<U> &other) noexcept : arena_(other.GetArena()) {}
+
+		T *allocate(size_t n)
+		{
+			return arena_ ? (T*)arena_->Allocate(n * sizeof(T), alignof(T)) : std::allocator<T>().allocate(n);
+		}
+		void deallocate(T *p, size_t n)
+		{
+			if (arena_ == 0)
+			{
+				std::allocator<T>().deallocate(p, n);
+			}
+		}
+		Arena *GetArena() const { return arena_; }
+
+		template<class U> bool operator==(const ArenaAllocator<U> &other) const { return arena_ == other.GetArena(); }
+		template<class U> bool operator!=(const ArenaAllocator<U> &other) const { return arena_ != other.GetArena(); }
+
+	private:
+		Arena *arena_;
+	};
+
+	template<class T> using ArenaVector = std::vector<T, ArenaAllocator<T> >;
+	typedef std::basic_string<char, std::char_traits<char>, ArenaAllocator<char> > ArenaString;
 
 	class Polynomial
 	{
@@ -42,12 +166,21 @@ namespace roadmanager
 		double EvaluatePrim(double s);
 		double EvaluatePrimPrim(double s);
 
+		/**
+		Find the largest absolute value of the polynomial within an interval
+		@param s0 start of interval
+		@param s1 end of interval
+		*/
+		double EvaluateAbsMax(double s0, double s1);
+
 	private:
 		double a_;
 		double b_;
 		double c_;
 		double d_;
 		double s_max_;
+
+		friend class OpenDriveCache;
 	};
 
 
@@ -67,7 +200,6 @@ namespace roadmanager
 		Geometry() : s_(0.0), x_(0.0), y_(0), hdg_(0), length_(0), type_(GEOMETRY_TYPE_UNKNOWN) {}
 		Geometry(double s, double x, double y, double hdg, double length, GeometryType type) :
 			s_(s), x_(x), y_(y), hdg_(hdg), length_(length), type_(type) {}
-		virtual ~Geometry() {}
 
 		GeometryType GetType() { return type_; }
 		double GetLength() { return length_; }
@@ -75,9 +207,40 @@ namespace roadmanager
 		double GetY() { return y_; }
 		double GetHdg() { return hdg_; }
 		double GetS() { return s_; }
-		virtual double EvaluateCurvatureDS(double ds) = 0;
-		virtual void Print();
-		virtual void EvaluateDS(double ds, double *x, double *y, double *h);
+
+		// Geometry functions are not virtual. Instead they dispatch on the geometry type to the 
+		// corresponding function of the specific geometry class, which can then be inlined.
+		double EvaluateCurvatureDS(double ds);
+		void Print();
+		void EvaluateDS(double ds, double *x, double *y, double *h);
+
+		/**
+		Upper bound of the absolute curvature along the geometry, derived from its parameters. Exact for 
+		lines, arcs and spirals.
+		*/
+		double GetCurvatureBound();
+
+		/**
+		Evaluate position and heading at multiple points along the geometry, e.g. for tessellation.
+		Gives same result as EvaluateDS() for each point.
+		@param n Number of points
+		@param ds Distance along the geometry, from its start, for each point
+		@param x Resulting x coordinates, array of n elements
+		@param y Resulting y coordinates, array of n elements
+		@param h Resulting headings, array of n elements
+		*/
+		void EvaluateDSBatch(int n, const double *ds, double *x, double *y, double *h);
+
+		/**
+		Find the point of the geometry closest to a given point, i.e. where the geometry is perpendicular
+		to the line to the point. Exact for lines and arcs. Other geometries are refined iteratively,
+		starting from projection on the chord, until the change in ds is below tolerance.
+		@param x X coordinate of the point
+		@param y Y coordinate of the point
+		@param tolerance Max error (m) in ds of iterative refinement
+		@return Distance along the geometry, from its start, of the closest point. Within [0, length].
+		*/
+		double FindClosestDS(double x, double y, double tolerance);
 
 	private:
 		double s_;
@@ -86,6 +249,8 @@ namespace roadmanager
 		double hdg_;
 		double length_;
 		GeometryType type_;
+
+		friend class OpenDriveCache;
 	};
 
 
@@ -97,7 +262,10 @@ namespace roadmanager
 
 		void Print();
 		void EvaluateDS(double ds, double *x, double *y, double *h);
+		void EvaluateDSBatch(int n, const double *ds, double *x, double *y, double *h);
+		double FindClosestDS(double x, double y, double tolerance);
 		double EvaluateCurvatureDS(double ds) { (void)ds; return 0; }
+		double GetCurvatureBound() { return 0; }
 	};
 
 
@@ -109,12 +277,17 @@ namespace roadmanager
 		~Arc() {}
 
 		double EvaluateCurvatureDS(double ds) { (void)ds; return curvature_; }
+		double GetCurvatureBound() { return std::fabs(curvature_); }
 		double GetRadius() { return std::fabs(1.0 / curvature_); }
 		void Print();
 		void EvaluateDS(double ds, double *x, double *y, double *h);
+		void EvaluateDSBatch(int n, const double *ds, double *x, double *y, double *h);
+		double FindClosestDS(double x, double y, double tolerance);
 
 	private:
 		double curvature_;
+
+		friend class OpenDriveCache;
 	};
 
 
@@ -123,8 +296,9 @@ namespace roadmanager
 	public:
 		Spiral(double s, double x, double y, double hdg, double length, double curv_start, double curv_end) :
 			Geometry(s, x, y, hdg, length, GEOMETRY_TYPE_SPIRAL),
-			curv_start_(curv_start), curv_end_(curv_end), c_dot_(0.0), x0_(0.0), y0_(0.0), h0_(0.0), s0_(0.0) {}
-		~Spiral() {};
+			curv_start_(curv_start), curv_end_(curv_end), c_dot_(0.0), x0_(0.0), y0_(0.0), h0_(0.0), s0_(0.0), 
+			backwards_(false), x_end_(0.0), y_end_(0.0), h_end_(0.0), cos_h0_(1.0), sin_h0_(0.0), 
+			cos_h_start_(1.0), sin_h_start_(0.0), table_ds_(0.0) {}
 
 		double GetCurvStart() { return curv_start_; }
 		double GetCurvEnd() { return curv_end_; }
@@ -140,9 +314,25 @@ namespace roadmanager
 		void SetCDot(double c_dot) { c_dot_ = c_dot; }
 		void Print();
 		void EvaluateDS(double ds, double *x, double *y, double *h);
+		void EvaluateDSBatch(int n, const double *ds, double *x, double *y, double *h);
+		double FindClosestDS(double x, double y, double tolerance);
 		double EvaluateCurvatureDS(double ds);
+		double GetCurvatureBound();
+
+		/**
+		Calculate constants and lookup table used by EvaluateDS. Call once the spiral parameters 
+		(S0, X0, Y0, H0 and CDot) have been set.
+		@param arena Where to allocate the lookup table, e.g. the one of the road. 0 means heap.
+		*/
+		void Prepare(Arena *arena = 0);
 
 	private:
+		/**
+		Evaluate the standard spiral, starting at curvature 0, by lookup table if available else 
+		by Fresnel integrals (odrSpiral). See SPIRAL_TABLE_MAX_ERROR for accuracy of the table.
+		*/
+		void EvaluateStandardSpiral(double s, double *x, double *y, double *t);
+
 		double curv_start_;
 		double curv_end_;
 		double c_dot_;
@@ -150,6 +340,18 @@ namespace roadmanager
 		double y0_; // 0 if spiral starts with curvature = 0
 		double h0_; // 0 if spiral starts with curvature = 0
 		double s0_; // 0 if spiral starts with curvature = 0
+		bool backwards_;  // true if curvature decreases along the spiral
+		double x_end_;  // end point of standard spiral segment, for backwards evaluation
+		double y_end_;
+		double h_end_;
+		double cos_h0_;  // cos(-h0)
+		double sin_h0_;  // sin(-h0)
+		double cos_h_start_;  // rotation of spiral segment to road heading
+		double sin_h_start_;
+		double table_ds_;  // step length of lookup table, 0 if no table
+		ArenaVector<double> table_;  // x, y, dx/ds, dy/ds of standard spiral at steps of table_ds_ from s0
+
+		friend class OpenDriveCache;
 	};
 
 
@@ -168,12 +370,17 @@ namespace roadmanager
 		double GetUMax() { return umax_; }
 		void Print();
 		void EvaluateDS(double ds, double *x, double *y, double *h);
+		void EvaluateDSBatch(int n, const double *ds, double *x, double *y, double *h);
+		double FindClosestDS(double x, double y, double tolerance);
 		double EvaluateCurvatureDS(double ds);
+		double GetCurvatureBound();
 
 		Polynomial poly3_;
 
 	private:
 		double umax_;
+
+		friend class OpenDriveCache;
 	};
 
 
@@ -200,13 +407,52 @@ namespace roadmanager
 		double GetPRange() { return p_range_; }
 		void Print();
 		void EvaluateDS(double ds, double *x, double *y, double *h);
+		void EvaluateDSBatch(int n, const double *ds, double *x, double *y, double *h);
+		double FindClosestDS(double x, double y, double tolerance);
 		double EvaluateCurvatureDS(double ds);
+		double GetCurvatureBound();
 
 		Polynomial poly3U_;
 		Polynomial poly3V_;
 
 	private:
 		int p_range_;
+
+		friend class OpenDriveCache;
+	};
+
+	/**
+	Holds a geometry of any type, for storing all geometries of a road in one contiguous array
+	*/
+	class GeometryRecord
+	{
+	public:
+		GeometryRecord(const Line &line);
+		GeometryRecord(const Arc &arc);
+		GeometryRecord(const Spiral &spiral);
+		GeometryRecord(const Poly3 &poly3);
+		GeometryRecord(const ParamPoly3 &param_poly3);
+		GeometryRecord(const GeometryRecord &other);
+		GeometryRecord(GeometryRecord &&other) noexcept;  // moves the spiral table, e.g. when the array grows
+		GeometryRecord &operator=(const GeometryRecord &other);
+		~GeometryRecord();
+
+		Geometry *GetGeometry();
+
+	private:
+		void Copy(const GeometryRecord &other);
+		void Move(GeometryRecord &other);
+		void Destroy();
+
+		Geometry::GeometryType type_;
+		union
+		{
+			Line line_;
+			Arc arc_;
+			Spiral spiral_;
+			Poly3 poly3_;
+			ParamPoly3 param_poly3_;
+		};
 	};
 
 
@@ -228,6 +474,8 @@ namespace roadmanager
 	private:
 		double s_;
 		double length_;
+
+		friend class OpenDriveCache;
 	};
 
 	typedef enum 
@@ -251,6 +499,8 @@ namespace roadmanager
 	private:
 		LinkType type_;
 		int id_;
+
+		friend class OpenDriveCache;
 	};
 
 	class LaneWidth
@@ -268,6 +518,8 @@ namespace roadmanager
 
 	private:
 		double s_offset_;
+
+		friend class OpenDriveCache;
 	};
 
 	class LaneOffset
@@ -289,12 +541,15 @@ namespace roadmanager
 		double GetLength() { return length_; }
 		double GetLaneOffset(double s);
 		double GetLaneOffsetPrim(double s);
+		double GetLaneOffsetAbsMax(double s0, double s1) { return polynomial_.EvaluateAbsMax(s0 - s_, s1 - s_); }
 		void Print();
 
 	private:
 		Polynomial polynomial_;
 		double s_;
 		double length_;
+
+		friend class OpenDriveCache;
 	};
 
 	class Lane
@@ -332,15 +587,24 @@ namespace roadmanager
 			LANE_TYPE_ON_RAMP,
 		};
 
-		Lane(int id, Lane::LaneType type) : id_(id), type_(type), level_(1), offset_from_ref_(0) {}
+		Lane(int id, Lane::LaneType type, Arena *arena = 0) : id_(id), type_(type), level_(1), offset_from_ref_(0),
+			link_(arena), lane_width_(arena), lane_width_s_(arena) {}
 		void AddLink(LaneLink *lane_link) { link_.push_back(lane_link); }
 		int GetId() { return id_; }
 		LaneWidth *GetWidthByIndex(int index) { return lane_width_[index]; }
+		int GetNumberOfLaneWidths() { return (int)lane_width_.size(); }
 		LaneWidth *GetWidthByS(double s);
+
+		/**
+		Get index of the lane width record valid at specified s
+		@param s distance along the lane section, relative to its start
+		@param hint_idx Index to check first, e.g. from previous lookup. Ignored if < 0.
+		*/
+		int GetWidthIdxByS(double s, int hint_idx = -1);
 		LaneLink *GetLink(LinkType type);
 		void SetOffsetFromRef(double offset) { offset_from_ref_ = offset; }
 		double GetOffsetFromRef() { return offset_from_ref_; }
-		void AddLaneWIdth(LaneWidth *lane_width) { lane_width_.push_back(lane_width); }
+		void AddLaneWIdth(LaneWidth *lane_width);
 		int IsDriving();
 		void Print();
 
@@ -349,15 +613,24 @@ namespace roadmanager
 		LaneType type_;
 		int level_;	// boolean, true = keep lane on level
 		double offset_from_ref_;
-		std::vector<LaneLink*> link_;
-		std::vector<LaneWidth*> lane_width_;
+		ArenaVector<LaneLink*> link_;
+		ArenaVector<LaneWidth*> lane_width_;
+		ArenaVector<double> lane_width_s_;  // s offset of each lane width record, for fast lookup
+
+		friend class OpenDriveCache;
 	};
 
 	class LaneSection
 	{
 	public:
-		LaneSection(double s) : s_(s), length_(0) {}
+		LaneSection(double s, Arena *arena = 0) : s_(s), length_(0), serial_(serial_counter_++), 
+			lane_(arena), lane_order_(arena), inner_lane_idx_(arena) {}
 		void AddLane(Lane *lane);
+
+		/**
+		Unique number of the lane section instance, e.g. for identification of cached lane section data
+		*/
+		int GetSerial() { return serial_; }
 		double GetS() { return s_; }
 		Lane* GetLaneByIdx(int idx);
 		Lane* GetLaneById(int id);
@@ -373,6 +646,21 @@ namespace roadmanager
 		@param lane_id lane specifier, starting from center -1, -2, ... is on the right side, 1, 2... on the left 
 		*/
 		double GetCenterOffset(double s, int lane_id);
+
+		/**
+		Evaluate outer offset of all lanes at once, summing up lane widths from the reference lane 
+		and outwards. Each value equals the result of GetOuterOffset() for corresponding lane. 
+		@param s distance along the road segment
+		@param outer_offset Array of at least GetNumberOfLanes() elements, receiving the offset of each lane by index
+		*/
+		void GetOuterOffsets(double s, double *outer_offset);
+
+		/**
+		Get lateral position of lane center, from road reference lane, given outer offsets of all lanes
+		@param outer_offset Outer offset of all lanes, as returned by GetOuterOffsets()
+		@param lane_idx Lane index, see GetLaneByIdx()
+		*/
+		double GetCenterOffsetFromOuterOffsets(double *outer_offset, int lane_idx);
 		double GetOuterOffsetHeading(double s, int lane_id);
 		double GetCenterOffsetHeading(double s, int lane_id);
 		double GetLength() { return length_; }
@@ -388,7 +676,13 @@ namespace roadmanager
 	private:
 		double s_;
 		double length_;
-		std::vector<Lane*> lane_;
+		int serial_;
+		ArenaVector<Lane*> lane_;
+		ArenaVector<int> lane_order_;  // lane indices, in order of increasing distance from reference lane
+		ArenaVector<int> inner_lane_idx_;  // per lane index, index of closest lane towards reference lane, or -1
+		static std::atomic<int> serial_counter_;
+
+		friend class OpenDriveCache;
 	};
 
 	enum ContactPointType
@@ -426,6 +720,8 @@ namespace roadmanager
 		int element_id_;
 		ElementType element_type_;
 		ContactPointType contact_point_type_;
+
+		friend class OpenDriveCache;
 	};
 
 	struct LaneInfo
@@ -437,16 +733,26 @@ namespace roadmanager
 	class Road
 	{
 	public:
-		Road(int id, std::string name) : id_(id), name_(name), length_(0) {}
-		~Road();
+		/**
+		@param arena Arena which the road is created in, where its sub elements are allocated. 0 means heap.
+		*/
+		Road(int id, std::string name, Arena *arena = 0) : id_(id), name_(name.c_str(), arena), length_(0), max_curvature_(0),
+			link_(arena), geometry_(arena), elevation_profile_(arena), lane_section_(arena), lane_offset_(arena), 
+			geometry_s_(arena), elevation_s_(arena), lane_section_s_(arena), lane_offset_s_(arena) {}
 
 		void Print();
 		void SetI(int id) { id_ = id; }
 		int GetId() { return id_; }
-		void SetName(std::string name) { name_ = name; }
+		void SetName(std::string name) { name_.assign(name.c_str(), name.size()); }
 		Geometry *GetGeometry(int idx);
 		int GetNumberOfGeometries() { return (int)geometry_.size(); }
 
+		/**
+		Upper bound of the absolute curvature of the road reference line, see Geometry::GetCurvatureBound().
+		Known also when the road content is not loaded, see OpenDrive::LoadOpenDriveFileTiled().
+		*/
+		double GetMaxCurvature() { return max_curvature_; }
+
 		/** 
 		Retrieve the lanesection specified by vector element index (idx)
 		useful for iterating over all available lane sections, e.g:
@@ -464,6 +770,30 @@ namespace roadmanager
 		*/
 		LaneSection *GetLaneSectionByS(double s);
 
+		/**
+		Lookup of piecewise road elements by s-value. Binary search, or constant time in case
+		s is within the hinted element or the one following it.
+		@param s distance along the road segment
+		@param hint_idx Index to check first, e.g. from previous lookup. Ignored if < 0.
+		@return index of the element valid at s, or -1 if there are no elements
+		*/
+		int GetLaneSectionIdxByS(double s, int hint_idx = -1);
+		int GetGeometryIdxByS(double s, int hint_idx = -1);
+		int GetElevationIdxByS(double s, int hint_idx = -1);
+		int GetLaneOffsetIdxByS(double s, int hint_idx = -1);
+
+		/**
+		Evaluate position and heading of the road reference line at multiple s-values, e.g. for 
+		tessellation. Consecutive s-values on the same geometry are evaluated in batches, hence
+		s-values in increasing order gives best performance. Lane offset is not applied.
+		@param n Number of points
+		@param s Distance along the road segment for each point
+		@param x Resulting x coordinates, array of n elements
+		@param y Resulting y coordinates, array of n elements
+		@param h Resulting headings, array of n elements
+		*/
+		void EvaluateSBatch(int n, const double *s, double *x, double *y, double *h);
+
 		/**
 		Get lateral position of lane center, from road reference lane (lane id=0)
 		Example: If lane id 1 is 5 m wide and lane id 2 is 4 m wide, then
@@ -475,18 +805,18 @@ namespace roadmanager
 
 		LaneInfo GetLaneInfoByS(double s, int start_lane_link_idx, int start_lane_id);
 		int GetNumberOfLaneSections() { return (int)lane_section_.size(); }
-		std::string GetName() { return name_; }
+		std::string GetName() { return std::string(name_.c_str(), name_.size()); }
 		void SetLength(double length) { length_ = length; }
 		double GetLength() { return length_; }
 		void SetJunction(int junction) { junction_ = junction; }
 		int GetJunction() { return junction_; }
 		void AddLink(RoadLink *link) { link_.push_back(link); }
 		RoadLink *GetLink(LinkType type);
-		void AddLine(Line *line);
-		void AddArc(Arc *arc);
-		void AddSpiral(Spiral *spiral);
-		void AddPoly3(Poly3 *poly3);
-		void AddParamPoly3(ParamPoly3 *param_poly3);
+		void AddLine(const Line &line);
+		void AddArc(const Arc &arc);
+		void AddSpiral(const Spiral &spiral);
+		void AddPoly3(const Poly3 &poly3);
+		void AddParamPoly3(const ParamPoly3 &param_poly3);
 		void AddElevation(Elevation *elevation);
 		void AddLaneSection(LaneSection *lane_section);
 		void AddLaneOffset(LaneOffset *lane_offset);
@@ -496,37 +826,189 @@ namespace roadmanager
 		double GetLaneOffsetPrim(double s);
 		int GetNumberOfLanes(double s);
 
+		/**
+		Get an upper limit of the absolute lane offset within an s interval
+		@param s0 start of interval
+		@param s1 end of interval
+		*/
+		double GetLaneOffsetAbsMax(double s0, double s1);
+
+		/**
+		Get an upper limit of the lateral extent of the lanes, i.e. the summed lane widths 
+		on the widest side of the reference lane, within an s interval
+		@param s0 start of interval
+		@param s1 end of interval
+		*/
+		double GetLanesWidthAbsMax(double s0, double s1);
+
 	protected:
 		int id_;
-		std::string name_;
+		ArenaString name_;
 		double length_;
 		int junction_;
-		std::vector<RoadLink*> link_;
-		std::vector<Geometry*> geometry_;
-		std::vector<Elevation*> elevation_profile_;
-		std::vector<LaneSection*> lane_section_;
-		std::vector<LaneOffset*> lane_offset_;
+		double max_curvature_;  // bound of all geometries
+		ArenaVector<RoadLink*> link_;
+		ArenaVector<GeometryRecord> geometry_;
+		ArenaVector<Elevation*> elevation_profile_;
+		ArenaVector<LaneSection*> lane_section_;
+		ArenaVector<LaneOffset*> lane_offset_;
+
+		// Start s-value of each element above, for fast lookup by s
+		ArenaVector<double> geometry_s_;
+		ArenaVector<double> elevation_s_;
+		ArenaVector<double> lane_section_s_;
+		ArenaVector<double> lane_offset_s_;
+
+		friend class OpenDriveCache;
+		friend class RoadCursor;
+	};
+
+	// Number of recurrence steps of RoadCursor between exact evaluations of the road geometry
+	#define ROAD_CURSOR_ANCHOR_INTERVAL 64
+
+	/**
+	Cursor for stepping along a road, e.g. when tessellating lanes or moving in small steps. Keeps 
+	current geometry, lane section, lane offset and elevation indices, so that each step only checks 
+	the current and next element. Repeated steps of same length on lines and arcs are evaluated by 
+	recurrence, i.e. rotation of the heading, instead of trigonometric functions. Every 
+	ROAD_CURSOR_ANCHOR_INTERVAL steps, and on entering a new geometry, the position is evaluated 
+	exactly to bound the accumulated rounding error.
+	*/
+	class RoadCursor
+	{
+	public:
+		RoadCursor() : road_(0), s_(0), x_(0), y_(0), h_(0), cos_h_(1), sin_h_(0), z_(0), p_(0), 
+			lane_offset_(0), lane_offset_prim_(0), geometry_idx_(-1), lane_section_idx_(-1), 
+			elevation_idx_(-1), lane_offset_idx_(-1), step_(0), chord_(0), cos_half_(1), sin_half_(0), 
+			step_h_(0), cos_step_(1), sin_step_(0), n_steps_(0) {}
+
+		/**
+		Place the cursor on a road, evaluating the position exactly
+		@param road The road
+		@param s Distance along the road, clamped to [0, road length]
+		*/
+		void Set(Road *road, double s);
+
+		/**
+		Move the cursor along the road. Recurrence is used if the step length equals the previous one, 
+		within SMALL_NUMBER, and the cursor stays on the same line or arc geometry.
+		@param s Distance along the road, clamped to [0, road length]
+		*/
+		void MoveTo(double s);
+
+		/**
+		Move the cursor a distance along the road, see MoveTo()
+		@param ds Step length, negative value moves towards the road start
+		*/
+		void Step(double ds) { MoveTo(s_ + ds); }
+
+		Road *GetRoad() { return road_; }
+		double GetS() { return s_; }
+		// Position, heading and pitch of road reference line in road direction, lane offset not applied
+		double GetX() { return x_; }
+		double GetY() { return y_; }
+		double GetH() { return h_; }
+		double GetZ() { return z_; }
+		double GetP() { return p_; }
+		double GetLaneOffset() { return lane_offset_; }
+		int GetGeometryIdx() { return geometry_idx_; }
+		int GetLaneSectionIdx() { return lane_section_idx_; }
+		int GetElevationIdx() { return elevation_idx_; }
+		int GetLaneOffsetIdx() { return lane_offset_idx_; }
+
+		/**
+		Get position of a point in a lane at current s, same as Position::SetLanePos() would give
+		@param lane_id Lane specifier, 0 is the reference lane
+		@param offset Lateral offset from lane center
+		@param x Resulting x coordinate
+		@param y Resulting y coordinate
+		@param h Resulting heading, in driving direction of the lane
+		*/
+		void GetLanePos(int lane_id, double offset, double *x, double *y, double *h);
+
+	private:
+		void Anchor(double step);
+		void UpdateProfiles();
+
+		Road *road_;
+		double s_;
+		double x_;
+		double y_;
+		double h_;
+		double cos_h_;
+		double sin_h_;
+		double z_;
+		double p_;
+		double lane_offset_;
+		double lane_offset_prim_;
+		int geometry_idx_;
+		int lane_section_idx_;
+		int elevation_idx_;
+		int lane_offset_idx_;
+
+		// Recurrence of steps on lines and arcs, valid if step_ != 0
+		double step_;  // step length
+		double chord_;  // distance between step end points
+		double cos_half_;  // rotation of chord relative heading, i.e. half of heading change
+		double sin_half_;
+		double step_h_;  // heading change of each step
+		double cos_step_;
+		double sin_step_;
+		int n_steps_;  // steps since last exact evaluation
 	};
 
 	class LaneRoadLaneConnection
 	{
 	public:
-		LaneRoadLaneConnection() :
-			lane_id_(0), connecting_road_id_(-1), connecting_lane_id_(0) {}
-		LaneRoadLaneConnection(int lane_id, int connecting_road_id, int connecting_lane_id) :
-			lane_id_(lane_id), connecting_road_id_(connecting_road_id), connecting_lane_id_(connecting_lane_id) {}
+		typedef enum
+		{
+			TURN_LEFT,
+			TURN_STRAIGHT,
+			TURN_RIGHT,
+		} TurnType;
+
+		LaneRoadLaneConnection() : contact_point_(CONTACT_POINT_UNKNOWN), 
+			road_id_(-1), lane_id_(0), connecting_road_id_(-1), connecting_lane_id_(0), turn_(TURN_STRAIGHT), exit_heading_(0), turn_angle_(0) {}
+		LaneRoadLaneConnection(int lane_id, int connecting_road_id, int connecting_lane_id) : contact_point_(CONTACT_POINT_UNKNOWN),
+			road_id_(-1), lane_id_(lane_id), connecting_road_id_(connecting_road_id), connecting_lane_id_(connecting_lane_id), 
+			turn_(TURN_STRAIGHT), exit_heading_(0), turn_angle_(0) {}
+		void SetRoad(int id) { road_id_ = id; }
 		void SetLane(int id) { lane_id_ = id; }
 		void SetConnectingRoad(int id) { connecting_road_id_ = id; }
 		void SetConnectingLane(int id) { connecting_lane_id_ = id; }
+		int GetRoadId() { return road_id_; }
 		int GetLaneId() { return lane_id_; }
 		int GetConnectingRoadId() { return connecting_road_id_; }
 		int GetConnectinglaneId() { return connecting_lane_id_; }
 
+		/**
+		Classification of the connection by the heading change along the connecting road
+		*/
+		TurnType GetTurnType() { return turn_; }
+
+		/**
+		Heading change (rad) along the connecting road, in driving direction. Positive to the left.
+		*/
+		double GetTurnAngle() { return turn_angle_; }
+
+		/**
+		Heading (rad) of the connecting road reference line where leaving the junction
+		*/
+		double GetExitHeading() { return exit_heading_; }
+
 		ContactPointType contact_point_;
 	private:
+		int road_id_;
 		int lane_id_;
 		int connecting_road_id_;
 		int connecting_lane_id_;
+		TurnType turn_;
+		double exit_heading_;
+		double turn_angle_;
+
+		friend class Junction;
+
+		friend class OpenDriveCache;
 	};
 
 	class JunctionLaneLink
@@ -541,10 +1023,9 @@ namespace roadmanager
 	class Connection
 	{
 	public:
-		Connection(Road *incoming_road, Road *connecting_road, ContactPointType contact_point);
-		~Connection();
+		Connection(Road *incoming_road, Road *connecting_road, ContactPointType contact_point, Arena *arena = 0);
 		int GetNumberOfLaneLinks() { return (int)lane_link_.size(); }
-		JunctionLaneLink *GetLaneLink(int idx) { return lane_link_[idx]; }
+		JunctionLaneLink *GetLaneLink(int idx) { return &lane_link_[idx]; }
 		int GetConnectingLaneId(int incoming_lane_id);
 		Road *GetIncomingRoad() { return incoming_road_; }
 		Road *GetConnectingRoad() { return connecting_road_; }
@@ -556,9 +1037,13 @@ namespace roadmanager
 		Road *incoming_road_;
 		Road *connecting_road_;
 		ContactPointType contact_point_;
-		std::vector<JunctionLaneLink*> lane_link_;
+		ArenaVector<JunctionLaneLink> lane_link_;
+
+		friend class OpenDriveCache;
 	};
 
+	class OpenDrive;
+
 	class Junction
 	{
 	public:
@@ -568,32 +1053,236 @@ namespace roadmanager
 			STRAIGHT,
 		} JunctionStrategyType;
 
-		Junction(int id, std::string name) : id_(id), name_(name) {}
-		~Junction();
+		Junction(int id, std::string name, Arena *arena = 0) : connection_(arena), lane_connection_(arena), id_(id), name_(name.c_str(), arena) {}
 		int GetId() { return id_; }
-		std::string GetName() { return name_; }
+		std::string GetName() { return std::string(name_.c_str(), name_.size()); }
 		int GetNumberOfConnections() { return (int)connection_.size(); }
 		int GetNumberOfRoadConnections(int roadId, int laneId);
 		LaneRoadLaneConnection GetRoadConnectionByIdx(int roadId, int laneId, int idx);
+
+		/**
+		Get all connections from a lane of an incoming road, in order of connections and lane links
+		@param roadId ID of the incoming road
+		@param laneId ID of the incoming lane
+		@param n_connections Number of connections found
+		@return Pointer to the first connection, valid until the junction is changed
+		*/
+		LaneRoadLaneConnection *GetRoadConnections(int roadId, int laneId, int &n_connections);
+
+		/**
+		Find the connection of specified turn type from a lane of an incoming road. If several, the one 
+		with turn angle closest to 0 (straight), +90 (left) or -90 (right) degrees is chosen.
+		@return Index of the connection, as for GetRoadConnectionByIdx(), or -1 if none of the type
+		*/
+		int GetRoadConnectionIdxByTurn(int roadId, int laneId, LaneRoadLaneConnection::TurnType turn);
+
 		void AddConnection(Connection *connection) { connection_.push_back(connection); }
 		Connection *GetConnectionByIdx(int idx) { return connection_[idx]; }
+
+		/**
+		Precompute the table of lane connections, see GetRoadConnections(). Needs to be called 
+		when all connections are added and all involved roads are loaded.
+		@param od Road network of the junction
+		*/
+		void BuildConnectionTable(OpenDrive *od);
 		void Print();
 	
 	private:
-		std::vector<Connection*> connection_;
+		ArenaVector<Connection*> connection_;
+		ArenaVector<LaneRoadLaneConnection> lane_connection_;  // sorted by incoming road and lane IDs
 		int id_;
-		std::string name_;
+		ArenaString name_;
+
+		friend class OpenDriveCache;
 	};
 
+	// Memory of these is all taken from the arena they are created in
+	template<> struct ArenaReleased<Lane> : std::true_type {};
+	template<> struct ArenaReleased<LaneSection> : std::true_type {};
+	template<> struct ArenaReleased<Road> : std::true_type {};
+	template<> struct ArenaReleased<Connection> : std::true_type {};
+	template<> struct ArenaReleased<Junction> : std::true_type {};
+
+	/**
+	Uniform grid over the bounding boxes of all road geometries, used for finding candidate
+	geometries close to a world coordinate point. Each bounding box covers the reference line 
+	widened by lane offset and lanes, i.e. any point on the road surface of the geometry.
+	*/
+	class SpatialIndex
+	{
+	public:
+		typedef struct
+		{
+			int road_idx_;
+			int geom_idx_;
+			double x_min_;
+			double y_min_;
+			double x_max_;
+			double y_max_;
+			int cx_min_;  // range of covered grid cells
+			int cy_min_;
+			int cx_max_;
+			int cy_max_;
+		} Entry;
+
+		SpatialIndex() : x0_(0), y0_(0), cell_size_(1), nx_(0), ny_(0) {}
+
+		/**
+		Build the index from all roads currently loaded in the road network
+		*/
+		void Build(OpenDrive *od);
+		void Clear();
+		int GetNumberOfEntries() { return (int)entry_.size(); }
+		Entry *GetEntry(int idx) { return &entry_[idx]; }
+
+		/**
+		Entries are ordered as roads and geometries, so that entry index can be used to
+		reproduce the order of a plain road-by-road, geometry-by-geometry search
+		*/
+		int GetEntryIdx(int road_idx, int geom_idx) { return road_entry_idx_[road_idx] + geom_idx; }
+
+		/**
+		Find the cell containing, or if outside the grid closest to, the specified point
+		*/
+		void GetCell(double x, double y, int &cx, int &cy);
+
+		/**
+		Number of rings needed to cover the complete grid around specified cell
+		*/
+		int GetMaxRing(int cx, int cy);
+
+		/**
+		Collect entries found in the square ring of cells at distance ring (in cells) around cell (cx, cy). 
+		Each entry is reported only once, in the first ring it overlaps.
+		@param entries Vector to fill in with entry indices, not cleared by the function
+		*/
+		void GetRingEntries(int cx, int cy, int ring, std::vector<int> &entries);
+
+		/**
+		Smallest possible distance from a point to any entry not reported in rings 0 to ring around cell (cx, cy)
+		*/
+		double GetRingDistance(double x, double y, int cx, int cy, int ring);
+
+		/**
+		Distance from a point to the bounding box of an entry, zero if inside
+		*/
+		double GetDistLowerBound(int idx, double x, double y);
+
+	private:
+		std::vector<Entry> entry_;
+		std::vector<int> road_entry_idx_;  // index of first entry per road
+		std::vector<int> cell_start_;      // entries of cell i is found at cell_entry_[cell_start_[i]] to cell_entry_[cell_start_[i+1]-1]
+		std::vector<int> cell_entry_;
+		double x0_;
+		double y0_;
+		double cell_size_;
+		int nx_;
+		int ny_;
+
+		friend class OpenDriveCache;
+	};
+
+	/**
+	Lane level connectivity graph of the road network, for route planning. Each node is a driving lane 
+	of a lane section, in its driving direction, i.e. increasing s for right lanes (negative ID) and 
+	decreasing s for left lanes. Edges connect a node to the lanes it leads to, by lane links, road 
+	links and junction lane links, and to neighbouring lanes of same direction (lane change).
+	*/
+	class LaneGraph
+	{
+	public:
+		typedef struct
+		{
+			int road_idx_;
+			int lane_section_idx_;
+			int lane_id_;
+			double length_;
+			double x_;  // reference line point where entering the lane section, for distance estimation
+			double y_;
+			int first_edge_;  // edges of node i are found at edge_[node_[i].first_edge_] to edge_[node_[i + 1].first_edge_ - 1]
+		} Node;
+
+		typedef struct
+		{
+			int to_;
+			double cost_;  // length of the lane section, or lane change cost
+		} Edge;
+
+		LaneGraph() : heuristic_scale_(1.0), search_id_(0) {}
+
+		/**
+		Build the graph from all roads and junctions currently loaded in the road network
+		*/
+		void Build(OpenDrive *od);
+		void Clear();
+		int GetNumberOfNodes() { return (int)node_.size() - 1; }
+		Node *GetNode(int idx) { return &node_[idx]; }
+		Edge *GetEdge(int idx) { return &edge_[idx]; }
+
+		/**
+		Find node of a driving lane
+		@return Node index, -1 if not found, e.g. not a driving lane
+		*/
+		int GetNodeIdx(int road_idx, int lane_section_idx, int lane_id);
+
+		/**
+		Find shortest path between two nodes, by A* search with scaled straight line distance as heuristic, 
+		see Build(). 
+		Length is measured along the road reference lines, from entry of first node to entry of last node.
+		Each lane change adds ROUTE_LANE_CHANGE_COST.
+		@param from Start node index
+		@param to Destination node index
+		@param path Vector to fill in with node indices from start to destination, cleared by the function
+		@param leave_section If true the path must leave the lane section of the start node before reaching 
+		the destination, e.g. when the destination is behind the start in the same lane section
+		@return Length of the path, or -1 if not connected
+		*/
+		double FindPath(int from, int to, std::vector<int> &path, bool leave_section = false);
+
+	private:
+		bool IsLaneChange(int from, int to);
+
+		std::vector<Node> node_;  // ordered by road, lane section and lane. One extra node terminating the edge ranges.
+		std::vector<Edge> edge_;
+		std::vector<int> road_node_idx_;  // index of first node per road
+		double heuristic_scale_;  // factor on straight line distance, keeping the heuristic consistent
+
+		// Search state, valid for nodes where visit_[i] == search_id_
+		std::vector<unsigned int> visit_;
+		std::vector<double> cost_;
+		std::vector<int> prev_;
+		std::vector<bool> closed_;
+		unsigned int search_id_;
+
+		friend class OpenDriveCache;
+	};
+
+	// Cost, in meters, of changing lane when searching shortest routes
+	#define ROUTE_LANE_CHANGE_COST 50.0
+
+	// Default tolerance (m) of finding closest point on road geometries
+	#define CLOSEST_POINT_TOLERANCE 1e-6
+
+	// Default side length of road network tiles, see OpenDrive::LoadOpenDriveFileTiled()
+	#define ODR_TILE_SIZE 1000.0
+
+	// Forward declaration of Position and Route
+	class Position;
+	class Route;
+
 	class OpenDrive
 	{
 	public:
-		OpenDrive() {};
+		OpenDrive() : random_seed_(0), random_seed_set_(false), loader_threads_(1), closest_point_tolerance_(CLOSEST_POINT_TOLERANCE), 
+			max_curvature_(0), tile_cache_(0), tile_memory_budget_(0), tile_clock_(0) {};
 		OpenDrive(const char *filename);
 		~OpenDrive();
 
 		/**
-		Load a road network, specified in the OpenDRIVE file format
+		Load a road network, specified in the OpenDRIVE file format. If a cache directory is set, see 
+		SetCacheDir(), the parsed network, including derived data and indices, is stored in a binary 
+		cache file there. Following loads of the same, unchanged, file will read the cache instead of 
+		parsing the XML. 
 		@param filename OpenDRIVE file
 		@param replace If true any old road data will be erased, else new will be added to the old
 		*/
@@ -604,6 +1293,47 @@ namespace roadmanager
 		*/
 		std::string GetOpenDriveFilename() { return odr_filename_; }
 
+		/**
+		Load a road network for streaming, e.g. when too large to keep in memory. Roads are grouped in 
+		square tiles. Road IDs, links, junctions and the spatial index are always kept in memory, while
+		road content (geometries, elevation, lanes) is loaded per tile by UpdateTiles() or on demand when 
+		the road is accessed. The compiled road network cache is required, and will be created if missing.
+		Without a cache directory, see SetCacheDir(), the complete road network is loaded instead.
+		Note that road lookups, e.g. GetRoadById(), may then load and release tiles. Hence a tiled road 
+		network must not be accessed from several threads at once, not even for reading.
+		@param filename OpenDRIVE file
+		@param tile_size Side length of the tiles (m)
+		*/
+		bool LoadOpenDriveFileTiled(const char *filename, double tile_size = ODR_TILE_SIZE);
+
+		/**
+		Update loaded tiles for a sliding window around a set of points, typically the positions of all 
+		entities. Tiles within radius from any point are loaded. Then the least recently used tiles 
+		are released until memory usage is within the budget, see SetTileMemoryBudget(). Tiles in use,
+		i.e. within the window or accessed since last update, are never released. Road pointers are 
+		valid until next call of UpdateTiles().
+		@param n Number of points
+		@param x X coordinates of the points
+		@param y Y coordinates of the points
+		@param radius Window radius (m) around each point
+		*/
+		void UpdateTiles(int n, const double *x, const double *y, double radius);
+
+		/**
+		Set max memory for loaded tiles, measured as size of road content in the cache. 0 means unlimited.
+		The budget applies to every load, also on demand, and is only exceeded by tiles in use.
+		*/
+		void SetTileMemoryBudget(size_t budget) { tile_memory_budget_ = budget; }
+		size_t GetTileMemoryUsage();
+		int GetNumberOfTiles() { return (int)tile_.size(); }
+		int GetNumberOfLoadedTiles();
+		bool IsTiled() { return tile_cache_ != 0; }
+
+		/**
+		Check whether content of a road is loaded. Always true when not tiled.
+		*/
+		bool IsRoadLoaded(int idx) { return tile_cache_ == 0 || tile_[road_tile_[idx]].loaded_; }
+
 		/**
 		Retrieve a road segment specified by road ID 
 		@param id road ID as specified in the OpenDRIVE file
@@ -627,6 +1357,68 @@ namespace roadmanager
 		Junction* GetJunctionByIdx(int idx);
 		int GetNumOfJunctions() { return (int)junction_.size(); }
 		bool IsConnected(int road1_id, int road2_id, int* &connecting_road_id, int* &connecting_lane_id, int lane1_id = 0, int lane2_id = 0);
+		SpatialIndex *GetSpatialIndex() { return &spatial_index_; }
+		LaneGraph *GetLaneGraph() { return &lane_graph_; }
+
+		/**
+		Find the shortest route along driving lanes between two positions, see LaneGraph::FindPath()
+		@param from Start position, must be in a driving lane
+		@param to Destination position, must be in a driving lane
+		@param route Route to add waypoints to, one per road including junction connecting roads. 
+		The start and destination positions are copied, other waypoints are at the start of the lane 
+		in driving direction. Unlike Route::AddWaypoint() lane changes within a road are allowed, and 
+		junction connecting roads are listed explicitly.
+		@return Length of the route, along reference lines, or -1 if not found
+		*/
+		double FindRoute(Position *from, Position *to, Route *route);
+
+		/**
+		Enable the compiled road network cache, see LoadOpenDriveFile(). Cache files are named by the 
+		OpenDRIVE file (filename + ".cache"), files of equal name in different folders replace each 
+		other's cache. The cache is only used when loading into an empty road network, e.g. when replace
+		is true. Default is disabled.
+		@param cache_dir Existing directory for cache files, empty string disables the cache
+		*/
+		void SetCacheDir(std::string cache_dir) { cache_dir_ = cache_dir; }
+		std::string GetCacheDir() { return cache_dir_; }
+
+		/**
+		Set number of threads for building roads when loading OpenDRIVE files. Result is identical
+		regardless of number of threads. Default is 1, i.e. no parallel loading. 
+		@param n_threads Number of threads
+		*/
+		void SetLoaderThreads(int n_threads) { loader_threads_ = n_threads; }
+
+		/**
+		Set tolerance of finding closest point on road geometries, e.g. when mapping world coordinates to
+		road coordinates, see Geometry::FindClosestDS(). 0 means approximation by projection on the chord 
+		of the geometry, which is faster but less accurate on long curved geometries.
+		@param tolerance Max error (m) along the geometry
+		*/
+		void SetClosestPointTolerance(double tolerance) { closest_point_tolerance_ = tolerance; }
+		double GetClosestPointTolerance() { return closest_point_tolerance_; }
+
+		/**
+		Draw the next number of the random number generator of this road network. Seeds the generators 
+		of positions not seeded explicitly, see Position::SetRandomSeed(). Safe to call from several 
+		threads. The value depends on the order of calls, so seed positions explicitly to reproduce a run.
+		@return Seed value
+		*/
+		unsigned int DrawRandomSeed();
+
+		/**
+		Seed the random number generator, instead of by current time. Applies immediately and 
+		whenever a road network is loaded.
+		@param seed Seed value
+		*/
+		void SetRandomSeed(unsigned int seed);
+
+		/**
+		Upper bound of the absolute curvature of any road reference line, e.g. for bounding how fast the 
+		heading of an object following the roads may change. See Road::GetMaxCurvature(). Set at load,
+		covering all roads also of a tiled road network.
+		*/
+		double GetMaxCurvature() { return max_curvature_; }
 
 		void Print();
 	
@@ -634,11 +1426,65 @@ namespace roadmanager
 		pugi::xml_node root_node_;
 		std::vector<Road*> road_;
 		std::vector<Junction*> junction_;
+		std::unordered_map<int, int> road_idx_by_id_;  // road ID -> index into road_
+		std::unordered_map<int, int> junction_idx_by_id_;  // junction ID -> index into junction_
 		std::string odr_filename_;
+		SpatialIndex spatial_index_;
+		LaneGraph lane_graph_;
+		Arena arena_;  // Owns all roads, junctions and their sub elements
+		std::mt19937 random_generator_;
+		std::mutex random_mutex_;  // Guards random_generator_, shared by all positions on the network
+		unsigned int random_seed_;
+		bool random_seed_set_;  // false means seed by time at load
+		std::string cache_dir_;  // empty means no cache
+		int loader_threads_;
+		double closest_point_tolerance_;
+		double max_curvature_;  // of all roads
+
+		typedef struct
+		{
+			std::vector<int> road_idx_;
+			Arena *arena_;  // road content of the tile, 0 when not loaded
+			bool loaded_;
+			size_t size_;
+			unsigned long long last_used_;
+			double x_min_;
+			double y_min_;
+			double x_max_;
+			double y_max_;
+		} Tile;
+
+		OpenDriveCache *tile_cache_;  // 0 when not tiled
+		std::vector<Tile> tile_;
+		std::vector<int> road_tile_;  // road index -> tile index
+		std::unordered_map<long long, int> tile_idx_by_cell_;
+		double tile_size_;
+		double tile_margin_;  // max extension of any tile outside its grid cell
+		size_t tile_memory_budget_;
+		unsigned long long tile_clock_;
+
+		void Clear();
+		std::string GetCacheFilename(const char *filename);  // empty when cache is disabled
+		void BuildTiles(double tile_size);
+		bool LoadTile(int tile_idx);
+		void ReleaseTile(int tile_idx);
+		void ReleaseUnusedTiles(size_t size);  // make room for size within the budget
+
+		/**
+		Build a road, with all sub elements, from its OpenDRIVE XML node
+		@param road_node The road element
+		@param arena Where to allocate the road objects
+		@return The road, or 0 on error
+		*/
+		Road *LoadRoad(pugi::xml_node road_node, Arena &arena);
+		void LoadRoadsParallel(std::vector<pugi::xml_node> &road_nodes, std::vector<Road*> &roads);
+		static void LoadRoadsThread(void *arg);
+
+		friend class OpenDriveCache;
 	};
 
-	// Forward declaration of Route
-	class Route;
+	// Max number of lanes in a lane section for keeping lane offsets in Position
+	#define LANE_OFFSETS_MAX_LANES 16
 
 	class Position
 	{
@@ -647,17 +1493,63 @@ namespace roadmanager
 		explicit Position(int track_id, double s, double t);
 		explicit Position(int track_id, int lane_id, double s, double offset);
 		explicit Position(double x, double y, double z, double h, double p, double r);
+
+		/**
+		Create a position in a specific road network, instead of the default one
+		@param od Road network to use, 0 for the default one
+		*/
+		explicit Position(OpenDrive *od);
 		~Position();
 		
 		void Init();
+
+		/**
+		Load the default road network, used by all positions not referring to a specific road network
+		@param filename OpenDRIVE file
+		*/
 		static bool LoadOpenDrive(const char *filename);
-		static OpenDrive* GetOpenDrive();
+		static OpenDrive* GetDefaultOpenDrive();
+
+		/**
+		Set the road network of the position. Several road networks can be used simultaneously, 
+		e.g. one per simulation thread. Note that a road network, and its positions, must only be
+		used by one thread at a time.
+		@param od Road network to use, 0 for the default one
+		*/
+		void SetOpenDrive(OpenDrive *od) { od_ = od; }
+
+		/**
+		Get the road network of the position
+		*/
+		OpenDrive* GetOpenDrive() const { return od_ ? od_ : GetDefaultOpenDrive(); }
+
+		/**
+		Seed the random number generator of the position, used for random choices like junction 
+		connections (Junction::RANDOM). Positions with equal seed and stream make the same choices, 
+		independent of any other position. Positions not seeded draw a seed from the road network 
+		generator at first use, see OpenDrive::DrawRandomSeed().
+		@param seed Seed value, e.g. per simulation run
+		@param stream Separates positions sharing the same seed, e.g. object ID
+		*/
+		void SetRandomSeed(unsigned int seed, unsigned int stream = 0);
+		std::minstd_rand &GetRandomGenerator();
+
+		/**
+		Set the random number generator state, e.g. to keep it when assigning another position to this one
+		*/
+		void SetRandomGenerator(const std::minstd_rand &random_generator) { random_generator_ = random_generator; random_seeded_ = true; }
 		void SetTrackPos(int track_id, double s, double t, bool calculateXYZ = true);
 		void SetLanePos(int track_id, int lane_id, double s, double offset, int lane_section_idx = -1);
 		void SetInertiaPos(double x, double y, double z, double h, double p, double r, bool updateTrackPos = true);
-		void SetHeading(double heading) { h_ = heading;  }
+		void SetHeading(double heading) 
+		{ 
+			EnsureTrackPos();
+			EnsureXYZ();
+			h_ = heading;  
+		}
 		void SetHeadingRelative(double heading) 
 		{ 
+			EnsureXYZ();
 			h_relative_ = heading; 
 		}  // Sets heading indepnedently 
 		void XYH2TrackPos(double x, double y, double h, bool evaluateZAndPitch = true);
@@ -678,7 +1570,7 @@ namespace roadmanager
 		Retrieve the S-value of the current route position. Note: This is the S along the
 		complete route, not the actual individual roads.
 		*/
-		double GetRouteS() { return s_; }
+		double GetRouteS() const { EnsureTrackPos(); return s_; }
 
 		/**
 		Move current position forward, or backwards, ds meters along the route
@@ -714,7 +1606,7 @@ namespace roadmanager
 		@param y (meter). Y component of the relative distance.
 		@return distance (meter). Negative if the specified position is behind the current one.
 		*/
-		double getRelativeDistance(Position target_position, double &x, double &y);
+		double getRelativeDistance(Position &target_position, double &x, double &y);
 
 		/**
 		Is the current position ahead of the one specified in argument
@@ -722,7 +1614,7 @@ namespace roadmanager
 		@param target_position The position to compare the current to.
 		@return true of false
 		*/
-		bool IsAheadOf(Position target_position);
+		bool IsAheadOf(Position &target_position);
 
 		/**
 		Get the location, in local vehicle coordinate system, of a point along the road ahead
@@ -743,17 +1635,23 @@ namespace roadmanager
 		*/
 		int MoveAlongS(double ds, double dLaneOffset = 0, Junction::JunctionStrategyType strategy = Junction::JunctionStrategyType::RANDOM);
 
+		/**
+		Evaluate any pending inertial or track coordinates, e.g. before copying the coordinates. 
+		Getters evaluate on request anyway.
+		*/
+		void Evaluate() const { EnsureTrackPos(); EnsureXYZ(); }
+
 		/**
 		Retrieve the track/road ID from the position object
 		@return track/road ID
 		*/
-		int GetTrackId() const { return track_id_; }
+		int GetTrackId() const { EnsureTrackPos(); return track_id_; }
 
 		/**
 		Retrieve the lane ID from the position object
 		@return lane ID
 		*/
-		int GetLaneId() const { return lane_id_; }
+		int GetLaneId() const { EnsureTrackPos(); return lane_id_; }
 
 		/**
 		Retrieve a road segment specified by road ID
@@ -764,37 +1662,37 @@ namespace roadmanager
 		/**
 		Retrieve the s value (distance along the road segment)
 		*/
-		double GetS() const { return s_; }
+		double GetS() const { EnsureTrackPos(); return s_; }
 
 		/**
 		Retrieve the t value (lateral distance from reference lanem (id=0))
 		*/
-		double GetT() const { return t_; }
+		double GetT() const { EnsureTrackPos(); return t_; }
 
 		/**
 		Retrieve the offset from current lane
 		*/
-		double GetOffset() const { return offset_; }
+		double GetOffset() const { EnsureTrackPos(); return offset_; }
 
 		/**
 		Retrieve the world coordinate X-value
 		*/
-		double GetX() const { return x_; }
+		double GetX() const { EnsureXYZ(); return x_; }
 
 		/**
 		Retrieve the world coordinate Y-value
 		*/
-		double GetY() const { return y_; }
+		double GetY() const { EnsureXYZ(); return y_; }
 
 		/**
 		Retrieve the world coordinate Z-value
 		*/
-		double GetZ() const { return z_; }
+		double GetZ() const { EnsureXYZ(); return z_; }
 
 		/**
 		Retrieve the world coordinate heading angle (radians)
 		*/
-		double GetH() const { return h_; }
+		double GetH() const { EnsureXYZ(); return h_; }
 
 		/**
 		Retrieve the relative heading angle (radians)
@@ -804,7 +1702,7 @@ namespace roadmanager
 		/**
 		Retrieve the world coordinate pitch angle (radians)
 		*/
-		double GetP() const { return p_; }
+		double GetP() const { EnsureXYZ(); return p_; }
 
 		/**
 		Retrieve the world coordinate roll angle (radians)
@@ -835,6 +1733,18 @@ namespace roadmanager
 		void PrintXY();
 	
 	protected:
+		/**
+		Coordinates are evaluated lazily. Setting track or lane coordinates marks the inertial coordinates 
+		as dirty and vice versa. The dirty representation is evaluated first when requested, e.g. by a getter. 
+		Functions changing input of a pending evaluation, like SetHeading(), evaluate it first to give 
+		same result as immediate evaluation. Evaluation only updates mutable members, hence getters 
+		are const.
+		*/
+		void EnsureXYZ() const { if (xyz_dirty_) ((Position*)this)->EvaluateXYZ(); }
+		void EnsureTrackPos() const { if (track_dirty_) ((Position*)this)->EvaluateTrackPos(); }
+		void EvaluateXYZ();
+		void EvaluateTrackPos();
+
 		void Track2Lane();
 		void Track2XYZ();
 		void Lane2Track();
@@ -843,34 +1753,63 @@ namespace roadmanager
 		bool EvaluateZAndPitch();
 		double GetDistToTrackGeom(double x3, double y3, double h, Road *road, Geometry *geom, bool &inside, double &sNorm);
 
+		/**
+		Collect spatial index entries of the geometries around current position, i.e. current geometry, 
+		adjacent geometries on the same road and connecting geometries of linked roads and junctions
+		*/
+		void GetNeighbourGeometries(std::vector<int> &entries);
+
+		/**
+		Get outer offset of all lanes in given lane section at s, see LaneSection::GetOuterOffsets(). The 
+		offsets are kept, so repeated lookups for same lane section and s-value are free.
+		@return Offsets by lane index, or 0 if the lane section has too many lanes to be kept
+		*/
+		double *GetLaneOuterOffsets(LaneSection *lane_section, double s);
+
 		// route reference
 		Route  *route_;			// if pointer set, the position corresponds to a point along (s) the route
-
-		// track reference
-		int     track_id_;
-		double  s_;				// longitudinal point/distance along the track
-		double  t_;				// lateral position relative reference line (geometry)
-		int     lane_id_;		// lane reference
-		double  offset_;		// lateral position relative lane given by lane_id
-		double  h_offset_;		// local heading offset given by lane width and offset
+		OpenDrive *od_;			// road network, 0 means the default one
+
+		// track reference. Coordinates and indices below are mutable, since updated by lazy evaluation.
+		mutable int     track_id_;
+		mutable double  s_;				// longitudinal point/distance along the track
+		mutable double  t_;				// lateral position relative reference line (geometry)
+		mutable int     lane_id_;		// lane reference
+		mutable double  offset_;		// lateral position relative lane given by lane_id
+		mutable double  h_offset_;		// local heading offset given by lane width and offset
 		double  h_relative_;	// heading relative road heading, e.g. for vehicle heading use
 		double  s_route_;		// longitudinal point/distance along the route
 		double  curvature_;
 
 		// inertial reference
-		double	x_;
-		double	y_;
-		double	z_;
-		double	h_;
-		double	p_;
-		double	r_;
+		mutable double	x_;
+		mutable double	y_;
+		mutable double	z_;
+		mutable double	h_;
+		mutable double	p_;
+		mutable double	r_;
 
 		// keep track for fast incremental updates of the position
-		int		track_idx_;		// road index 
-		int		lane_idx_;		// road index 
-		int		lane_section_idx_;	// lane section
-		int		geometry_idx_;	// index of the segment within the track given by track_idx
-		int		elevation_idx_;	// index of the current elevation entry 
+		mutable int		track_idx_;		// road index 
+		mutable int		lane_idx_;		// road index 
+		mutable int		lane_section_idx_;	// lane section
+		mutable int		geometry_idx_;	// index of the segment within the track given by track_idx
+		mutable int		elevation_idx_;	// index of the current elevation entry 
+
+		// lazy evaluation, see EnsureXYZ() and EnsureTrackPos()
+		mutable bool	xyz_dirty_;		// inertial coordinates not yet evaluated from track coordinates
+		mutable bool	xyz_lane_dir_;	// on evaluation, turn heading and pitch into driving direction of left side lanes
+		mutable bool	xyz_reverse_;	// on evaluation, turn heading 180 degrees
+		mutable bool	track_dirty_;	// track coordinates not yet evaluated from inertial coordinates
+
+		// random choices of this position, e.g. at junctions. Seeded at first use, unless set explicitly.
+		std::minstd_rand random_generator_;
+		bool	random_seeded_;
+
+		// outer lane offsets of last looked up lane section and s-value
+		mutable int		lane_offsets_serial_;	// serial number of the lane section, 0 if not set
+		mutable double	lane_offsets_s_;
+		mutable double	lane_offsets_[LANE_OFFSETS_MAX_LANES];
 	};
 
 
@@ -18,6 +18,8 @@ using namespace roadmanager;
 
 static roadmanager::OpenDrive *odrManager = 0;
 static std::vector<Position> position;
+static bool random_seed_set = false;
+static unsigned int random_seed = 0;
 
 static int GetSteeringTarget(int index, float lookahead_distance, double *pos_local, double *pos_global, double *angle, double *curvature)
 {
@@ -46,7 +48,7 @@ extern "C"
 			printf("Failed to load ODR %s\n", odrFilename);
 			return -1;
 		}
-		odrManager = roadmanager::Position::GetOpenDrive();
+		odrManager = roadmanager::Position::GetDefaultOpenDrive();
 
 		return 0;
 	}
@@ -57,9 +59,28 @@ extern "C"
 		return 0;
 	}
 	
+	RM_DLL_API int RM_SetSeed(unsigned int seed)
+	{
+		random_seed_set = true;
+		random_seed = seed;
+		roadmanager::Position::GetDefaultOpenDrive()->SetRandomSeed(seed);
+
+		// Seed each position by its handle, so choices do not depend on the order of calls
+		for (size_t i = 0; i < position.size(); i++)
+		{
+			position[i].SetRandomSeed(seed, (unsigned int)i);
+		}
+
+		return 0;
+	}
+
 	RM_DLL_API int RM_CreatePosition()
 	{
 		roadmanager::Position newPosition;
+		if (random_seed_set)
+		{
+			newPosition.SetRandomSeed(random_seed, (unsigned int)position.size());
+		}
 		position.push_back(newPosition);
 		return (int)(position.size() - 1);  // return index of newly created 
 	}
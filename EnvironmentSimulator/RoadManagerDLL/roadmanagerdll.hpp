@@ -41,6 +41,14 @@ extern "C"
 
 	RM_DLL_API int RM_Close();
 
+	/**
+	Seed random choices of all positions, e.g. at junctions, instead of by current time. Applies to 
+	existing positions and positions created later. Same seed reproduces the same choices.
+	@param seed Seed value
+	@return 0 if successful
+	*/
+	RM_DLL_API int RM_SetSeed(unsigned int seed);
+
 	/**
 	Create a position object
 	@return Handle to the position object, to use for operations
@@ -67,6 +67,12 @@ namespace scenarioengine
 			}
 		}
 
+		/**
+		Whether stepping the action, in its current state, leaves the speed of objects and the state 
+		of the action unchanged regardless of step size. Allows large steps, see adaptive step size.
+		*/
+		virtual bool IsSteady() { return false; }
+
 		virtual void Step(double dt)
 		{
 			(void)dt;
@@ -57,6 +57,106 @@ bool EvaluateRule(double a, double b, Rule rule)
 	return false;
 }
 
+// Object which a relative position depends on, 0 if none or not known
+static Object *PositionReferenceObject(OSCPosition *position)
+{
+	if (position->type_ == OSCPosition::PositionType::RELATIVE_OBJECT)
+	{
+		return ((OSCPositionRelativeObject*)position)->object_;
+	}
+	else if (position->type_ == OSCPosition::PositionType::RELATIVE_LANE)
+	{
+		return ((OSCPositionRelativeLane*)position)->object_;
+	}
+
+	return 0;
+}
+
+/**
+Result of a rule on a measure, e.g. a distance, changing continuously between two steps. True if true 
+at end of the step, or if it became true in between. The largest value must be at either end.
+@param start Value at start of step
+@param end Value at end of step
+@param min_value Smallest value in between
+*/
+static bool EvaluateRuleSwept(double start, double end, double min_value, double value, Rule rule)
+{
+	if (EvaluateRule(end, value, rule))
+	{
+		return true;
+	}
+	else if (EvaluateRule(start, value, rule))
+	{
+		// Left during the step
+		return false;
+	}
+
+	if (rule == Rule::LESS_THAN)
+	{
+		return min_value < value;
+	}
+	else if (rule == Rule::EQUAL_TO)
+	{
+		return min_value <= value && fmax(start, end) >= value;
+	}
+
+	return false;
+}
+
+// Smallest distance from origin to the line segment between two points
+static double SegmentMinDistance(double x0, double y0, double x1, double y1)
+{
+	double dx = x1 - x0;
+	double dy = y1 - y0;
+	double length2 = dx * dx + dy * dy;
+	double u = 0;
+
+	if (length2 > SMALL_NUMBER)
+	{
+		u = -(x0 * dx + y0 * dy) / length2;
+		u = u < 0 ? 0 : (u > 1 ? 1 : u);
+	}
+
+	return sqrt((x0 + u * dx) * (x0 + u * dx) + (y0 + u * dy) * (y0 + u * dy));
+}
+
+/**
+Distance from an entity to a target over the latest motion segment, see Object::NextMotionSegment(). 
+Linear motion is assumed in between.
+@param target Target position, if relative to a reference object it is moved along with that object
+@param reference Object which the target follows, or 0
+@param start Distance at start of segment
+@param end Distance at end, i.e. current distance
+@param min_dist Smallest distance along the segment
+*/
+static void SweptDistance(Object *entity, roadmanager::Position *target, Object *reference, double &start, double &end, double &min_dist)
+{
+	double x1 = target->GetX() - entity->pos_.GetX();
+	double y1 = target->GetY() - entity->pos_.GetY();
+	double x0 = x1 + entity->pos_.GetX() - entity->prev_x_;
+	double y0 = y1 + entity->pos_.GetY() - entity->prev_y_;
+
+	if (reference)
+	{
+		x0 += reference->prev_x_ - reference->pos_.GetX();
+		y0 += reference->prev_y_ - reference->pos_.GetY();
+	}
+
+	start = sqrt(x0 * x0 + y0 * y0);
+	end = sqrt(x1 * x1 + y1 * y1);
+	min_dist = SegmentMinDistance(x0, y0, x1, y1);
+}
+
+// Position of target object in entity coordinates, x forward y left, at start of latest motion segment
+static void MotionStartRelative(Object *entity, Object *target, double &x, double &y)
+{
+	double dx = target->prev_x_ - entity->prev_x_;
+	double dy = target->prev_y_ - entity->prev_y_;
+
+	x = dx * cos(-entity->prev_h_) - dy * sin(-entity->prev_h_);
+	y = dx * sin(-entity->prev_h_) + dy * cos(-entity->prev_h_);
+}
+
 bool OSCCondition::CheckEdge(bool new_value, bool old_value, OSCCondition::ConditionEdge edge)
 {
 	if (evaluated_ && edge == OSCCondition::ConditionEdge::ANY)
@@ -85,6 +185,29 @@ bool OSCCondition::CheckEdge(bool new_value, bool old_value, OSCCondition::Condi
 	return false;
 }
 
+OSCCondition::WakeCause OSCCondition::GetWakeCause(double sim_time, double &wake_time)
+{
+	if (timer_.Started())
+	{
+		// Nothing but time matters until the delay has passed
+		wake_time = timer_.start_time_ + delay_;
+		return WAKE_BY_TIME;
+	}
+
+	if (edge_ != ConditionEdge::RISING && edge_ != ConditionEdge::FALLING && edge_ != ConditionEdge::ANY)
+	{
+		// Will complain on every evaluation, keep doing it
+		return WAKE_ALWAYS;
+	}
+
+	return GetInputWakeCause(sim_time, wake_time);
+}
+
+static bool ValidRule(Rule rule)
+{
+	return rule == Rule::EQUAL_TO || rule == Rule::GREATER_THAN || rule == Rule::LESS_THAN;
+}
+
 std::string Edge2Str(OSCCondition::ConditionEdge edge)
 {
 	if (edge == OSCCondition::ConditionEdge::FALLING)
@@ -120,14 +243,13 @@ bool EvalDone(bool result, TrigByEntity::TriggeringEntitiesRule rule)
 bool TrigByState::Evaluate(Story *story, double sim_time)
 {
 	(void)story;
-	(void)sim_time;
 	bool result = false;
 
 	if (timer_.Started())
 	{
-		if (timer_.DurationS() > delay_)
+		if (timer_.DurationS(sim_time) > delay_)
 		{
-			LOG("Timer expired at %.2f seconds", timer_.DurationS());
+			LOG("Timer expired at %.2f seconds", timer_.DurationS(sim_time));
 			timer_.Reset();
 			return true;
 		}
@@ -139,7 +261,7 @@ bool TrigByState::Evaluate(Story *story, double sim_time)
 
 	if (result && delay_ > 0)
 	{
-		timer_.Start();
+		timer_.Start(sim_time);
 		LOG("Timer started");
 		return false;
 	}
@@ -149,14 +271,13 @@ bool TrigByState::Evaluate(Story *story, double sim_time)
 
 bool TrigAtStart::Evaluate(Story *story, double sim_time)
 {
-	(void)sim_time;
 	bool trig = false;
 
 	if (timer_.Started())
 	{
-		if (timer_.DurationS() > delay_)
+		if (timer_.DurationS(sim_time) > delay_)
 		{
-			LOG("Timer expired at %.2f seconds", timer_.DurationS());
+			LOG("Timer expired at %.2f seconds", timer_.DurationS(sim_time));
 			timer_.Reset();
 			return true;
 		}
@@ -270,7 +391,7 @@ bool TrigAtStart::Evaluate(Story *story, double sim_time)
 
 	if (trig && delay_ > 0)
 	{
-		timer_.Start();
+		timer_.Start(sim_time);
 		LOG("Timer started");
 		return false;
 	}
@@ -280,14 +401,13 @@ bool TrigAtStart::Evaluate(Story *story, double sim_time)
 
 bool TrigAfterTermination::Evaluate(Story *story, double sim_time)
 {
-	(void)sim_time;
 	bool trig = false;
 
 	if (timer_.Started())
 	{
-		if (timer_.DurationS() > delay_)
+		if (timer_.DurationS(sim_time) > delay_)
 		{
-			LOG("Timer expired at %.2f seconds", timer_.DurationS());
+			LOG("Timer expired at %.2f seconds", timer_.DurationS(sim_time));
 			timer_.Reset();
 			return true;
 		}
@@ -409,7 +529,7 @@ bool TrigAfterTermination::Evaluate(Story *story, double sim_time)
 
 	if (trig && delay_ > 0)
 	{
-		timer_.Start();
+		timer_.Start(sim_time);
 		LOG("Timer started");
 		return false;
 	}
@@ -420,13 +540,12 @@ bool TrigAfterTermination::Evaluate(Story *story, double sim_time)
 bool TrigByValue::Evaluate(Story *story, double sim_time)
 {
 	(void)story;
-	(void)sim_time;
 
 	if (timer_.Started())
 	{
-		if (timer_.DurationS() > delay_)
+		if (timer_.DurationS(sim_time) > delay_)
 		{
-			LOG("Timer expired at %.2f seconds", timer_.DurationS());
+			LOG("Timer expired at %.2f seconds", timer_.DurationS(sim_time));
 			timer_.Reset();
 			return true;
 		}
@@ -440,7 +559,7 @@ bool TrigByValue::Evaluate(Story *story, double sim_time)
 
 	if (result && delay_ > 0)
 	{
-		timer_.Start();
+		timer_.Start(sim_time);
 		LOG("Timer started");
 		return false;
 	}
@@ -457,9 +576,9 @@ bool TrigBySimulationTime::Evaluate(Story *story, double sim_time)
 	
 	if (timer_.Started())
 	{
-		if (timer_.DurationS() > delay_)
+		if (timer_.DurationS(sim_time) > delay_)
 		{
-			LOG("Timer expired at %.2f seconds", timer_.DurationS());
+			LOG("Timer expired at %.2f seconds", timer_.DurationS(sim_time));
 			timer_.Reset();
 			return true;
 		}
@@ -483,7 +602,7 @@ bool TrigBySimulationTime::Evaluate(Story *story, double sim_time)
 
 	if (trig && delay_ > 0)
 	{
-		timer_.Start();
+		timer_.Start(sim_time);
 		LOG("Timer started");
 		return false;
 	}
@@ -494,7 +613,6 @@ bool TrigBySimulationTime::Evaluate(Story *story, double sim_time)
 bool TrigByTimeHeadway::Evaluate(Story *story, double sim_time)
 {
 	(void)story;
-	(void)sim_time;
 
 	bool result = false;
 	bool trig = false;
@@ -502,9 +620,9 @@ bool TrigByTimeHeadway::Evaluate(Story *story, double sim_time)
 
 	if (timer_.Started())
 	{
-		if (timer_.DurationS() > delay_)
+		if (timer_.DurationS(sim_time) > delay_)
 		{
-			LOG("Timer expired at %.2f seconds", timer_.DurationS());
+			LOG("Timer expired at %.2f seconds", timer_.DurationS(sim_time));
 			timer_.Reset();
 			return true;
 		}
@@ -548,7 +666,7 @@ bool TrigByTimeHeadway::Evaluate(Story *story, double sim_time)
 
 	if (trig && delay_ > 0)
 	{
-		timer_.Start();
+		timer_.Start(sim_time);
 		LOG("Timer started");
 		return false;
 	}
@@ -559,29 +677,35 @@ bool TrigByTimeHeadway::Evaluate(Story *story, double sim_time)
 bool TrigByReachPosition::Evaluate(Story *story, double sim_time)
 {
 	(void)story;
-	(void)sim_time;
 
 	bool result = false;
 	bool trig = false;
-	double x, y;
 
 	if (timer_.Started())
 	{
-		if (timer_.DurationS() > delay_)
+		if (timer_.DurationS(sim_time) > delay_)
 		{
-			LOG("Timer expired at %.2f seconds", timer_.DurationS());
+			LOG("Timer expired at %.2f seconds", timer_.DurationS(sim_time));
 			timer_.Reset();
 			return true;
 		}
 		return false;
 	}
 
+	bool reached = false;  // At the step, not counting passing in between
+
 	for (size_t i = 0; i < triggering_entities_.entity_.size(); i++)
 	{
-		if (fabs(triggering_entities_.entity_[i].object_->pos_.getRelativeDistance(*position_->GetRMPos(), x, y)) < tolerance_)
+		double start, dist, min_dist;
+
+		// Consider the whole motion since last step, a fast entity might pass the position in between
+		SweptDistance(triggering_entities_.entity_[i].object_, position_->GetRMPos(), PositionReferenceObject(position_), start, dist, min_dist);
+
+		if (EvaluateRuleSwept(start, dist, min_dist, tolerance_, Rule::LESS_THAN))
 		{
 			result = true;
 		}
+		reached = reached || dist < tolerance_;
 
 		if (EvalDone(trig, triggering_entity_rule_))
 		{
@@ -590,13 +714,14 @@ bool TrigByReachPosition::Evaluate(Story *story, double sim_time)
 	}
 
 	trig = CheckEdge(result, last_result_, edge_);
+	passed_ = result && !reached;
 
 	last_result_ = result;
 	evaluated_ = true;
 
 	if (trig && delay_ > 0)
 	{
-		timer_.Start();
+		timer_.Start(sim_time);
 		LOG("Timer started");
 		return false;
 	}
@@ -607,18 +732,16 @@ bool TrigByReachPosition::Evaluate(Story *story, double sim_time)
 bool TrigByDistance::Evaluate(Story *story, double sim_time)
 {
 	(void)story;
-	(void)sim_time;
 
 	bool result = false;
 	bool trig = false;
-	double x, y;
-	double dist;
+	double start, dist, min_dist;
 
 	if (timer_.Started())
 	{
-		if (timer_.DurationS() > delay_)
+		if (timer_.DurationS(sim_time) > delay_)
 		{
-			LOG("Timer expired at %.2f seconds", timer_.DurationS());
+			LOG("Timer expired at %.2f seconds", timer_.DurationS(sim_time));
 			timer_.Reset();
 			return true;
 		}
@@ -627,7 +750,7 @@ bool TrigByDistance::Evaluate(Story *story, double sim_time)
 
 	for (size_t i = 0; i < triggering_entities_.entity_.size(); i++)
 	{
-		dist = fabs(triggering_entities_.entity_[i].object_->pos_.getRelativeDistance(*position_->GetRMPos(), x, y));
+		SweptDistance(triggering_entities_.entity_[i].object_, position_->GetRMPos(), PositionReferenceObject(position_), start, dist, min_dist);
 
 		if (dist < value_)
 		{
@@ -640,8 +763,10 @@ bool TrigByDistance::Evaluate(Story *story, double sim_time)
 		}
 	}
 
-	result = EvaluateRule(dist, value_, rule_);
-	//LOG("Distance trig %s? dist: %.2f %s %.2f x %.2f y %.2f", name_.c_str(), dist, Rule2Str(rule_).c_str(), value_, Edge2Str(edge_).c_str(), x, y);
+	// Consider the whole motion since last step, the limit might have been passed in between
+	result = EvaluateRuleSwept(start, dist, min_dist, value_, rule_);
+	passed_ = result && !EvaluateRule(dist, value_, rule_);
+	//LOG("Distance trig %s? dist: %.2f %s %.2f", name_.c_str(), dist, Rule2Str(rule_).c_str(), value_, Edge2Str(edge_).c_str());
 	trig = CheckEdge(result, last_result_, edge_);
 
 	last_result_ = result;
@@ -649,7 +774,7 @@ bool TrigByDistance::Evaluate(Story *story, double sim_time)
 
 	if (trig && delay_ > 0)
 	{
-		timer_.Start();
+		timer_.Start(sim_time);
 		LOG("Timer started");
 		return false;
 	}
@@ -659,17 +784,16 @@ bool TrigByDistance::Evaluate(Story *story, double sim_time)
 bool TrigByRelativeDistance::Evaluate(Story *story, double sim_time)
 {
 	(void)story;
-	(void)sim_time;
 
 	bool result = false;
 	bool trig = false;
-	double rel_dist, rel_intertial_dist, x, y;
+	double rel_dist, x, y;
 
 	if (timer_.Started())
 	{
-		if (timer_.DurationS() > delay_)
+		if (timer_.DurationS(sim_time) > delay_)
 		{
-			LOG("Timer expired at %.2f seconds", timer_.DurationS());
+			LOG("Timer expired at %.2f seconds", timer_.DurationS(sim_time));
 			timer_.Reset();
 			return true;
 		}
@@ -678,26 +802,38 @@ bool TrigByRelativeDistance::Evaluate(Story *story, double sim_time)
 
 	for (size_t i = 0; i < triggering_entities_.entity_.size(); i++)
 	{
-		rel_intertial_dist = triggering_entities_.entity_[i].object_->pos_.getRelativeDistance(object_->pos_, x, y);
+		Object *entity = triggering_entities_.entity_[i].object_;
+		double start = 0, min_dist = 0;  // Over the motion since last step
+		double x0, y0;
+
+		// Position of the object relative to the entity, x along and y across its heading
+		entity->pos_.getRelativeDistance(object_->pos_, x, y);
+		MotionStartRelative(entity, object_, x0, y0);
 
 		if (type_ == RelativeDistanceType::LONGITUDINAL)
 		{
 			rel_dist = fabs(x);
+			start = fabs(x0);
+			min_dist = x0 * x < 0 ? 0 : fmin(start, rel_dist);
 		}
 		else if (type_ == RelativeDistanceType::LATERAL)
 		{
 			rel_dist = fabs(y);
+			start = fabs(y0);
+			min_dist = y0 * y < 0 ? 0 : fmin(start, rel_dist);
 		}
 		else if (type_ == RelativeDistanceType::INTERIAL)
 		{
-			rel_dist = fabs(rel_intertial_dist);
+			SweptDistance(entity, &object_->pos_, object_, start, rel_dist, min_dist);
 		}
 		else
 		{
 			LOG("Unsupported RelativeDistance type: %d", type_);
 		}
 
-		result = EvaluateRule(rel_dist, value_, rule_);
+		// The limit might have been passed in between steps
+		result = EvaluateRuleSwept(start, rel_dist, min_dist, value_, rule_);
+		passed_ = result && !EvaluateRule(rel_dist, value_, rule_);
 		trig = CheckEdge(result, last_result_, edge_);
 		if (EvalDone(result, triggering_entity_rule_))
 		{
@@ -716,10 +852,348 @@ bool TrigByRelativeDistance::Evaluate(Story *story, double sim_time)
 
 	if (trig && delay_ > 0)
 	{
-		timer_.Start();
+		timer_.Start(sim_time);
 		LOG("Timer started");
 		return false;
 	}
 
 	return trig;
 }
+
+void TrigByEntity::GetInputObjects(std::vector<Object*> &object)
+{
+	for (size_t i = 0; i < triggering_entities_.entity_.size(); i++)
+	{
+		object.push_back(triggering_entities_.entity_[i].object_);
+	}
+}
+
+// Margin for approximations of the motion bounds below, e.g. road curvature varying along lane offsets
+#define PREDICTION_SAFETY_FACTOR 0.5
+
+// Upper bound of the speed (m/s) of an object, including effect of lateral offset on curved roads
+static double SpeedBound(Object *object)
+{
+	if (object == 0 || object->speed_ == 0)
+	{
+		return 0;  // Static position
+	}
+
+	// Curvature bound is infinite for roads that can't be proven free from cusps
+	double t = fabs(object->pos_.GetT());
+	return fabs(object->speed_) * (t > 0 ? 1 + object->pos_.GetOpenDrive()->GetMaxCurvature() * t : 1);
+}
+
+// Upper bound of how fast (rad/s) the heading of an object following the road may change
+static double HeadingRateBound(Object *object)
+{
+	if (object->speed_ == 0)
+	{
+		return 0;
+	}
+
+	return fabs(object->speed_) * object->pos_.GetOpenDrive()->GetMaxCurvature();
+}
+
+// Time until a measure, changing at most by given rate, could reach a threshold. Including safety margin.
+static double TimeToReach(double value, double threshold, double rate)
+{
+	if (rate < SMALL_NUMBER)
+	{
+		return INFINITY;
+	}
+
+	return PREDICTION_SAFETY_FACTOR * fabs(value - threshold) / rate;
+}
+
+// Whether a position depends on nothing but the input objects
+static bool PositionKnown(OSCPosition *position)
+{
+	return position->type_ == OSCPosition::PositionType::WORLD ||
+		position->type_ == OSCPosition::PositionType::LANE ||
+		position->type_ == OSCPosition::PositionType::ROUTE ||
+		PositionReferenceObject(position) != 0;
+}
+
+void TrigByTimeHeadway::GetInputObjects(std::vector<Object*> &object)
+{
+	TrigByEntity::GetInputObjects(object);
+	object.push_back(object_);
+}
+
+OSCCondition::WakeCause TrigByTimeHeadway::GetInputWakeCause(double sim_time, double &wake_time)
+{
+	(void)sim_time;
+	(void)wake_time;
+
+	// With multiple entities the loop stops at first edge, which depends on last result. Then 
+	// the same input might give another result, so evaluate every time.
+	if (triggering_entities_.entity_.size() > 1 || !ValidRule(rule_))
+	{
+		return WAKE_ALWAYS;
+	}
+
+	return WAKE_BY_ENTITIES;
+}
+
+double TrigByTimeHeadway::PredictInputChange(double sim_time)
+{
+	if (!evaluated_ || timer_.Started() || triggering_entities_.entity_.size() != 1 || !ValidRule(rule_))
+	{
+		return sim_time;
+	}
+
+	Object *entity = triggering_entities_.entity_[0].object_;
+	double x, y, hwt;
+	double rel_dist = entity->pos_.getRelativeDistance(object_->pos_, x, y);
+
+	if (rel_dist < 0 || object_->speed_ < SMALL_NUMBER)
+	{
+		hwt = INFINITY;
+	}
+	else
+	{
+		hwt = fabs(rel_dist / object_->speed_);
+	}
+
+	if (EvaluateRule(hwt, value_, rule_) != last_result_)
+	{
+		// Moved past the limit since latest evaluation
+		return sim_time;
+	}
+
+	if (object_->speed_ < SMALL_NUMBER)
+	{
+		// Headway not defined as long as speed is constant
+		return INFINITY;
+	}
+
+	// Headway reaches value at distance value * speed, or becomes defined when target passes in front
+	double rate = SpeedBound(entity) + SpeedBound(object_);
+	double t_dist = TimeToReach(fabs(rel_dist), value_ * object_->speed_, rate);
+	double t_pass = TimeToReach(x, 0, rate + HeadingRateBound(entity) * fabs(rel_dist));
+
+	return sim_time + fmin(t_dist, t_pass);
+}
+
+void TrigByReachPosition::GetInputObjects(std::vector<Object*> &object)
+{
+	TrigByEntity::GetInputObjects(object);
+	if (PositionReferenceObject(position_))
+	{
+		object.push_back(PositionReferenceObject(position_));
+	}
+}
+
+OSCCondition::WakeCause TrigByReachPosition::GetInputWakeCause(double sim_time, double &wake_time)
+{
+	(void)sim_time;
+	(void)wake_time;
+
+	if (passed_)
+	{
+		// Result will change without further motion
+		return WAKE_ALWAYS;
+	}
+
+	return PositionKnown(position_) ? WAKE_BY_ENTITIES : WAKE_ALWAYS;
+}
+
+double TrigByReachPosition::PredictInputChange(double sim_time)
+{
+	if (!evaluated_ || timer_.Started() || !PositionKnown(position_))
+	{
+		return sim_time;
+	}
+
+	double x, y;
+	double t = INFINITY;
+	double reference_speed = SpeedBound(PositionReferenceObject(position_));
+
+	// Result can only change when any entity passes the tolerance limit
+	for (size_t i = 0; i < triggering_entities_.entity_.size(); i++)
+	{
+		Object *entity = triggering_entities_.entity_[i].object_;
+		double dist = fabs(entity->pos_.getRelativeDistance(*position_->GetRMPos(), x, y));
+
+		if ((dist < tolerance_) != last_result_)
+		{
+			return sim_time;
+		}
+		t = fmin(t, TimeToReach(dist, tolerance_, SpeedBound(entity) + reference_speed));
+	}
+
+	return sim_time + t;
+}
+
+void TrigByDistance::GetInputObjects(std::vector<Object*> &object)
+{
+	TrigByEntity::GetInputObjects(object);
+	if (PositionReferenceObject(position_))
+	{
+		object.push_back(PositionReferenceObject(position_));
+	}
+}
+
+OSCCondition::WakeCause TrigByDistance::GetInputWakeCause(double sim_time, double &wake_time)
+{
+	(void)sim_time;
+	(void)wake_time;
+
+	if (passed_)
+	{
+		return WAKE_ALWAYS;
+	}
+
+	return PositionKnown(position_) && ValidRule(rule_) ? WAKE_BY_ENTITIES : WAKE_ALWAYS;
+}
+
+double TrigByDistance::PredictInputChange(double sim_time)
+{
+	if (!evaluated_ || timer_.Started() || !PositionKnown(position_) || !ValidRule(rule_))
+	{
+		return sim_time;
+	}
+
+	double x, y;
+	double t = INFINITY;
+	double reference_speed = SpeedBound(PositionReferenceObject(position_));
+
+	for (size_t i = 0; i < triggering_entities_.entity_.size(); i++)
+	{
+		Object *entity = triggering_entities_.entity_[i].object_;
+		double dist = fabs(entity->pos_.getRelativeDistance(*position_->GetRMPos(), x, y));
+
+		if (EvaluateRule(dist, value_, rule_) != last_result_)
+		{
+			return sim_time;
+		}
+		t = fmin(t, TimeToReach(dist, value_, SpeedBound(entity) + reference_speed));
+	}
+
+	return sim_time + t;
+}
+
+void TrigByRelativeDistance::GetInputObjects(std::vector<Object*> &object)
+{
+	TrigByEntity::GetInputObjects(object);
+	object.push_back(object_);
+}
+
+OSCCondition::WakeCause TrigByRelativeDistance::GetInputWakeCause(double sim_time, double &wake_time)
+{
+	(void)sim_time;
+	(void)wake_time;
+
+	if (passed_)
+	{
+		return WAKE_ALWAYS;
+	}
+
+	return ValidRule(rule_) ? WAKE_BY_ENTITIES : WAKE_ALWAYS;
+}
+
+double TrigByRelativeDistance::PredictInputChange(double sim_time)
+{
+	if (!evaluated_ || timer_.Started() || !ValidRule(rule_))
+	{
+		return sim_time;
+	}
+
+	double x, y;
+	double t = INFINITY;
+
+	for (size_t i = 0; i < triggering_entities_.entity_.size(); i++)
+	{
+		Object *entity = triggering_entities_.entity_[i].object_;
+		double rel_dist = fabs(entity->pos_.getRelativeDistance(object_->pos_, x, y));
+		double rate = SpeedBound(entity) + SpeedBound(object_);
+		double dist;
+
+		if (type_ == RelativeDistanceType::INTERIAL)
+		{
+			dist = rel_dist;
+		}
+		else if (type_ == RelativeDistanceType::LONGITUDINAL || type_ == RelativeDistanceType::LATERAL)
+		{
+			// Components also change when the entity turns
+			dist = type_ == RelativeDistanceType::LONGITUDINAL ? fabs(x) : fabs(y);
+			rate += HeadingRateBound(entity) * rel_dist;
+		}
+		else
+		{
+			return sim_time;
+		}
+
+		if (EvaluateRule(dist, value_, rule_) != last_result_)
+		{
+			return sim_time;
+		}
+		t = fmin(t, TimeToReach(dist, value_, rate));
+	}
+
+	return sim_time + t;
+}
+
+OSCCondition::WakeCause TrigAtStart::GetInputWakeCause(double sim_time, double &wake_time)
+{
+	(void)sim_time;
+	(void)wake_time;
+
+	if (element_type_ == StoryElementType::SCENE)
+	{
+		// Trigs on every evaluation, or never
+		return edge_ == ConditionEdge::FALLING ? WAKE_NEVER : WAKE_ALWAYS;
+	}
+	else if (element_type_ == StoryElementType::ACT || element_type_ == StoryElementType::EVENT || 
+		element_type_ == StoryElementType::ACTION)
+	{
+		return WAKE_BY_STATE;
+	}
+
+	return WAKE_ALWAYS;
+}
+
+OSCCondition::WakeCause TrigAfterTermination::GetInputWakeCause(double sim_time, double &wake_time)
+{
+	(void)sim_time;
+	(void)wake_time;
+
+	if (element_type_ == StoryElementType::SCENE)
+	{
+		return WAKE_NEVER;
+	}
+	else if (element_type_ == StoryElementType::ACT || element_type_ == StoryElementType::EVENT ||
+		element_type_ == StoryElementType::ACTION)
+	{
+		return WAKE_BY_STATE;
+	}
+
+	return WAKE_ALWAYS;
+}
+
+OSCCondition::WakeCause TrigBySimulationTime::GetInputWakeCause(double sim_time, double &wake_time)
+{
+	// Result only changes when simulation time passes the value, assuming time is not going backwards
+	if (rule_ == Rule::GREATER_THAN && !last_result_)
+	{
+		wake_time = value_;
+		return WAKE_BY_TIME;
+	}
+	else if (rule_ == Rule::LESS_THAN && last_result_)
+	{
+		wake_time = value_;
+		return WAKE_BY_TIME;
+	}
+	else if (rule_ == Rule::EQUAL_TO && (last_result_ || sim_time < value_))
+	{
+		wake_time = last_result_ ? sim_time : value_;
+		return WAKE_BY_TIME;
+	}
+	else if (!ValidRule(rule_))
+	{
+		return WAKE_ALWAYS;
+	}
+
+	return WAKE_NEVER;
+}
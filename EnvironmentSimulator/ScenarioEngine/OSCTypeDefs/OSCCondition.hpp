@@ -28,21 +28,27 @@ namespace scenarioengine
 	class Story;
 	class Act;
 
+	/**
+	Measures condition delays in simulation time, so that a delayed trigger means the same 
+	regardless of whether the simulation runs in real time, faster or slower
+	*/
 	class Timer
 	{
 	public:
-		__int64 start_time_;
+		double start_time_;
+		bool started_;
 
-		Timer() : start_time_(0) {}
-		void Start() 
+		Timer() : start_time_(0), started_(false) {}
+		void Start(double sim_time) 
 		{ 
-			start_time_ = SE_getSystemTime(); 
+			start_time_ = sim_time; 
+			started_ = true;
 		}
 		
-		void Reset() { start_time_ = 0; }
+		void Reset() { start_time_ = 0; started_ = false; }
 
-		bool Started() { return start_time_ > 0 ? true : false; }
-		double DurationS() { return 1E-3 * (SE_getSystemTime() - start_time_);  }
+		bool Started() { return started_; }
+		double DurationS(double sim_time) { return sim_time - start_time_;  }
 		
 	};
 	
@@ -65,6 +71,15 @@ namespace scenarioengine
 			UNDEFINED
 		} ConditionEdge;
 
+		typedef enum
+		{
+			WAKE_ALWAYS,       // Evaluate every time
+			WAKE_NEVER,        // Result can not change anymore
+			WAKE_BY_TIME,      // Result may change when simulation time reaches a given value
+			WAKE_BY_STATE,     // Result may change when the referred story element changes state
+			WAKE_BY_ENTITIES,  // Result may change when any of the input objects moves
+		} WakeCause;
+
 		ConditionType base_type_;
 		std::string name_;
 		double delay_;
@@ -77,6 +92,39 @@ namespace scenarioengine
 
 		virtual bool Evaluate(Story *story, double sim_time) = 0;
 		bool CheckEdge(bool new_value, bool old_value, OSCCondition::ConditionEdge edge);
+
+		/**
+		Tell what could make next evaluation trig or change the condition state, given the state
+		after latest evaluation. Used for scheduling, to skip evaluations that would have no effect.
+		@param sim_time Simulation time of latest evaluation
+		@param wake_time Simulation time from which evaluation is needed, in case of WAKE_BY_TIME
+		@return Cause of next relevant evaluation
+		*/
+		WakeCause GetWakeCause(double sim_time, double &wake_time);
+
+		/**
+		Objects which position or speed the condition depends on, in case of WAKE_BY_ENTITIES
+		@param object Input objects are appended to this list
+		*/
+		virtual void GetInputObjects(std::vector<Object*> &object) { (void)object; }
+
+		/**
+		Conservative estimate of the earliest simulation time at which an evaluation could trig or change 
+		the condition state by movement of the input objects, assuming they keep their current speed. 
+		Complements GetWakeCause() for WAKE_BY_ENTITIES, e.g. for adaptive step size.
+		@param sim_time Current simulation time
+		@return Predicted simulation time, sim_time if not known or if a change is already due
+		*/
+		virtual double PredictInputChange(double sim_time) { return sim_time; }
+
+	protected:
+		// Same as GetWakeCause, when no delay timer is running
+		virtual WakeCause GetInputWakeCause(double sim_time, double &wake_time) 
+		{ 
+			(void)sim_time;
+			(void)wake_time;
+			return WAKE_ALWAYS; 
+		}
 	};
 
 	class TrigByEntity : public OSCCondition
@@ -111,8 +159,11 @@ namespace scenarioengine
 		TriggeringEntitiesRule triggering_entity_rule_;
 		TriggeringEntities triggering_entities_;
 		EntityConditionType type_;
+		bool passed_;  // Latest result true only by passing the limit between steps, not at the step
+
+		TrigByEntity(EntityConditionType type) : OSCCondition(OSCCondition::ConditionType::BY_ENTITY), type_(type), passed_(false) {}
 
-		TrigByEntity(EntityConditionType type) : OSCCondition(OSCCondition::ConditionType::BY_ENTITY), type_(type) {}
+		void GetInputObjects(std::vector<Object*> &object);
 
 		void Print()
 		{
@@ -132,6 +183,11 @@ namespace scenarioengine
 		TrigByTimeHeadway() : TrigByEntity(TrigByEntity::EntityConditionType::TIME_HEADWAY) {}
 
 		bool Evaluate(Story *story, double sim_time);
+		void GetInputObjects(std::vector<Object*> &object);
+		double PredictInputChange(double sim_time);
+
+	protected:
+		WakeCause GetInputWakeCause(double sim_time, double &wake_time);
 	};
 
 	class TrigByReachPosition : public TrigByEntity
@@ -143,6 +199,11 @@ namespace scenarioengine
 		TrigByReachPosition() : TrigByEntity(TrigByEntity::EntityConditionType::REACH_POSITION) {}
 
 		bool Evaluate(Story *story, double sim_time);
+		void GetInputObjects(std::vector<Object*> &object);
+		double PredictInputChange(double sim_time);
+
+	protected:
+		WakeCause GetInputWakeCause(double sim_time, double &wake_time);
 	};
 
 	class TrigByDistance : public TrigByEntity
@@ -157,6 +218,11 @@ namespace scenarioengine
 		TrigByDistance() : TrigByEntity(TrigByEntity::EntityConditionType::DISTANCE) {}
 
 		bool Evaluate(Story *story, double sim_time);
+		void GetInputObjects(std::vector<Object*> &object);
+		double PredictInputChange(double sim_time);
+
+	protected:
+		WakeCause GetInputWakeCause(double sim_time, double &wake_time);
 	};
 
 	class TrigByRelativeDistance : public TrigByEntity
@@ -178,6 +244,11 @@ namespace scenarioengine
 		TrigByRelativeDistance() : TrigByEntity(TrigByEntity::EntityConditionType::RELATIVE_DISTANCE) {}
 
 		bool Evaluate(Story *story, double sim_time);
+		void GetInputObjects(std::vector<Object*> &object);
+		double PredictInputChange(double sim_time);
+
+	protected:
+		WakeCause GetInputWakeCause(double sim_time, double &wake_time);
 	};
 
 	class TrigByState : public OSCCondition
@@ -215,6 +286,9 @@ namespace scenarioengine
 		TrigAtStart() : TrigByState(TrigByState::Type::AT_START) {}
 
 		bool Evaluate(Story *story, double sim_time);
+
+	protected:
+		WakeCause GetInputWakeCause(double sim_time, double &wake_time);
 	};
 
 	class TrigAfterTermination : public TrigByState
@@ -234,6 +308,9 @@ namespace scenarioengine
 		TrigAfterTermination() : TrigByState(TrigByState::Type::AFTER_TERMINATION) {}
 
 		bool Evaluate(Story *story, double sim_time);
+
+	protected:
+		WakeCause GetInputWakeCause(double sim_time, double &wake_time);
 	};
 
 	class TrigByValue : public OSCCondition
@@ -263,6 +340,9 @@ namespace scenarioengine
 		TrigBySimulationTime() : TrigByValue(TrigByValue::Type::TIME_OF_DAY) {}
 
 		bool Evaluate(Story *story, double sim_time);
+
+	protected:
+		WakeCause GetInputWakeCause(double sim_time, double &wake_time);
 	};
 
 }
@@ -14,18 +14,20 @@
 
 using namespace scenarioengine;
 
-OSCPositionWorld::OSCPositionWorld(double x, double y, double z, double h, double p, double r) : OSCPosition(PositionType::WORLD)
+OSCPositionWorld::OSCPositionWorld(double x, double y, double z, double h, double p, double r, roadmanager::OpenDrive *od) : 
+	OSCPosition(PositionType::WORLD, od)
 {
 	position_.SetInertiaPos(x, y, z, h, p, r);
 }
 
-OSCPositionLane::OSCPositionLane(int roadId, int laneId, double s, double offset, OSCOrientation orientation) : OSCPosition(PositionType::LANE)
+OSCPositionLane::OSCPositionLane(int roadId, int laneId, double s, double offset, OSCOrientation orientation, roadmanager::OpenDrive *od) : 
+	OSCPosition(PositionType::LANE, od)
 {
 	position_.SetLanePos(roadId, laneId, s, offset);
 }
 
-OSCPositionRelativeObject::OSCPositionRelativeObject(Object *object, double dx, double dy, double dz, OSCOrientation orientation) : 
-	OSCPosition(PositionType::RELATIVE_OBJECT), object_(object), dx_(dx), dy_(dy), dz_(dz), o_(orientation)
+OSCPositionRelativeObject::OSCPositionRelativeObject(Object *object, double dx, double dy, double dz, OSCOrientation orientation, roadmanager::OpenDrive *od) : 
+	OSCPosition(PositionType::RELATIVE_OBJECT, od), object_(object), dx_(dx), dy_(dy), dz_(dz), o_(orientation)
 {
 }
 
@@ -51,8 +53,8 @@ void OSCPositionRelativeObject::Print()
 	LOG("orientation: h %.2f p %.2f r %.2f %s", o_.h_, o_.p_, o_.r_, o_.type_ == OSCOrientation::OrientationType::ABSOLUTE ? "Absolute" : "Relative");
 }
 
-OSCPositionRelativeLane::OSCPositionRelativeLane(Object *object, int dLane, double ds, double offset, OSCOrientation orientation) :
-	OSCPosition(PositionType::RELATIVE_LANE), object_(object), dLane_(dLane), ds_(ds), offset_(offset), o_(orientation)
+OSCPositionRelativeLane::OSCPositionRelativeLane(Object *object, int dLane, double ds, double offset, OSCOrientation orientation, roadmanager::OpenDrive *od) :
+	OSCPosition(PositionType::RELATIVE_LANE, od), object_(object), dLane_(dLane), ds_(ds), offset_(offset), o_(orientation)
 {
 }
 
@@ -78,7 +80,8 @@ void OSCPositionRelativeLane::Print()
 	LOG("orientation: h %.2f p %.2f r %.2f %s", o_.h_, o_.p_, o_.r_, o_.type_ == OSCOrientation::OrientationType::ABSOLUTE ? "Absolute" : "Relative");
 }
 
-OSCPositionRoute::OSCPositionRoute(roadmanager::Route *route, double s, int laneId, double laneOffset)
+OSCPositionRoute::OSCPositionRoute(roadmanager::Route *route, double s, int laneId, double laneOffset, roadmanager::OpenDrive *od) : 
+	OSCPosition(PositionType::ROUTE, od)
 {
 	position_.SetRoute(route);
 }
\ No newline at end of file
@@ -62,6 +62,7 @@ namespace scenarioengine
 
 		OSCPosition() : type_(PositionType::UNDEFINED) {}
 		OSCPosition(PositionType type) : type_(type) {}
+		OSCPosition(PositionType type, roadmanager::OpenDrive *od) : type_(type), position_(od) {}
 		virtual ~OSCPosition() {}
 
 		PositionType type_;
@@ -83,8 +84,8 @@ namespace scenarioengine
 	class OSCPositionWorld : OSCPosition
 	{
 	public:
-		OSCPositionWorld() : OSCPosition(PositionType::WORLD) {}
-		OSCPositionWorld(double x, double y, double z, double h, double p, double r);
+		OSCPositionWorld(roadmanager::OpenDrive *od) : OSCPosition(PositionType::WORLD, od) {}
+		OSCPositionWorld(double x, double y, double z, double h, double p, double r, roadmanager::OpenDrive *od);
 
 		void Print() { position_.Print(); }
 		void Evaluate() {}  // No need to evaluate, position already in cartesian coordinates
@@ -93,8 +94,8 @@ namespace scenarioengine
 	class OSCPositionLane : OSCPosition
 	{
 	public:
-		OSCPositionLane() : OSCPosition(PositionType::LANE) {}
-		OSCPositionLane(int roadId, int landId, double s, double offset, OSCOrientation orientation);
+		OSCPositionLane(roadmanager::OpenDrive *od) : OSCPosition(PositionType::LANE, od) {}
+		OSCPositionLane(int roadId, int landId, double s, double offset, OSCOrientation orientation, roadmanager::OpenDrive *od);
 
 		void Print() { position_.Print(); }
 		void Evaluate() {}  // No need to evaluate, position already in cartesian coordinates
@@ -109,7 +110,7 @@ namespace scenarioengine
 		double dz_;
 		OSCOrientation o_;
 
-		OSCPositionRelativeObject(Object *object, double dx, double dy, double dz, OSCOrientation orientation);
+		OSCPositionRelativeObject(Object *object, double dx, double dy, double dz, OSCOrientation orientation, roadmanager::OpenDrive *od);
 
 		double GetX() { Evaluate(); return position_.GetX(); }
 		double GetY() { Evaluate(); return position_.GetY(); }
@@ -136,7 +137,7 @@ namespace scenarioengine
 		double offset_;
 		OSCOrientation o_;
 
-		OSCPositionRelativeLane(Object *object, int dLane, double ds, double offset, OSCOrientation orientation);
+		OSCPositionRelativeLane(Object *object, int dLane, double ds, double offset, OSCOrientation orientation, roadmanager::OpenDrive *od);
 
 		void Print();
 		void Evaluate();
@@ -150,8 +151,8 @@ namespace scenarioengine
 	class OSCPositionRoute : OSCPosition
 	{
 	public:
-		OSCPositionRoute() : OSCPosition(PositionType::ROUTE) {}
-		OSCPositionRoute(roadmanager::Route *route, double s, int laneId, double laneOffset);
+		OSCPositionRoute(roadmanager::OpenDrive *od) : OSCPosition(PositionType::ROUTE, od) {}
+		OSCPositionRoute(roadmanager::Route *route, double s, int laneId, double laneOffset, roadmanager::OpenDrive *od);
 
 		void SetRoute(roadmanager::Route *route) { position_.SetRoute(route); }
 		void SetRouteRefLaneCoord(double pathS, int laneId, double laneOffset) { position_.SetRouteLanePosition(pathS, laneId, laneOffset); }
@@ -256,6 +256,19 @@ void LongSpeedAction::Step(double dt)
 	object_->speed_ = new_speed;
 }
 
+bool LongSpeedAction::IsSteady()
+{
+	// Only continuous actions stay active once target speed is reached. Then speed is constant as 
+	// long as the referred object's speed is. Rate timing is excluded, since it oscillates around target.
+	if (!IsActive() || target_->type_ != Target::Type::RELATIVE || !((TargetRelative*)target_)->continuous_)
+	{
+		return false;
+	}
+
+	return dynamics_.transition_.shape_ == DynamicsShape::STEP ||
+		(dynamics_.timing_type_ == Timing::TIME && elapsed_ > dynamics_.timing_target_value_);
+}
+
 void LongDistanceAction::Step(double dt)
 {
 	// Find out current distance
@@ -162,6 +162,7 @@ namespace scenarioengine
 		void Trig();
 
 		void Step(double dt);
+		bool IsSteady();
 
 		void print()
 		{
@@ -194,6 +195,10 @@ namespace scenarioengine
 
 		LongDistanceAction() : OSCPrivateAction(OSCPrivateAction::Type::LONG_DISTANCE), target_object_(0), distance_(0), dist_type_(DistType::DISTANCE), freespace_(0), acceleration_(0)
 		{
+			dynamics_.none_ = true;
+			dynamics_.max_acceleration_ = 0;
+			dynamics_.max_deceleration_ = 0;
+			dynamics_.max_speed_ = 0;
 		}
 
 		void Trig();
@@ -406,7 +411,12 @@ namespace scenarioengine
 		void Step(double dt)
 		{
 			(void)dt;
+
+			// Keep the random number generator of the object, see ScenarioEngine::SetRandomSeed()
+			std::minstd_rand random_generator = object_->pos_.GetRandomGenerator();
 			object_->pos_ = *position_->GetRMPos();
+			object_->pos_.SetRandomGenerator(random_generator);
+			object_->ResetMotion();  // Teleported, no motion to check
 			LOG("Step %s pos: ", object_->name_.c_str());
 			position_->Print();
 
@@ -432,6 +442,8 @@ namespace scenarioengine
 			(void)dt;
 		}
 
+		bool IsSteady() { return true; }
+
 		void Trig()
 		{
 			if (object_->extern_control_)
@@ -461,6 +473,7 @@ namespace scenarioengine
 		AutonomousAction() : OSCPrivateAction(OSCPrivateAction::Type::AUTONOMOUS) {}
 
 		void Step(double dt) { }  // put driver model here
+		bool IsSteady() { return true; }
 
 		void Trig()
 		{
@@ -48,7 +48,45 @@ namespace scenarioengine
 		std::string model_filepath_;
 		int model_id_;
 
-		Object(Type type) : type_(type), id_(0), extern_control_(false), speed_(0), route_(0), model_filepath_("") {}
+		// Position before previous storyboard step, start of the latest motion segment
+		double prev_x_;
+		double prev_y_;
+		double prev_h_;
+
+		// Position before current storyboard step, start of the next motion segment
+		double next_x_;
+		double next_y_;
+		double next_h_;
+
+		Object(Type type) : type_(type), id_(0), extern_control_(false), speed_(0), route_(0), model_filepath_(""), 
+			prev_x_(0), prev_y_(0), prev_h_(0), next_x_(0), next_y_(0), next_h_(0) {}
+
+		/**
+		Start a new motion segment, to be called before each storyboard step. Conditions check the segment, 
+		so that positions and distances passed between two steps are detected regardless of step size. It 
+		spans from before previous storyboard step, hence includes motion by actions in that step also 
+		when evaluated before the action.
+		*/
+		void NextMotionSegment()
+		{
+			prev_x_ = next_x_;
+			prev_y_ = next_y_;
+			prev_h_ = next_h_;
+			next_x_ = pos_.GetX();
+			next_y_ = pos_.GetY();
+			next_h_ = pos_.GetH();
+		}
+
+		/**
+		Discard motion so far, e.g. at start or when teleported. Both current and next motion segment 
+		start from current position.
+		*/
+		void ResetMotion()
+		{
+			prev_x_ = next_x_ = pos_.GetX();
+			prev_y_ = next_y_ = pos_.GetY();
+			prev_h_ = next_h_ = pos_.GetH();
+		}
 	};
 
 	class Vehicle : public Object
@@ -19,6 +19,7 @@ ScenarioEngine::ScenarioEngine(std::string oscFilename, double startTime, Extern
 {
 	simulationTime = 0;
 	req_ext_control_ = ext_control;
+	odrManager = 0;
 	InitScenario(oscFilename, startTime, ext_control);
 }
 
@@ -26,6 +27,7 @@ ScenarioEngine::ScenarioEngine(const pugi::xml_document &xml_doc, std::string os
 {
 	simulationTime = 0;
 	req_ext_control_ = ext_control;
+	odrManager = 0;
 	InitScenario(xml_doc, oscFilename, startTime, ext_control);
 }
 
@@ -50,6 +52,7 @@ void ScenarioEngine::InitScenario(const pugi::xml_document &xml_doc, std::string
 ScenarioEngine::~ScenarioEngine()
 {
 	LOG("Closing");
+	delete odrManager;
 }
 
 void ScenarioEngine::step(double deltaSimTime, bool initial)	
@@ -68,16 +71,18 @@ void ScenarioEngine::step(double deltaSimTime, bool initial)
 		{
 			if (entities.object_[i]->extern_control_)
 			{
-				ObjectState o;
+				ObjectState *o = scenarioGateway.getObjectStatePtrById(entities.object_[i]->id_);
 
-				if (scenarioGateway.getObjectStateById(entities.object_[i]->id_, o) != 0)
+				if (o == 0)
 				{
 					LOG("Gateway did not provide state for external car %d", entities.object_[i]->id_);
 				}
 				else
 				{
-					entities.object_[i]->pos_ = o.state_.pos;
-					entities.object_[i]->speed_ = o.state_.speed;
+					std::minstd_rand random_generator = entities.object_[i]->pos_.GetRandomGenerator();
+					entities.object_[i]->pos_ = o->state_.pos;
+					entities.object_[i]->pos_.SetRandomGenerator(random_generator);
+					entities.object_[i]->speed_ = o->state_.speed;
 				}
 			}
 		}
@@ -104,223 +109,21 @@ void ScenarioEngine::step(double deltaSimTime, bool initial)
 		}
 	}
 
-	// Story 
-	for (size_t i=0; i< story.size(); i++)
+	for (size_t i = 0; i < entities.object_.size(); i++)
 	{
-		for (size_t j=0; j < story[i]->act_.size(); j++)
+		if (initial)
 		{
-			// Update deactivated elements' state to inactive - This could probably be done in some other way...
-			for (size_t k = 0; k < story[i]->act_[j]->sequence_.size(); k++)
-			{
-				for (size_t l = 0; l < story[i]->act_[j]->sequence_[k]->maneuver_.size(); l++)
-				{
-					OSCManeuver *maneuver = story[i]->act_[j]->sequence_[k]->maneuver_[l];
-
-					for (size_t m = 0; m < maneuver->event_.size(); m++)
-					{
-						for (size_t n = 0; n < maneuver->event_[m]->action_.size(); n++)
-						{
-							if (maneuver->event_[m]->action_[n]->state_ == OSCAction::State::DEACTIVATED)
-							{
-								maneuver->event_[m]->action_[n]->state_ = OSCAction::State::INACTIVE;
-							}
-						}
-						if (maneuver->event_[m]->state_ == Event::State::DEACTIVATED)
-						{
-							maneuver->event_[m]->state_ = Event::State::INACTIVE;
-						}
-					}
-				}
-			}
-			if (story[i]->act_[j]->state_ == Act::State::DEACTIVATED)
-			{
-				story[i]->act_[j]->state_ = Act::State::INACTIVE;
-			}
-
-			// Check Act conditions
-			if (!story[i]->act_[j]->IsActive())
-			{
-				// Check start conditions
-				for (size_t k = 0; k < story[i]->act_[j]->start_condition_group_.size(); k++)
-				{
-					for (size_t l = 0; l < story[i]->act_[j]->start_condition_group_[k]->condition_.size(); l++)
-					{
-						if (story[i]->act_[j]->start_condition_group_[k]->condition_[l]->Evaluate(story[i], simulationTime))
-						{
-							story[i]->act_[j]->Trig();
-						}
-					}
-				}
-			}
-			else
-			{
-				// If activated last step, make transition to activated
-				if (story[i]->act_[j]->state_ == Act::State::ACTIVATED)
-				{
-					story[i]->act_[j]->state_ = Act::State::ACTIVE;
-				}
-			}
-
-			if (story[i]->act_[j]->IsActive())
-			{
-				// Check end conditions
-				for (size_t k = 0; k < story[i]->act_[j]->end_condition_group_.size(); k++)
-				{
-					for (size_t l = 0; l < story[i]->act_[j]->end_condition_group_[k]->condition_.size(); l++)
-					{
-						if (story[i]->act_[j]->end_condition_group_[k]->condition_[l]->Evaluate(story[i], simulationTime))
-						{
-							story[i]->act_[j]->Stop();
-						}
-					}
-				}
-
-				// Check cancel conditions
-				for (size_t k = 0; k < story[i]->act_[j]->cancel_condition_group_.size(); k++)
-				{
-					for (size_t l = 0; l < story[i]->act_[j]->cancel_condition_group_[k]->condition_.size(); l++)
-					{
-						if (story[i]->act_[j]->cancel_condition_group_[k]->condition_[l]->Evaluate(story[i], simulationTime))
-						{
-							story[i]->act_[j]->Stop();
-						}
-					}
-				}
-			}
-
-			// Maneuvers
-			if (story[i]->act_[j]->IsActive())
-			{
-				for (size_t k = 0; k < story[i]->act_[j]->sequence_.size(); k++)
-				{
-					for (size_t l = 0; l < story[i]->act_[j]->sequence_[k]->maneuver_.size(); l++)
-					{
-						OSCManeuver *maneuver = story[i]->act_[j]->sequence_[k]->maneuver_[l];
-
-						// Events - may only execute one at a time
-						for (size_t m = 0; m < maneuver->event_.size(); m++)
-						{
-							Event *event = story[i]->act_[j]->sequence_[k]->maneuver_[l]->event_[m];
-
-							if (event->IsActive())
-							{
-								// If just activated, make transition to active
-								if (event->state_ == (Event::State)Act::State::ACTIVATED)
-								{
-									event->state_ = Event::State::ACTIVE;
-								}
-							}
-							else if(event->state_ == (Event::State)Act::State::DEACTIVATED)
-							{
-								// If just deactivated, make transition to inactive
-								event->state_ = Event::State::INACTIVE;
-							}
-						}
-						if(maneuver->GetActiveEventIdx() == -1 && maneuver->GetWaitingEventIdx() >= 0)
-						{
-							// When no active event, it's OK to trig waiting event
-							maneuver->event_[maneuver->GetWaitingEventIdx()]->Trig();
-						}
-
-
-						for (size_t m = 0; m < maneuver->event_.size(); m++)
-						{
-							Event *event = maneuver->event_[m];
-							
-							if (event->Triggable())
-							{
-								// Check event conditions
-								for (size_t n = 0; n < event->start_condition_group_.size(); n++)
-								{
-									for (size_t o = 0; o < event->start_condition_group_[n]->condition_.size(); o++)
-									{
-										if (event->start_condition_group_[n]->condition_[o]->Evaluate(story[i], simulationTime))
-										{
-											// Check priority
-											if (event->priority_ == Event::Priority::OVERWRITE)
-											{
-												// Deactivate any currently active event
-												if (maneuver->GetActiveEventIdx() >= 0)
-												{
-													LOG("Event %s cancelled", maneuver->event_[maneuver->GetActiveEventIdx()]->name_.c_str());
-													maneuver->event_[maneuver->GetActiveEventIdx()]->Stop();
-												}
-
-												// Activate trigged event
-												event->Trig();
-											}
-											else if (event->priority_ == Event::Priority::FOLLOWING)
-											{
-												// If already an active event, this event will wait
-												if (maneuver->GetActiveEventIdx() >= 0)
-												{
-													event->state_ = Event::State::WAITING;
-													LOG("Event %s is running, trigged event %s is waiting",
-														maneuver->event_[maneuver->GetActiveEventIdx()]->name_.c_str(), event->name_.c_str());
-												}
-												else
-												{
-													event->Trig();
-												}
-											}
-											else if(event->priority_ == Event::Priority::SKIP)
-											{
-												if (maneuver->GetActiveEventIdx() >= 0)
-												{
-													LOG("Event %s is running, skipping trigged %s", 
-														maneuver->event_[maneuver->GetActiveEventIdx()]->name_.c_str(), event->name_.c_str());
-												}
-												else
-												{
-													event->Trig();
-												}
-											}
-											else
-											{
-												LOG("Unknown event priority: %d", event->priority_);
-											}
-										}
-									}
-								}
-							}
-
-							// Update (step) all active actions, for all objects connected to the action
-							if (event->IsActive())
-							{
-								bool active = false;
-
-								for (size_t n = 0; n < event->action_.size(); n++)
-								{
-									//LOG("action %s state 1: %d", event->action_[n]->name_.c_str(), event->action_[n]->state_);
-									//LOG("action %s state 2: %d", event->action_[n]->name_.c_str(), event->action_[n]->state_);
-									if (event->action_[n]->state_ == OSCAction::State::TRIGGED)
-									{
-										event->action_[n]->state_ = OSCAction::State::ACTIVATED;
-									}
-									else if (event->action_[n]->state_ == OSCAction::State::ACTIVATED)
-									{
-										event->action_[n]->state_ = OSCAction::State::ACTIVE;
-									}
-
-									if (event->action_[n]->IsActive())
-									{
-										event->action_[n]->Step(deltaSimTime);
-										active = active || (event->action_[n]->IsActive());
-									}
-								}
-								if (!active)
-								{
-									// Actions done -> Set event done
-									event->Stop();
-								}
-							}
-						}
-					}
-				}
-			}
+			// No motion before initial positions
+			entities.object_[i]->ResetMotion();
 		}
+
+		// Before the story, so that motion by actions is included in the segment of next step
+		entities.object_[i]->NextMotionSegment();
 	}
 
+	// Story 
+	storyboard.Step(deltaSimTime, simulationTime);
+
 	// Report resulting states to the gateway
 	for (size_t i = 0; i < entities.object_.size(); i++)
 	{
@@ -329,18 +132,86 @@ void ScenarioEngine::step(double deltaSimTime, bool initial)
 		if (initial)
 		{
 			// Report all scenario objects the initial run, to establish initial positions and speed = 0
-			scenarioGateway.reportObject(ObjectState(obj->id_, obj->name_, obj->model_id_, obj->extern_control_, simulationTime, &obj->pos_, 0.0));
+			scenarioGateway.reportObject(obj->id_, obj->name_, obj->model_id_, obj->extern_control_, simulationTime, &obj->pos_, 0.0);
 		}
 		else if (!obj->extern_control_)
 		{
 			// Then report all except externally controlled objects
-			scenarioGateway.reportObject(ObjectState(obj->id_, obj->name_, obj->model_id_, obj->extern_control_, simulationTime, &obj->pos_, obj->speed_));
+			scenarioGateway.reportObject(obj->id_, obj->name_, obj->model_id_, obj->extern_control_, simulationTime, &obj->pos_, obj->speed_);
 		}
 	}
 
 	stepObjects(deltaSimTime);
 }
 
+// Distance (m) an object can move before leaving its current road, which for Position::MoveAlongS() 
+// is limited to a few road links per step
+static double DistanceToRoadEnd(Object *obj)
+{
+	roadmanager::Position *pos = &obj->pos_;
+
+	if (pos->GetRoute())
+	{
+		// Moved by route s, any distance
+		return INFINITY;
+	}
+
+	roadmanager::Road *road = pos->GetOpenDrive()->GetRoadById(pos->GetTrackId());
+	if (road == 0)
+	{
+		return 0;
+	}
+
+	// Same as MoveAlongS(): Along s in right lanes, reversed when heading against driving direction
+	bool along_s = pos->GetLaneId() < 0;
+	if (pos->GetAbsAngleDifference(pos->GetDrivingDirection(), pos->GetH()) > M_PI_2)
+	{
+		along_s = !along_s;
+	}
+	if (obj->speed_ < 0)
+	{
+		along_s = !along_s;
+	}
+
+	return along_s ? road->GetLength() - pos->GetS() : pos->GetS();
+}
+
+double ScenarioEngine::GetAdaptiveStepSize(double min_dt, double max_dt)
+{
+	double dt = max_dt;
+
+	for (size_t i = 0; i < init.private_action_.size(); i++)
+	{
+		if (init.private_action_[i]->IsActive() && !init.private_action_[i]->IsSteady())
+		{
+			return min_dt;
+		}
+	}
+
+	for (size_t i = 0; i < entities.object_.size(); i++)
+	{
+		Object *obj = entities.object_[i];
+
+		if (obj->extern_control_)
+		{
+			// Motion not known in advance
+			return min_dt;
+		}
+
+		// Limit steps to the end of current road. If within reach of a small step anyway, e.g. 
+		// stuck at a dead end, the limit makes no difference.
+		double dist = DistanceToRoadEnd(obj);
+		if (dist > fabs(obj->speed_) * min_dt)
+		{
+			dt = fmin(dt, dist / fabs(obj->speed_));
+		}
+	}
+
+	dt = fmin(dt, storyboard.PredictNextEvent(simulationTime) - simulationTime);
+
+	return dt < min_dt ? min_dt : dt;
+}
+
 void ScenarioEngine::printSimulationTime()
 {
 	LOG("simulationTime = %.2f", simulationTime);
@@ -365,19 +236,23 @@ bool ScenarioEngine::GetExtControl()
 
 void ScenarioEngine::parseScenario(double startTime, ExternalControlMode ext_control)
 {
-	// Init road manager
+	// Init road manager. The engine owns its road network, so that several engines can run side by side.
 	scenarioReader.parseRoadNetwork(roadNetwork);
-	if (!roadmanager::Position::LoadOpenDrive(getOdrFilename().c_str()))
+	delete odrManager;
+	odrManager = new roadmanager::OpenDrive;
+	if (!odrManager->LoadOpenDriveFile(getOdrFilename().c_str()))
 	{
 		throw std::invalid_argument(std::string("Failed to load OpenDRIVE file ") + getOdrFilename().c_str());
 	}
-	odrManager = roadmanager::Position::GetOpenDrive();
+	scenarioReader.SetOpenDrive(odrManager);
+	scenarioGateway.SetOpenDrive(odrManager);
 
 	scenarioReader.parseParameterDeclaration();
 	scenarioReader.parseCatalogs(catalogs, &entities);
 	scenarioReader.parseEntities(entities, &catalogs);
 	scenarioReader.parseInit(init, &entities, &catalogs);
 	scenarioReader.parseStory(story, &entities, &catalogs);
+	storyboard.Compile(story);
 
 	if (req_ext_control_ > 0 && entities.object_.size() > 0)
 	{
@@ -387,6 +262,10 @@ void ScenarioEngine::parseScenario(double startTime, ExternalControlMode ext_con
 
 	LOG("Requested external control: %d - %s, actual: %s", ext_control, scenarioReader.ExtControlMode2Str(ext_control).c_str(), GetExtControl()?"on":"off");
 
+	// Seed random choices, e.g. at junctions, from scenario parameter if available, else by time
+	std::string seed_str = scenarioReader.hasParameter(RANDOM_SEED_PARAMETER) ? scenarioReader.getParameter(RANDOM_SEED_PARAMETER) : "";
+	SetRandomSeed(seed_str.empty() ? (unsigned int)time(0) : (unsigned int)strtoul(seed_str.c_str(), 0, 10));
+
 
 	this->startTime = startTime;
 
@@ -399,6 +278,19 @@ void ScenarioEngine::parseScenario(double startTime, ExternalControlMode ext_con
 	}
 }
 
+void ScenarioEngine::SetRandomSeed(unsigned int seed)
+{
+	LOG("Random seed: %u", seed);
+	random_seed_ = seed;
+	odrManager->SetRandomSeed(seed);
+
+	// Each object gets its own sequence, independent of the order in which objects draw numbers
+	for (size_t i = 0; i < entities.object_.size(); i++)
+	{
+		entities.object_[i]->pos_.SetRandomSeed(seed, (unsigned int)entities.object_[i]->id_);
+	}
+}
+
 void ScenarioEngine::stepObjects(double dt)
 {
 	for (size_t i = 0; i < entities.object_.size(); i++)
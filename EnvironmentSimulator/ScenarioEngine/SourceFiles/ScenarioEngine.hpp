@@ -21,10 +21,14 @@
 #include "Entities.hpp"
 #include "Init.hpp"
 #include "Story.hpp"
+#include "Storyboard.hpp"
 #include "ScenarioGateway.hpp"
 #include "ScenarioReader.hpp"
 #include "RoadNetwork.hpp"
 
+// Name of the optional scenario parameter specifying the random seed
+#define RANDOM_SEED_PARAMETER "$RandomSeed"
+
 namespace scenarioengine
 {
 
@@ -38,7 +42,7 @@ namespace scenarioengine
 
 		ScenarioEngine(std::string oscFilename, double startTime, ExternalControlMode ext_control = ExternalControlMode::EXT_CONTROL_BY_OSC);
 		ScenarioEngine(const pugi::xml_document &xml_doc, std::string oscFilename, double startTime, ExternalControlMode ext_control = ExternalControlMode::EXT_CONTROL_BY_OSC);
-		ScenarioEngine() {};
+		ScenarioEngine() : odrManager(0) {};
 		~ScenarioEngine();
 
 		void InitScenario(std::string oscFilename, double startTime, ExternalControlMode ext_control);
@@ -50,6 +54,25 @@ namespace scenarioengine
 		void printSimulationTime();
 		void stepObjects(double dt);
 
+		/**
+		Step size for adaptive stepping: The largest step within limits that does not pass any predicted 
+		scenario event, see Storyboard::PredictNextEvent(). Objects are moved at most to the end of their 
+		current road per step, so road links and junctions are passed by small steps.
+		@param min_dt Step size used when something is going on, or about to happen
+		@param max_dt Largest step size
+		@return Step size (s)
+		*/
+		double GetAdaptiveStepSize(double min_dt, double max_dt);
+
+		/**
+		Seed random choices of the scenario, e.g. at junctions. Each object gets its own generator, 
+		seeded by the seed and its ID, so that a run can be reproduced. By default the seed is taken 
+		from scenario parameter RANDOM_SEED_PARAMETER if declared, else from current time.
+		@param seed Seed value
+		*/
+		void SetRandomSeed(unsigned int seed);
+		unsigned int GetRandomSeed() { return random_seed_; }
+
 		std::string getSceneGraphFilename() { return roadNetwork.SceneGraph.filepath; }
 		std::string getOdrFilename() { return roadNetwork.Logics.filepath; }
 		roadmanager::OpenDrive *getRoadManager() { return odrManager; }
@@ -62,6 +85,7 @@ namespace scenarioengine
 		Catalogs catalogs;
 		Init init;
 		std::vector<Story*> story;
+		Storyboard storyboard;  // Flat, compiled view of the stories, used for stepping
 		ScenarioReader scenarioReader;
 		RoadNetwork roadNetwork;
 		roadmanager::OpenDrive *odrManager;
@@ -71,6 +95,7 @@ namespace scenarioengine
 		double startTime;
 		double simulationTime;
 		double timeStep;
+		unsigned int random_seed_;
 
 		// 
 
@@ -79,7 +79,7 @@ void ObjectState::Print()
 
 // ScenarioGateway
 
-ScenarioGateway::ScenarioGateway()
+ScenarioGateway::ScenarioGateway() : od_(0)
 {
 	objectState_.clear();
 }
@@ -97,6 +97,19 @@ ScenarioGateway::~ScenarioGateway()
 }
 
 
+ObjectState *ScenarioGateway::getObjectStatePtrById(int id)
+{
+	for (size_t i = 0; i < objectState_.size(); i++)
+	{
+		if (objectState_[i]->state_.id == id)
+		{
+			return objectState_[i];
+		}
+	}
+
+	return 0;
+}
+
 int ScenarioGateway::getObjectStateById(int id, ObjectState &objectState)
 {
 	for (size_t i = 0; i < objectState_.size(); i++)
@@ -115,34 +128,102 @@ int ScenarioGateway::getObjectStateById(int id, ObjectState &objectState)
 
 void ScenarioGateway::reportObject(ObjectState objectState)
 {
-	bool found = false;
-	
-	// Check whether the object is already present in the list of active objects
-	for (size_t i = 0; i < objectState_.size(); i++)
+	ObjectState *os = getObjectStatePtrById(objectState.state_.id);
+
+	if (os == 0)
 	{
-		if (objectState_[i]->state_.id == objectState.state_.id)
-		{
-			found = true;
-			
-			// Update state
-			*objectState_[i] = objectState;
-			break;
-		}
+		// Add object
+		LOG("Adding %s state: (%d, %.2f)", objectState.state_.name, objectState.state_.id, objectState.state_.timeStamp);
+		os = new ObjectState;
+		objectState_.push_back(os);
 	}
 
-	if (!found)
+	// Update state
+	*os = objectState;
+
+	recordObjectState(os);
+}
+
+void ScenarioGateway::reportObject(int id, std::string name, int model_id, int ext_control, double timestamp, roadmanager::Position *pos, double speed)
+{
+	ObjectState *os = updateObjectInfo(id, name, model_id, ext_control, timestamp, speed);
+
+	os->state_.pos = *pos;
+
+	recordObjectState(os);
+}
+
+void ScenarioGateway::reportObject(int id, std::string name, int model_id, int ext_control, double timestamp, double x, double y, double z, double h, double p, double r, double speed)
+{
+	ObjectState *os = updateObjectInfo(id, name, model_id, ext_control, timestamp, speed);
+
+	os->state_.pos.SetInertiaPos(x, y, z, h, p, r);
+
+	recordObjectState(os);
+}
+
+void ScenarioGateway::reportObject(int id, std::string name, int model_id, int ext_control, double timestamp, int roadId, int laneId, double laneOffset, double s, double speed)
+{
+	ObjectState *os = updateObjectInfo(id, name, model_id, ext_control, timestamp, speed);
+
+	os->state_.pos.SetLanePos(roadId, laneId, s, laneOffset);
+
+	recordObjectState(os);
+}
+
+ObjectState *ScenarioGateway::updateObjectInfo(int id, std::string name, int model_id, int ext_control, double timestamp, double speed)
+{
+	ObjectState *os = getObjectStatePtrById(id);
+
+	if (os == 0)
 	{
 		// Add object
-		LOG("Adding %s state: (%d, %.2f)", objectState.state_.name, objectState.state_.id, objectState.state_.timeStamp);
-		ObjectState *os = new ObjectState;
-		*os = objectState;
+		LOG("Adding %s state: (%d, %.2f)", name.c_str(), id, timestamp);
+		os = new ObjectState;
+		os->state_.pos.SetOpenDrive(od_);
 		objectState_.push_back(os);
+		os->state_.id = id;
 	}
 
+	os->state_.model_id = model_id;
+	os->state_.ext_control = ext_control;
+	os->state_.timeStamp = (float)timestamp;
+	strncpy(os->state_.name, name.c_str(), NAME_LEN);
+	os->state_.speed = (float)speed;
+
+	return os;
+}
+
+void ScenarioGateway::recordObjectState(ObjectState *objectState)
+{
 	// Write status to file - for later replay
 	if (data_file_.is_open())
 	{
-		data_file_.write((char*)&objectState, sizeof(objectState.state_));
+		ObjectStateStructDat dat;
+		roadmanager::Position *pos = &objectState->state_.pos;
+
+		memset(&dat, 0, sizeof(dat));
+		dat.id = objectState->state_.id;
+		dat.model_id = objectState->state_.model_id;
+		dat.ext_control = objectState->state_.ext_control;
+		dat.timeStamp = objectState->state_.timeStamp;
+		strncpy(dat.name, objectState->state_.name, NAME_LEN);
+		dat.speed = objectState->state_.speed;
+
+		pos->Evaluate();
+		dat.pos.x = (float)pos->GetX();
+		dat.pos.y = (float)pos->GetY();
+		dat.pos.z = (float)pos->GetZ();
+		dat.pos.h = (float)pos->GetH();
+		dat.pos.p = (float)pos->GetP();
+		dat.pos.r = (float)pos->GetR();
+		dat.pos.roadId = pos->GetTrackId();
+		dat.pos.laneId = pos->GetLaneId();
+		dat.pos.offset = (float)pos->GetOffset();
+		dat.pos.t = (float)pos->GetT();
+		dat.pos.s = (float)pos->GetS();
+
+		data_file_.write((char*)&dat, sizeof(dat));
 	}
 }
 
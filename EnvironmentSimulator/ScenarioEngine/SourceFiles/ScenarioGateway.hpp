@@ -35,6 +35,35 @@ namespace scenarioengine
 		float speed;
 	};
 
+	// Position as recorded to file. Plain, evaluated coordinates only, since a roadmanager::Position 
+	// refers to process local data, like its road network.
+	struct ObjectPositionStructDat
+	{
+		float x;
+		float y;
+		float z;
+		float h;
+		float p;
+		float r;
+		int roadId;
+		int laneId;
+		float offset;
+		float t;
+		float s;
+	};
+
+	// Object state as recorded to file, see ScenarioGateway::RecordToFile()
+	struct ObjectStateStructDat
+	{
+		int id;
+		int model_id;
+		int ext_control; // 1=on 0=off
+		float timeStamp;
+		char name[NAME_LEN];
+		ObjectPositionStructDat pos;
+		float speed;
+	};
+
 	class ObjectState
 	{
 	public:
@@ -63,15 +92,35 @@ namespace scenarioengine
 		~ScenarioGateway();
 
 		void reportObject(ObjectState objectState);
+
+		/**
+		Report object state by updating the stored state of the object in place. Since the position 
+		object is kept between reports, road coordinates are looked up incrementally from last one.
+		*/
+		void reportObject(int id, std::string name, int model_id, int ext_control, double timestamp, roadmanager::Position *pos, double speed);
+		void reportObject(int id, std::string name, int model_id, int ext_control, double timestamp, double x, double y, double z, double h, double p, double r, double speed);
+		void reportObject(int id, std::string name, int model_id, int ext_control, double timestamp, int roadId, int laneId, double laneOffset, double s, double speed);
+
 		int getNumberOfObjects() { return (int)objectState_.size(); }
 		ObjectState getObjectStateByIdx(int idx) { return *objectState_[idx]; }
 		ObjectState *getObjectStatePtrByIdx(int idx) { return objectState_[idx]; }
+		ObjectState *getObjectStatePtrById(int id);
 		int getObjectStateById(int idx, ObjectState &objState);
 		int RecordToFile(std::string filename, std::string odr_filename, std::string model_filename);
 
+		/**
+		Set the road network on which positions of objects added by report are resolved
+		@param od Road network of the scenario
+		*/
+		void SetOpenDrive(roadmanager::OpenDrive *od) { od_ = od; }
+
 	private:
+		ObjectState *updateObjectInfo(int id, std::string name, int model_id, int ext_control, double timestamp, double speed);
+		void recordObjectState(ObjectState *objectState);
+
 		std::vector<ObjectState*> objectState_;
 		std::ofstream data_file_;
+		roadmanager::OpenDrive *od_;
 	};
 
 }
\ No newline at end of file
@@ -36,6 +36,7 @@ static std::string dirnameOf(const std::string& fname)
 ScenarioReader::ScenarioReader()
 {
 	objectCnt = 0;
+	od_ = 0;
 }
 
 void ScenarioReader::addParameter(std::string name, std::string value)
@@ -49,6 +50,19 @@ void ScenarioReader::addParameter(std::string name, std::string value)
 	parameterDeclaration.Parameter.back().value = value;
 }
 
+bool ScenarioReader::hasParameter(std::string name)
+{
+	for (size_t i = 0; i < parameterDeclaration.Parameter.size(); i++)
+	{
+		if (parameterDeclaration.Parameter[i].name == name)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
 std::string ScenarioReader::getParameter(std::string name)
 {
 	LOG("Resolve parameter %s", name.c_str());
@@ -449,6 +463,7 @@ void ScenarioReader::parseEntities(Entities &entities, Catalogs *catalogs)
 		{
 			obj->name_ = ReadAttribute(entitiesChild.attribute("name"));
 			obj->id_ = (int)entities.object_.size();
+			obj->pos_.SetOpenDrive(od_);
 			entities.object_.push_back(obj);
 			objectCnt++;
 		}
@@ -497,7 +512,7 @@ OSCPosition *ScenarioReader::parseOSCPosition(pugi::xml_node positionNode, Entit
 			double p = strtod(ReadAttribute(positionChild.attribute("p")));
 			double r = strtod(ReadAttribute(positionChild.attribute("r")));
 
-			OSCPositionWorld *pos = new OSCPositionWorld(x, y, z, h, p, r);
+			OSCPositionWorld *pos = new OSCPositionWorld(x, y, z, h, p, r, od_);
 
 			pos_return = (OSCPosition*)pos;
 		}
@@ -522,7 +537,7 @@ OSCPosition *ScenarioReader::parseOSCPosition(pugi::xml_node positionNode, Entit
 				parseOSCOrientation(orientation, orientation_node);
 			}
 
-			OSCPositionRelativeObject *pos = new OSCPositionRelativeObject(object, dx, dy, dz, orientation);
+			OSCPositionRelativeObject *pos = new OSCPositionRelativeObject(object, dx, dy, dz, orientation, od_);
 
 			pos_return = (OSCPosition*)pos;
 		}
@@ -544,7 +559,7 @@ OSCPosition *ScenarioReader::parseOSCPosition(pugi::xml_node positionNode, Entit
 				parseOSCOrientation(orientation, orientation_node);
 			}
 
-			OSCPositionRelativeLane *pos = new OSCPositionRelativeLane(object, dLane, ds, offset, orientation);
+			OSCPositionRelativeLane *pos = new OSCPositionRelativeLane(object, dLane, ds, offset, orientation, od_);
 
 			pos_return = (OSCPosition*)pos;
 
@@ -579,14 +594,14 @@ OSCPosition *ScenarioReader::parseOSCPosition(pugi::xml_node positionNode, Entit
 				LOG("OSCPositionLane orientation not supported yet, reading but ignoring...");
 			}
 
-			OSCPositionLane *pos = new OSCPositionLane(road_id, lane_id, s, offset, orientation);
+			OSCPositionLane *pos = new OSCPositionLane(road_id, lane_id, s, offset, orientation, od_);
 
 			pos_return = (OSCPosition*)pos;
 		}
 		else if (positionChildName == "Route")
 		{
 			roadmanager::Route *route = 0;
-			OSCPositionRoute *pos = new OSCPositionRoute();
+			OSCPositionRoute *pos = new OSCPositionRoute(od_);
 
 			for (pugi::xml_node routeChild = positionChild.first_child(); routeChild; routeChild = routeChild.next_sibling())
 			{
@@ -782,6 +797,7 @@ OSCPrivateAction *ScenarioReader::parseOSCPrivateAction(pugi::xml_node actionNod
 							pugi::xml_node limits_node = dynamics_node.child("Limited");
 							if (limits_node != NULL)
 							{
+								action_dist->dynamics_.none_ = false;
 								action_dist->dynamics_.max_acceleration_ = strtod(ReadAttribute(limits_node.attribute("maxAcceleration")));
 								action_dist->dynamics_.max_deceleration_ = strtod(ReadAttribute(limits_node.attribute("maxDeceleration")));
 								action_dist->dynamics_.max_speed_ = strtod(ReadAttribute(limits_node.attribute("maxSpeed")));
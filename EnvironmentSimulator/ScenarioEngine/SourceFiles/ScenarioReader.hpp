@@ -44,6 +44,12 @@ namespace scenarioengine
 
 		void LoadCatalog(pugi::xml_node catalogChild, Entities *entities, Catalogs *catalogs);
 
+		/**
+		Set the road network of the scenario. Positions of entities, conditions and routes are created on it.
+		@param od Road network, loaded before parsing anything but the RoadNetwork element
+		*/
+		void SetOpenDrive(roadmanager::OpenDrive *od) { od_ = od; }
+
 		// RoadNetwork
 		void parseRoadNetwork(RoadNetwork &roadNetwork);
 		void parseOSCFile(OSCFile &file, pugi::xml_node fileNode);
@@ -75,6 +81,7 @@ namespace scenarioengine
 
 		// Help functions
 		std::string getParameter(std::string name);
+		bool hasParameter(std::string name);
 		void addParameter(std::string name, std::string value);
 
 		std::string ExtControlMode2Str(ExternalControlMode mode)
@@ -91,6 +98,7 @@ namespace scenarioengine
 		int objectCnt;
 		std::string oscFilename;
 		ExternalControlMode req_ext_control_;  // Requested Ego (id 0) control mode
+		roadmanager::OpenDrive *od_;
 
 		// Use always this method when reading attributes, it will resolve any variables
 		std::string ReadAttribute(pugi::xml_attribute attribute, bool required = false);
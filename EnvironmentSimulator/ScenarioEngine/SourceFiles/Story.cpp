@@ -16,71 +16,79 @@
 using namespace scenarioengine;
 
 
-Story::Story()
+Story::Story() : indexed_(false)
 {
 	LOG("Story: New Story created");
 }
 
-Act* Story::FindActByName(std::string name)
+void Story::BuildIndex()
 {
-	for (size_t i = 0; i < act_.size(); i++)
-	{
-		if (name == act_[i]->name_)
-		{
-			return act_[i];
-		}
-	}
+	act_by_name_.clear();
+	event_by_name_.clear();
+	action_by_name_.clear();
 
-	return nullptr;
-}
-
-Event* Story::FindEventByName(std::string name)
-{
+	// In case of duplicate names, the first occurrence is kept (insert does not overwrite)
 	for (size_t i = 0; i < act_.size(); i++)
 	{
+		act_by_name_.insert(std::make_pair(act_[i]->name_, act_[i]));
+
 		for (size_t j = 0; j < act_[i]->sequence_.size(); j++)
 		{
 			for (size_t k = 0; k < act_[i]->sequence_[j]->maneuver_.size(); k++)
 			{
-				for (size_t l = 0; l < act_[i]->sequence_[j]->maneuver_[k]->event_.size(); l++)
+				OSCManeuver *maneuver = act_[i]->sequence_[j]->maneuver_[k];
+
+				for (size_t l = 0; l < maneuver->event_.size(); l++)
 				{
-					Event *event = act_[i]->sequence_[j]->maneuver_[k]->event_[l];
-					if (name == event->name_)
+					Event *event = maneuver->event_[l];
+					event_by_name_.insert(std::make_pair(event->name_, event));
+
+					for (size_t m = 0; m < event->action_.size(); m++)
 					{
-						return event;
+						action_by_name_.insert(std::make_pair(event->action_[m]->name_, event->action_[m]));
 					}
 				}
 			}
 		}
 	}
 
-	return nullptr;
+	indexed_ = true;
+}
+
+Act* Story::FindActByName(std::string name)
+{
+	if (!indexed_)
+	{
+		BuildIndex();
+	}
+
+	std::map<std::string, Act*>::iterator it = act_by_name_.find(name);
+
+	return it != act_by_name_.end() ? it->second : nullptr;
+}
+
+Event* Story::FindEventByName(std::string name)
+{
+	if (!indexed_)
+	{
+		BuildIndex();
+	}
+
+	std::map<std::string, Event*>::iterator it = event_by_name_.find(name);
+
+	return it != event_by_name_.end() ? it->second : nullptr;
 }
 
 OSCAction * Story::FindActionByName(std::string name)
 {
-	for (size_t i = 0; i < act_.size(); i++)
+	if (!indexed_)
 	{
-		for (size_t j = 0; j < act_[i]->sequence_.size(); j++)
-		{
-			for (size_t k = 0; k < act_[i]->sequence_[j]->maneuver_.size(); k++)
-			{
-				for (size_t l = 0; l < act_[i]->sequence_[j]->maneuver_[k]->event_.size(); l++)
-				{
-					for (size_t m = 0; m < act_[i]->sequence_[j]->maneuver_[k]->event_[l]->action_.size(); m++)
-					{
-						OSCAction *action = act_[i]->sequence_[j]->maneuver_[k]->event_[l]->action_[m];
-						if (name == action->name_)
-						{
-							return action;
-						}
-					}
-				}
-			}
-		}
+		BuildIndex();
 	}
 
-	return nullptr;
+	std::map<std::string, OSCAction*>::iterator it = action_by_name_.find(name);
+
+	return it != action_by_name_.end() ? it->second : nullptr;
 }
 
 void Story::Print()
@@ -18,6 +18,7 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <map>
 
 namespace scenarioengine
 {
@@ -92,12 +93,24 @@ namespace scenarioengine
 		OSCAction* FindActionByName(std::string name);
 		void Print();
 
+		/**
+		Index acts, events and actions by name, for fast lookup by conditions referring to them. 
+		Done on first lookup unless called explicitly. Call again if the story is changed.
+		*/
+		void BuildIndex();
+
 		std::vector<Act*> act_;
 
 		std::string owner_;
 		std::string name_;
 
 		void Step(double dt);
+
+	private:
+		bool indexed_;
+		std::map<std::string, Act*> act_by_name_;
+		std::map<std::string, Event*> event_by_name_;
+		std::map<std::string, OSCAction*> action_by_name_;
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,736 @@
+/* 
+ * esmini - Environment Simulator Minimalistic 
+ * https://github.com/esmini/esmini
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * 
+ * Copyright (c) partners of Simulation Scenarios
+ * https://sites.google.com/view/simulationscenarios
+ */
+
+#include "Storyboard.hpp"
+#include "CommonMini.hpp"
+
+#include <map>
+#include <math.h>
+
+using namespace scenarioengine;
+
+Storyboard::Range Storyboard::AddConditions(std::vector<OSCConditionGroup*> &group)
+{
+	Range range;
+
+	// Conditions of all groups are OR:ed, so just append them in order
+	range.first_ = (int)condition_.size();
+	for (size_t i = 0; i < group.size(); i++)
+	{
+		for (size_t j = 0; j < group[i]->condition_.size(); j++)
+		{
+			ConditionEntry entry;
+
+			entry.condition_ = group[i]->condition_[j];
+			entry.wake_cause_ = OSCCondition::WAKE_ALWAYS;
+			entry.wake_time_ = 0;
+			entry.sleeping_ = false;  // Always evaluate first time
+			entry.input_.first_ = entry.input_.last_ = 0;
+			entry.input_version_ = 0;
+
+			condition_.push_back(entry);
+		}
+	}
+	range.last_ = (int)condition_.size();
+
+	return range;
+}
+
+void Storyboard::ResolveInputs(int condition_idx, Story *story)
+{
+	ConditionEntry &entry = condition_[condition_idx];
+	OSCCondition *condition = entry.condition_;
+
+	// Register as waiter on any referred story element, same lookup as done by the condition itself
+	if (condition->base_type_ == OSCCondition::ConditionType::BY_STATE)
+	{
+		TrigByState *trigger = (TrigByState*)condition;
+		TrigByState::StoryElementType element_type = trigger->type_ == TrigByState::Type::AT_START ?
+			((TrigAtStart*)trigger)->element_type_ : ((TrigAfterTermination*)trigger)->element_type_;
+
+		if (element_type == TrigByState::StoryElementType::ACT)
+		{
+			Act *act = story->FindActByName(trigger->element_name_);
+			for (size_t i = 0; act && i < act_.size(); i++)
+			{
+				if (act_[i].act_ == act)
+				{
+					act_[i].waiter_.push_back(condition_idx);
+				}
+			}
+		}
+		else if (element_type == TrigByState::StoryElementType::EVENT)
+		{
+			Event *event = story->FindEventByName(trigger->element_name_);
+			for (size_t i = 0; event && i < event_.size(); i++)
+			{
+				if (event_[i].event_ == event)
+				{
+					event_[i].waiter_.push_back(condition_idx);
+				}
+			}
+		}
+		else if (element_type == TrigByState::StoryElementType::ACTION)
+		{
+			OSCAction *action = story->FindActionByName(trigger->element_name_);
+			for (size_t i = 0; action && i < action_.size(); i++)
+			{
+				if (action_[i].action_ == action)
+				{
+					action_[i].waiter_.push_back(condition_idx);
+				}
+			}
+		}
+	}
+
+	// Register input objects, for conditions depending on object positions
+	std::vector<Object*> object;
+	condition->GetInputObjects(object);
+
+	entry.input_.first_ = (int)input_object_.size();
+	for (size_t i = 0; i < object.size(); i++)
+	{
+		size_t j;
+
+		if (object[i] == 0)
+		{
+			continue;
+		}
+
+		for (j = 0; j < object_.size() && object_[j].object_ != object[i]; j++);
+
+		if (j == object_.size())
+		{
+			ObjectEntry object_entry;
+
+			object_entry.object_ = object[i];
+			object_entry.version_ = 0;
+			object_entry.checked_ = motion_epoch_;
+			GetMotionState(object[i], object_entry.state_);
+			object_.push_back(object_entry);
+		}
+		input_object_.push_back((int)j);
+	}
+	entry.input_.last_ = (int)input_object_.size();
+}
+
+void Storyboard::Compile(std::vector<Story*> &story)
+{
+	act_.clear();
+	maneuver_.clear();
+	event_.clear();
+	action_.clear();
+	condition_.clear();
+	object_.clear();
+	input_object_.clear();
+	wake_queue_ = std::priority_queue<TimedWakeup, std::vector<TimedWakeup>, std::greater<TimedWakeup> >();
+
+	for (size_t i = 0; i < story.size(); i++)
+	{
+		for (size_t j = 0; j < story[i]->act_.size(); j++)
+		{
+			Act *act = story[i]->act_[j];
+			ActEntry act_entry;
+
+			act_entry.act_ = act;
+			act_entry.story_ = story[i];
+			act_entry.start_condition_ = AddConditions(act->start_condition_group_);
+			act_entry.end_condition_ = AddConditions(act->end_condition_group_);
+			act_entry.cancel_condition_ = AddConditions(act->cancel_condition_group_);
+			act_entry.maneuver_.first_ = (int)maneuver_.size();
+			act_entry.touched_ = true;  // Resolve any initial transient states first step
+
+			for (size_t k = 0; k < act->sequence_.size(); k++)
+			{
+				for (size_t l = 0; l < act->sequence_[k]->maneuver_.size(); l++)
+				{
+					OSCManeuver *maneuver = act->sequence_[k]->maneuver_[l];
+					ManeuverEntry maneuver_entry;
+
+					maneuver_entry.maneuver_ = maneuver;
+					maneuver_entry.event_.first_ = (int)event_.size();
+
+					for (size_t m = 0; m < maneuver->event_.size(); m++)
+					{
+						Event *event = maneuver->event_[m];
+						EventEntry event_entry;
+
+						event_entry.event_ = event;
+						event_entry.start_condition_ = AddConditions(event->start_condition_group_);
+						event_entry.action_.first_ = (int)action_.size();
+						for (size_t n = 0; n < event->action_.size(); n++)
+						{
+							ActionEntry action_entry;
+							action_entry.action_ = event->action_[n];
+							action_.push_back(action_entry);
+						}
+						event_entry.action_.last_ = (int)action_.size();
+
+						event_.push_back(event_entry);
+					}
+					maneuver_entry.event_.last_ = (int)event_.size();
+
+					maneuver_.push_back(maneuver_entry);
+				}
+			}
+			act_entry.maneuver_.last_ = (int)maneuver_.size();
+
+			act_.push_back(act_entry);
+		}
+
+		story[i]->BuildIndex();
+	}
+
+	// All elements in place, now find what each condition depends on
+	for (size_t i = 0; i < act_.size(); i++)
+	{
+		ActEntry &act = act_[i];
+		Range range[3] = { act.start_condition_, act.end_condition_, act.cancel_condition_ };
+
+		for (int j = 0; j < 3; j++)
+		{
+			for (int k = range[j].first_; k < range[j].last_; k++)
+			{
+				ResolveInputs(k, act.story_);
+			}
+		}
+
+		for (int j = act.maneuver_.first_; j < act.maneuver_.last_; j++)
+		{
+			for (int k = maneuver_[j].event_.first_; k < maneuver_[j].event_.last_; k++)
+			{
+				for (int l = event_[k].start_condition_.first_; l < event_[k].start_condition_.last_; l++)
+				{
+					ResolveInputs(l, act.story_);
+				}
+			}
+		}
+	}
+
+	LOG("Storyboard compiled: %d acts, %d maneuvers, %d events, %d actions, %d conditions, %d input objects",
+		(int)act_.size(), (int)maneuver_.size(), (int)event_.size(), (int)action_.size(), (int)condition_.size(), (int)object_.size());
+}
+
+void Storyboard::GetMotionState(Object *object, MotionState &state)
+{
+	roadmanager::Position *pos = &object->pos_;
+
+	state.x_ = pos->GetX();
+	state.y_ = pos->GetY();
+	state.h_ = pos->GetH();
+	state.s_ = pos->GetS();
+	state.t_ = pos->GetT();
+	state.lane_id_ = pos->GetLaneId();
+	state.speed_ = object->speed_;
+	state.prev_x_ = object->prev_x_;
+	state.prev_y_ = object->prev_y_;
+	state.prev_h_ = object->prev_h_;
+}
+
+unsigned int Storyboard::ObjectVersion(int idx)
+{
+	ObjectEntry &entry = object_[idx];
+
+	// Objects only move between steps and by actions, so one check per motion epoch is enough
+	if (entry.checked_ != motion_epoch_)
+	{
+		MotionState state;
+
+		GetMotionState(entry.object_, state);
+		if (state.x_ != entry.state_.x_ || state.y_ != entry.state_.y_ || state.h_ != entry.state_.h_ ||
+			state.s_ != entry.state_.s_ || state.t_ != entry.state_.t_ || state.lane_id_ != entry.state_.lane_id_ ||
+			state.speed_ != entry.state_.speed_ || state.prev_x_ != entry.state_.prev_x_ || state.prev_y_ != entry.state_.prev_y_ ||
+			state.prev_h_ != entry.state_.prev_h_)
+		{
+			entry.version_++;
+			entry.state_ = state;
+		}
+		entry.checked_ = motion_epoch_;
+	}
+
+	return entry.version_;
+}
+
+unsigned int Storyboard::InputVersion(ConditionEntry &condition)
+{
+	unsigned int version = 0;
+
+	for (int i = condition.input_.first_; i < condition.input_.last_; i++)
+	{
+		version += ObjectVersion(input_object_[i]);
+	}
+
+	return version;
+}
+
+bool Storyboard::EvaluateCondition(int idx, Story *story, double sim_time)
+{
+	ConditionEntry &entry = condition_[idx];
+
+	if (entry.sleeping_ && !polling_)
+	{
+		if (entry.wake_cause_ != OSCCondition::WAKE_BY_ENTITIES || InputVersion(entry) == entry.input_version_)
+		{
+			// Evaluation would not trig nor change anything
+			return false;
+		}
+		entry.sleeping_ = false;
+	}
+
+	bool result = entry.condition_->Evaluate(story, sim_time);
+
+	// Schedule next evaluation
+	entry.wake_cause_ = entry.condition_->GetWakeCause(sim_time, entry.wake_time_);
+
+	if (entry.wake_cause_ == OSCCondition::WAKE_ALWAYS)
+	{
+		entry.sleeping_ = false;
+	}
+	else if (entry.wake_cause_ == OSCCondition::WAKE_BY_TIME)
+	{
+		if (entry.wake_time_ > sim_time)
+		{
+			entry.sleeping_ = true;
+			wake_queue_.push(TimedWakeup(entry.wake_time_, idx));
+		}
+		else
+		{
+			entry.sleeping_ = false;
+		}
+	}
+	else if (entry.wake_cause_ == OSCCondition::WAKE_BY_ENTITIES)
+	{
+		entry.sleeping_ = true;
+		entry.input_version_ = InputVersion(entry);
+	}
+	else
+	{
+		// WAKE_BY_STATE or WAKE_NEVER
+		entry.sleeping_ = true;
+	}
+
+	return result;
+}
+
+void Storyboard::Wake(std::vector<int> &waiter)
+{
+	for (size_t i = 0; i < waiter.size(); i++)
+	{
+		if (condition_[waiter[i]].wake_cause_ == OSCCondition::WAKE_BY_STATE)
+		{
+			condition_[waiter[i]].sleeping_ = false;
+		}
+	}
+}
+
+void Storyboard::WakeEvent(int idx)
+{
+	// Event trig and stop affects its actions as well
+	Wake(event_[idx].waiter_);
+	for (int i = event_[idx].action_.first_; i < event_[idx].action_.last_; i++)
+	{
+		Wake(action_[i].waiter_);
+	}
+}
+
+void Storyboard::ResetDeactivated(ActEntry &act)
+{
+	// Elements of an act only change state while the act is active, so this is only needed 
+	// the step after an active one
+	for (int i = act.maneuver_.first_; i < act.maneuver_.last_; i++)
+	{
+		for (int j = maneuver_[i].event_.first_; j < maneuver_[i].event_.last_; j++)
+		{
+			EventEntry &event = event_[j];
+
+			for (int k = event.action_.first_; k < event.action_.last_; k++)
+			{
+				if (action_[k].action_->state_ == OSCAction::State::DEACTIVATED)
+				{
+					action_[k].action_->state_ = OSCAction::State::INACTIVE;
+					Wake(action_[k].waiter_);
+				}
+			}
+			if (event.event_->state_ == Event::State::DEACTIVATED)
+			{
+				event.event_->state_ = Event::State::INACTIVE;
+				Wake(event.waiter_);
+			}
+		}
+	}
+	if (act.act_->state_ == Act::State::DEACTIVATED)
+	{
+		act.act_->state_ = Act::State::INACTIVE;
+		Wake(act.waiter_);
+	}
+	act.touched_ = false;
+}
+
+void Storyboard::StepManeuver(ManeuverEntry &maneuver_entry, Story *story, double dt, double sim_time)
+{
+	OSCManeuver *maneuver = maneuver_entry.maneuver_;
+
+	// Events - may only execute one at a time
+	for (int i = maneuver_entry.event_.first_; i < maneuver_entry.event_.last_; i++)
+	{
+		Event *event = event_[i].event_;
+
+		if (event->IsActive())
+		{
+			// If just activated, make transition to active
+			if (event->state_ == Event::State::ACTIVATED)
+			{
+				event->state_ = Event::State::ACTIVE;
+				Wake(event_[i].waiter_);
+			}
+		}
+		else if (event->state_ == Event::State::DEACTIVATED)
+		{
+			// If just deactivated, make transition to inactive
+			event->state_ = Event::State::INACTIVE;
+			Wake(event_[i].waiter_);
+		}
+	}
+	if (maneuver->GetActiveEventIdx() == -1 && maneuver->GetWaitingEventIdx() >= 0)
+	{
+		// When no active event, it's OK to trig waiting event
+		int waiting_idx = maneuver->GetWaitingEventIdx();
+		maneuver->event_[waiting_idx]->Trig();
+		WakeEvent(maneuver_entry.event_.first_ + waiting_idx);
+		motion_epoch_++;
+	}
+
+	for (int i = maneuver_entry.event_.first_; i < maneuver_entry.event_.last_; i++)
+	{
+		EventEntry &event_entry = event_[i];
+		Event *event = event_entry.event_;
+
+		if (event->Triggable())
+		{
+			// Check event conditions
+			for (int j = event_entry.start_condition_.first_; j < event_entry.start_condition_.last_; j++)
+			{
+				if (EvaluateCondition(j, story, sim_time))
+				{
+					// Check priority
+					if (event->priority_ == Event::Priority::OVERWRITE)
+					{
+						// Deactivate any currently active event
+						if (maneuver->GetActiveEventIdx() >= 0)
+						{
+							int active_idx = maneuver->GetActiveEventIdx();
+							LOG("Event %s cancelled", maneuver->event_[active_idx]->name_.c_str());
+							maneuver->event_[active_idx]->Stop();
+							WakeEvent(maneuver_entry.event_.first_ + active_idx);
+						}
+
+						// Activate trigged event
+						event->Trig();
+						WakeEvent(i);
+						motion_epoch_++;
+					}
+					else if (event->priority_ == Event::Priority::FOLLOWING)
+					{
+						// If already an active event, this event will wait
+						if (maneuver->GetActiveEventIdx() >= 0)
+						{
+							event->state_ = Event::State::WAITING;
+							Wake(event_entry.waiter_);
+							LOG("Event %s is running, trigged event %s is waiting",
+								maneuver->event_[maneuver->GetActiveEventIdx()]->name_.c_str(), event->name_.c_str());
+						}
+						else
+						{
+							event->Trig();
+							WakeEvent(i);
+							motion_epoch_++;
+						}
+					}
+					else if (event->priority_ == Event::Priority::SKIP)
+					{
+						if (maneuver->GetActiveEventIdx() >= 0)
+						{
+							LOG("Event %s is running, skipping trigged %s",
+								maneuver->event_[maneuver->GetActiveEventIdx()]->name_.c_str(), event->name_.c_str());
+						}
+						else
+						{
+							event->Trig();
+							WakeEvent(i);
+							motion_epoch_++;
+						}
+					}
+					else
+					{
+						LOG("Unknown event priority: %d", event->priority_);
+					}
+				}
+			}
+		}
+
+		// Update (step) all active actions, for all objects connected to the action
+		if (event->IsActive())
+		{
+			bool active = false;
+
+			for (int j = event_entry.action_.first_; j < event_entry.action_.last_; j++)
+			{
+				OSCAction *action = action_[j].action_;
+
+				if (action->state_ == OSCAction::State::TRIGGED)
+				{
+					action->state_ = OSCAction::State::ACTIVATED;
+					Wake(action_[j].waiter_);
+				}
+				else if (action->state_ == OSCAction::State::ACTIVATED)
+				{
+					action->state_ = OSCAction::State::ACTIVE;
+					Wake(action_[j].waiter_);
+				}
+
+				if (action->IsActive())
+				{
+					action->Step(dt);
+					active = active || action->IsActive();
+
+					// Action may have moved objects and changed its state
+					motion_epoch_++;
+					Wake(action_[j].waiter_);
+				}
+			}
+			if (!active)
+			{
+				// Actions done -> Set event done
+				event->Stop();
+				Wake(event_entry.waiter_);
+			}
+		}
+	}
+}
+
+void Storyboard::Step(double dt, double sim_time)
+{
+	// Objects may have moved since last step
+	motion_epoch_++;
+
+	if (sim_time < sim_time_)
+	{
+		// Time went backwards, scheduled times are not valid anymore
+		for (size_t i = 0; i < condition_.size(); i++)
+		{
+			condition_[i].sleeping_ = false;
+		}
+		wake_queue_ = std::priority_queue<TimedWakeup, std::vector<TimedWakeup>, std::greater<TimedWakeup> >();
+	}
+	sim_time_ = sim_time;
+
+	// Wake conditions waiting for current time
+	while (!wake_queue_.empty() && wake_queue_.top().first <= sim_time)
+	{
+		ConditionEntry &entry = condition_[wake_queue_.top().second];
+
+		// Skip outdated entries, condition might have been evaluated and rescheduled since
+		if (entry.wake_cause_ == OSCCondition::WAKE_BY_TIME && entry.wake_time_ == wake_queue_.top().first)
+		{
+			entry.sleeping_ = false;
+		}
+		wake_queue_.pop();
+	}
+
+	for (size_t i = 0; i < act_.size(); i++)
+	{
+		ActEntry &entry = act_[i];
+		Act *act = entry.act_;
+
+		// Update deactivated elements' state to inactive
+		if (entry.touched_)
+		{
+			ResetDeactivated(entry);
+		}
+
+		// Check Act conditions
+		if (!act->IsActive())
+		{
+			// Check start conditions
+			for (int j = entry.start_condition_.first_; j < entry.start_condition_.last_; j++)
+			{
+				if (EvaluateCondition(j, entry.story_, sim_time))
+				{
+					act->Trig();
+					Wake(entry.waiter_);
+				}
+			}
+		}
+		else
+		{
+			// If activated last step, make transition to activated
+			if (act->state_ == Act::State::ACTIVATED)
+			{
+				act->state_ = Act::State::ACTIVE;
+				Wake(entry.waiter_);
+			}
+		}
+
+		if (!act->IsActive())
+		{
+			// Nothing of the act will change this step
+			continue;
+		}
+
+		entry.touched_ = true;
+
+		// Check end conditions
+		for (int j = entry.end_condition_.first_; j < entry.end_condition_.last_; j++)
+		{
+			if (EvaluateCondition(j, entry.story_, sim_time))
+			{
+				act->Stop();
+				Wake(entry.waiter_);
+			}
+		}
+
+		// Check cancel conditions
+		for (int j = entry.cancel_condition_.first_; j < entry.cancel_condition_.last_; j++)
+		{
+			if (EvaluateCondition(j, entry.story_, sim_time))
+			{
+				act->Stop();
+				Wake(entry.waiter_);
+			}
+		}
+
+		// Maneuvers
+		if (act->IsActive())
+		{
+			for (int j = entry.maneuver_.first_; j < entry.maneuver_.last_; j++)
+			{
+				StepManeuver(maneuver_[j], entry.story_, dt, sim_time);
+			}
+		}
+	}
+}
+
+double Storyboard::PredictConditions(Range &range, double sim_time)
+{
+	double t = INFINITY;
+
+	for (int i = range.first_; i < range.last_ && t > sim_time; i++)
+	{
+		ConditionEntry &entry = condition_[i];
+
+		if (!entry.sleeping_)
+		{
+			// Will be evaluated next step
+			t = sim_time;
+		}
+		else if (entry.wake_cause_ == OSCCondition::WAKE_BY_TIME)
+		{
+			t = fmin(t, entry.wake_time_);
+		}
+		else if (entry.wake_cause_ == OSCCondition::WAKE_BY_ENTITIES)
+		{
+			t = fmin(t, entry.condition_->PredictInputChange(sim_time));
+		}
+		// else waiting for a state change, which is itself predicted, or never changing
+	}
+
+	return t;
+}
+
+double Storyboard::PredictNextEvent(double sim_time)
+{
+	double t = INFINITY;
+
+	// Visit the same conditions as Step() would, while looking for any ongoing transitions
+	for (size_t i = 0; i < act_.size() && t > sim_time; i++)
+	{
+		ActEntry &entry = act_[i];
+		Act *act = entry.act_;
+
+		if (!act->IsActive())
+		{
+			if (entry.touched_)
+			{
+				// Just deactivated elements remain to reset
+				return sim_time;
+			}
+			t = fmin(t, PredictConditions(entry.start_condition_, sim_time));
+			continue;
+		}
+
+		if (act->state_ != Act::State::ACTIVE)
+		{
+			return sim_time;
+		}
+
+		t = fmin(t, PredictConditions(entry.end_condition_, sim_time));
+		t = fmin(t, PredictConditions(entry.cancel_condition_, sim_time));
+
+		for (int j = entry.maneuver_.first_; j < entry.maneuver_.last_; j++)
+		{
+			bool active_event = false;
+			bool waiting_event = false;
+
+			for (int k = maneuver_[j].event_.first_; k < maneuver_[j].event_.last_; k++)
+			{
+				EventEntry &event_entry = event_[k];
+				Event *event = event_entry.event_;
+
+				if (event->state_ == Event::State::ACTIVATED || event->state_ == Event::State::DEACTIVATED)
+				{
+					return sim_time;
+				}
+				else if (event->state_ == Event::State::WAITING)
+				{
+					waiting_event = true;
+				}
+				else if (event->state_ == Event::State::ACTIVE)
+				{
+					bool active_action = false;
+
+					active_event = true;
+					for (int l = event_entry.action_.first_; l < event_entry.action_.last_; l++)
+					{
+						OSCAction *action = action_[l].action_;
+
+						if (action->state_ == OSCAction::State::ACTIVE && action->IsSteady())
+						{
+							active_action = true;
+						}
+						else if (action->state_ != OSCAction::State::INACTIVE)
+						{
+							// Changing speed, position or state
+							return sim_time;
+						}
+					}
+					if (!active_action)
+					{
+						// Event will be stopped
+						return sim_time;
+					}
+				}
+
+				if (event->Triggable())
+				{
+					t = fmin(t, PredictConditions(event_entry.start_condition_, sim_time));
+				}
+			}
+
+			if (waiting_event && !active_event)
+			{
+				return sim_time;
+			}
+		}
+	}
+
+	return t;
+}
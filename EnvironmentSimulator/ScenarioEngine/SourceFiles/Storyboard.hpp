@@ -0,0 +1,175 @@
+/* 
+ * esmini - Environment Simulator Minimalistic 
+ * https://github.com/esmini/esmini
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * 
+ * Copyright (c) partners of Simulation Scenarios
+ * https://sites.google.com/view/simulationscenarios
+ */
+
+#pragma once
+
+#include "Story.hpp"
+
+#include <vector>
+#include <queue>
+
+namespace scenarioengine
+{
+
+	/**
+	Flat representation of the parsed storyboard. Acts, maneuvers, events, actions and conditions
+	are stored in contiguous arrays, linked by index ranges, so that a step only visits the start
+	conditions of inactive acts and the maneuvers of active ones, instead of walking the full
+	Story - Act - ActSequence - Maneuver - Event - Action tree.
+	The story elements are still owned by the stories, this class only refers to them.
+
+	Conditions are scheduled by their inputs rather than evaluated every step. After an evaluation
+	a condition is put to sleep until something happens that could make it trig or change its state:
+	Simulation time reaching a value (time ordered queue), a state change of the referred story
+	element or movement of any input object. Sleeping conditions are considered false.
+	*/
+	class Storyboard
+	{
+	public:
+		Storyboard() : motion_epoch_(0), sim_time_(0), polling_(false) {}
+
+		/**
+		Build the flat arrays from parsed stories. Must be called again if stories are changed.
+		@param story The stories of the scenario
+		*/
+		void Compile(std::vector<Story*> &story);
+
+		/**
+		Evaluate conditions, update element states and step active actions
+		@param dt Step size (s)
+		@param sim_time Current simulation time (s)
+		*/
+		void Step(double dt, double sim_time);
+
+		/**
+		Conservative estimate of the earliest simulation time at which any condition could trig or any
+		story element could change state. Assumes that objects keep their speed, which holds as long as
+		all active actions are steady, see OSCAction::IsSteady(). Used for adaptive step size.
+		@param sim_time Current simulation time (s)
+		@return Predicted simulation time (s), sim_time if something is already going on
+		*/
+		double PredictNextEvent(double sim_time);
+
+		/**
+		Evaluate all conditions every step, as if none of them were sleeping. The result is the same
+		as by scheduled evaluation, only slower. For reference and debugging.
+		@param polling True to evaluate every step, false for scheduled evaluation (default)
+		*/
+		void SetPolling(bool polling) { polling_ = polling; }
+
+		int GetNumberOfActs() { return (int)act_.size(); }
+		int GetNumberOfEvents() { return (int)event_.size(); }
+
+	private:
+		typedef struct
+		{
+			int first_;
+			int last_;  // One past last index
+		} Range;
+
+		typedef struct
+		{
+			Act *act_;
+			Story *story_;
+			Range start_condition_;
+			Range end_condition_;
+			Range cancel_condition_;
+			Range maneuver_;
+			bool touched_;  // Act was active last step, may hold just deactivated elements
+			std::vector<int> waiter_;  // Conditions referring to the act
+		} ActEntry;
+
+		typedef struct
+		{
+			OSCManeuver *maneuver_;
+			Range event_;
+		} ManeuverEntry;
+
+		typedef struct
+		{
+			Event *event_;
+			Range start_condition_;
+			Range action_;
+			std::vector<int> waiter_;  // Conditions referring to the event
+		} EventEntry;
+
+		typedef struct
+		{
+			OSCAction *action_;
+			std::vector<int> waiter_;  // Conditions referring to the action
+		} ActionEntry;
+
+		typedef struct
+		{
+			OSCCondition *condition_;
+			OSCCondition::WakeCause wake_cause_;
+			double wake_time_;
+			bool sleeping_;
+			Range input_;  // Index range in input_object_
+			unsigned int input_version_;  // Sum of input object versions at latest evaluation
+		} ConditionEntry;
+
+		typedef struct
+		{
+			double x_;
+			double y_;
+			double h_;
+			double s_;
+			double t_;
+			int lane_id_;
+			double speed_;
+			double prev_x_;  // start of motion segment, see Object::NextMotionSegment()
+			double prev_y_;
+			double prev_h_;
+		} MotionState;
+
+		typedef struct
+		{
+			Object *object_;
+			unsigned int version_;  // Increased whenever the object is found moved
+			unsigned int checked_;  // Motion epoch of latest check
+			MotionState state_;  // As of latest check
+		} ObjectEntry;
+
+		typedef std::pair<double, int> TimedWakeup;  // Simulation time, condition index
+
+		std::vector<ActEntry> act_;
+		std::vector<ManeuverEntry> maneuver_;
+		std::vector<EventEntry> event_;
+		std::vector<ActionEntry> action_;
+		std::vector<ConditionEntry> condition_;
+		std::vector<ObjectEntry> object_;
+		std::vector<int> input_object_;  // Object indices
+		std::priority_queue<TimedWakeup, std::vector<TimedWakeup>, std::greater<TimedWakeup> > wake_queue_;
+		unsigned int motion_epoch_;  // Increased whenever objects might have moved
+		double sim_time_;  // Time of latest step
+		bool polling_;
+
+		Range AddConditions(std::vector<OSCConditionGroup*> &group);
+		void ResolveInputs(int condition_idx, Story *story);
+		void ResetDeactivated(ActEntry &act);
+		void StepManeuver(ManeuverEntry &maneuver, Story *story, double dt, double sim_time);
+
+		/**
+		Evaluate a condition, unless sleeping, then schedule next evaluation
+		@return The result of the evaluation, false if sleeping
+		*/
+		bool EvaluateCondition(int idx, Story *story, double sim_time);
+		double PredictConditions(Range &range, double sim_time);
+		void Wake(std::vector<int> &waiter);
+		void WakeEvent(int idx);
+		static void GetMotionState(Object *object, MotionState &state);
+		unsigned int ObjectVersion(int idx);
+		unsigned int InputVersion(ConditionEntry &condition);
+	};
+
+}
@@ -52,6 +52,8 @@ static roadmanager::OpenDrive *roadManager = 0;
 double simTime = 0;
 double deltaSimTime = 0;  // external - used by Viewer::RubberBandCamera
 static char *args[] = { "kalle", "--window", "50", "50", "1000", "500" };
+static bool random_seed_set = false;
+static unsigned int random_seed = 0;
 
 #ifdef _SCENARIO_VIEWER
 
@@ -221,6 +223,11 @@ extern "C"
 			// Fetch ScenarioGateway 
 			scenarioGateway = scenarioEngine->getScenarioGateway();
 
+			if (random_seed_set)
+			{
+				scenarioEngine->SetRandomSeed(random_seed);
+			}
+
 			// Create a data file for later replay?
 			if (record)
 			{
@@ -257,6 +264,27 @@ extern "C"
 		return 0;
 	}
 
+	SE_DLL_API void SE_SetSeed(unsigned int seed)
+	{
+		random_seed_set = true;
+		random_seed = seed;
+
+		if (scenarioEngine)
+		{
+			scenarioEngine->SetRandomSeed(seed);
+		}
+	}
+
+	SE_DLL_API unsigned int SE_GetSeed()
+	{
+		if (scenarioEngine)
+		{
+			return scenarioEngine->GetRandomSeed();
+		}
+
+		return random_seed;
+	}
+
 	SE_DLL_API void SE_Close()
 	{
 		resetScenario();
@@ -298,7 +326,7 @@ extern "C"
 	{
 		if (scenarioGateway != 0)
 		{
-			scenarioGateway->reportObject(ObjectState(id, std::string(name), model_id, ext_control, timestamp, x, y, z, h, p, r, speed));
+			scenarioGateway->reportObject(id, std::string(name), model_id, ext_control, timestamp, x, y, z, h, p, r, speed);
 		}
 
 		return 0;
@@ -308,7 +336,7 @@ extern "C"
 	{
 		if (scenarioGateway != 0)
 		{
-			scenarioGateway->reportObject(ObjectState(id, std::string(name), model_id, ext_control, timestamp, roadId, laneId, laneOffset, s, speed));
+			scenarioGateway->reportObject(id, std::string(name), model_id, ext_control, timestamp, roadId, laneId, laneOffset, s, speed);
 		}
 
 		return 0;
@@ -58,6 +58,19 @@ extern "C"
 	SE_DLL_API int SE_Step(float dt);
 	SE_DLL_API void SE_Close();
 
+	/**
+	Seed random choices of the scenario, e.g. at junctions. Applies to the running scenario and to 
+	following SE_Init calls, overriding any seed given by the scenario. Same seed reproduces a run.
+	@param seed Seed value
+	*/
+	SE_DLL_API void SE_SetSeed(unsigned int seed);
+
+	/**
+	Get the seed of random choices of the scenario, e.g. to reproduce a run seeded by time
+	@return The seed
+	*/
+	SE_DLL_API unsigned int SE_GetSeed();
+
 	SE_DLL_API int SE_ReportObjectPos(int id, char *name, int model_id, int ext_control, float timestamp, float x, float y, float z, float h, float p, float r, float speed);
 	SE_DLL_API int SE_ReportObjectRoadPos(int id, char *name, int model_id, int ext_control, float timestamp, int roadId, int laneId, float laneOffset, float s, float speed);
 
@@ -0,0 +1,1132 @@
+/*
+ * esmini - Environment Simulator Minimalistic
+ * https://github.com/esmini/esmini
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) partners of Simulation Scenarios
+ * https://sites.google.com/view/simulationscenarios
+ */
+
+#include <random>
+#include <limits>
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <set>
+#include <gtest/gtest.h>
+#include "RoadManager.hpp"
+#include "odrSpiral.h"
+#include "CommonMini.hpp"
+
+using namespace roadmanager;
+
+static const char *odr_files[] =
+{
+	RESOURCES_DIR "/xodr/e6mini.xodr",
+	RESOURCES_DIR "/xodr/fabriksgatan.xodr",
+	RESOURCES_DIR "/xodr/jolengatan.xodr",
+	RESOURCES_DIR "/xodr/soderleden.xodr",
+	RESOURCES_DIR "/xodr/straight_500m.xodr",
+};
+
+// Gives access to the distance measure of the world to road projection
+class ProbePosition : public Position
+{
+public:
+	ProbePosition(OpenDrive *od) : Position(od) {}
+	using Position::GetDistToTrackGeom;
+};
+
+// Closest road and s by visiting every geometry, applying same tie rule as XYH2TrackPos()
+static void BruteForceClosest(OpenDrive *od, double x, double y, double h, int &road_id, double &s)
+{
+	ProbePosition probe(od);
+	double dist_min = std::numeric_limits<double>::infinity();
+
+	for (int i = 0; i < od->GetNumOfRoads(); i++)
+	{
+		Road *road = od->GetRoadByIdx(i);
+		for (int j = 0; j < road->GetNumberOfGeometries(); j++)
+		{
+			Geometry *geom = road->GetGeometry(j);
+			bool inside;
+			double s_norm;
+			double dist = probe.GetDistToTrackGeom(x, y, h, road, geom, inside, s_norm);
+			if (dist < dist_min)
+			{
+				dist_min = dist;
+				road_id = road->GetId();
+				s = geom->GetS() + std::min(std::max(s_norm, 0.0), 1.0) * geom->GetLength();
+			}
+		}
+	}
+}
+
+class SpatialIndexTest : public ::testing::TestWithParam<double> {};
+
+TEST_P(SpatialIndexTest, ProjectionMatchesBruteForce)
+{
+	for (const char *filename : odr_files)
+	{
+		OpenDrive od;
+		ASSERT_TRUE(od.LoadOpenDriveFile(filename)) << filename;
+		od.SetClosestPointTolerance(GetParam());
+
+		std::mt19937 gen(1234);
+		std::uniform_real_distribution<double> unit(0.0, 1.0);
+		Position pos(&od);
+
+		for (int i = 0; i < 2000; i++)
+		{
+			// Random point around a random road, within and beyond the lanes
+			Road *road = od.GetRoadByIdx((int)(unit(gen) * od.GetNumOfRoads()) % od.GetNumOfRoads());
+			Position target(&od);
+			target.SetTrackPos(road->GetId(), unit(gen) * road->GetLength(), (unit(gen) - 0.5) * 60);
+			double x = target.GetX();
+			double y = target.GetY();
+			double h = unit(gen) * 2 * M_PI;
+
+			// Start from another random road, so that the neighbourhood of the current position is no help
+			Road *start_road = od.GetRoadByIdx((int)(unit(gen) * od.GetNumOfRoads()) % od.GetNumOfRoads());
+			pos.SetTrackPos(start_road->GetId(), 0, 0);
+			pos.XYH2TrackPos(x, y, h);
+
+			int road_id = -1;
+			double s = 0;
+			BruteForceClosest(&od, x, y, h, road_id, s);
+
+			ASSERT_EQ(pos.GetTrackId(), road_id) << filename << " point " << i << " (" << x << ", " << y << ")";
+			ASSERT_NEAR(pos.GetS(), s, 1e-6) << filename << " point " << i << " (" << x << ", " << y << ")";
+		}
+	}
+}
+
+// Exact closest point and chord approximation
+INSTANTIATE_TEST_CASE_P(ClosestPointTolerance, SpatialIndexTest, ::testing::Values(CLOSEST_POINT_TOLERANCE, 0.0));
+
+static void ExpectEqualPositions(Position &pos1, Position &pos2, const char *filename, int step)
+{
+	ASSERT_EQ(pos1.GetTrackId(), pos2.GetTrackId()) << filename << " step " << step;
+	ASSERT_EQ(pos1.GetLaneId(), pos2.GetLaneId()) << filename << " step " << step;
+	ASSERT_NEAR(pos1.GetS(), pos2.GetS(), 1e-9) << filename << " step " << step;
+	ASSERT_NEAR(pos1.GetT(), pos2.GetT(), 1e-9) << filename << " step " << step;
+	ASSERT_NEAR(pos1.GetX(), pos2.GetX(), 1e-9) << filename << " step " << step;
+	ASSERT_NEAR(pos1.GetY(), pos2.GetY(), 1e-9) << filename << " step " << step;
+	ASSERT_NEAR(pos1.GetH(), pos2.GetH(), 1e-9) << filename << " step " << step;
+}
+
+// Same sequence of operations on two positions, one of them evaluated after each operation
+TEST(LazyEvaluationTest, LazyEqualsEager)
+{
+	for (const char *filename : odr_files)
+	{
+		OpenDrive od;
+		ASSERT_TRUE(od.LoadOpenDriveFile(filename)) << filename;
+
+		std::mt19937 gen(4321);
+		std::uniform_real_distribution<double> unit(0.0, 1.0);
+		Position lazy(&od);
+		Position eager(&od);
+		lazy.SetRandomSeed(1);
+		eager.SetRandomSeed(1);
+
+		for (int i = 0; i < 3000; i++)
+		{
+			Road *road = od.GetRoadByIdx((int)(unit(gen) * od.GetNumOfRoads()) % od.GetNumOfRoads());
+			double s = unit(gen) * road->GetLength();
+			int op = (int)(unit(gen) * 3);
+
+			if (op == 0)
+			{
+				LaneSection *lane_section = road->GetLaneSectionByS(s);
+				int lane_id = lane_section->GetLaneIdByIdx((int)(unit(gen) * lane_section->GetNumberOfLanes()) % lane_section->GetNumberOfLanes());
+				double offset = unit(gen) - 0.5;
+				lazy.SetLanePos(road->GetId(), lane_id, s, offset);
+				eager.SetLanePos(road->GetId(), lane_id, s, offset);
+			}
+			else if (op == 1)
+			{
+				Position target(&od);
+				target.SetTrackPos(road->GetId(), s, (unit(gen) - 0.5) * 20);
+				double h = unit(gen) * 2 * M_PI;
+				lazy.SetInertiaPos(target.GetX(), target.GetY(), 0, h, 0, 0);
+				eager.SetInertiaPos(target.GetX(), target.GetY(), 0, h, 0, 0);
+			}
+			else
+			{
+				double ds = (unit(gen) - 0.5) * 40;
+				lazy.MoveAlongS(ds);
+				eager.MoveAlongS(ds);
+			}
+			eager.Evaluate();
+
+			// Compare now and then, leaving the lazy one unevaluated between operations in between
+			if (unit(gen) < 0.25)
+			{
+				ExpectEqualPositions(lazy, eager, filename, i);
+			}
+		}
+		ExpectEqualPositions(lazy, eager, filename, -1);
+	}
+}
+
+// Sample lane positions along all roads, exact equality expected since the cache holds the parsed values
+static void ExpectEqualNetworks(OpenDrive &od1, OpenDrive &od2, const char *filename)
+{
+	ASSERT_EQ(od1.GetNumOfRoads(), od2.GetNumOfRoads()) << filename;
+	ASSERT_EQ(od1.GetNumOfJunctions(), od2.GetNumOfJunctions()) << filename;
+	ASSERT_EQ(od1.GetSpatialIndex()->GetNumberOfEntries(), od2.GetSpatialIndex()->GetNumberOfEntries()) << filename;
+	ASSERT_EQ(od1.GetLaneGraph()->GetNumberOfNodes(), od2.GetLaneGraph()->GetNumberOfNodes()) << filename;
+
+	for (int i = 0; i < od1.GetNumOfRoads(); i++)
+	{
+		Road *road1 = od1.GetRoadByIdx(i);
+		Road *road2 = od2.GetRoadByIdx(i);
+		ASSERT_EQ(road1->GetId(), road2->GetId()) << filename;
+		ASSERT_EQ(road1->GetLength(), road2->GetLength()) << filename << " road " << road1->GetId();
+		ASSERT_EQ(road1->GetNumberOfGeometries(), road2->GetNumberOfGeometries()) << filename << " road " << road1->GetId();
+		ASSERT_EQ(road1->GetNumberOfLaneSections(), road2->GetNumberOfLaneSections()) << filename << " road " << road1->GetId();
+		ASSERT_EQ(road1->GetMaxCurvature(), road2->GetMaxCurvature()) << filename << " road " << road1->GetId();
+
+		Position pos1(&od1);
+		Position pos2(&od2);
+		for (double s = 0; s < road1->GetLength(); s += 2.0)
+		{
+			LaneSection *lane_section = road1->GetLaneSectionByS(s);
+			ASSERT_EQ(lane_section->GetNumberOfLanes(), road2->GetLaneSectionByS(s)->GetNumberOfLanes()) << filename;
+			for (int j = 0; j < lane_section->GetNumberOfLanes(); j++)
+			{
+				int lane_id = lane_section->GetLaneIdByIdx(j);
+				pos1.SetLanePos(road1->GetId(), lane_id, s, 0.2);
+				pos2.SetLanePos(road2->GetId(), lane_id, s, 0.2);
+				ASSERT_EQ(pos1.GetX(), pos2.GetX()) << filename << " road " << road1->GetId() << " lane " << lane_id << " s " << s;
+				ASSERT_EQ(pos1.GetY(), pos2.GetY()) << filename << " road " << road1->GetId() << " lane " << lane_id << " s " << s;
+				ASSERT_EQ(pos1.GetZ(), pos2.GetZ()) << filename << " road " << road1->GetId() << " lane " << lane_id << " s " << s;
+				ASSERT_EQ(pos1.GetH(), pos2.GetH()) << filename << " road " << road1->GetId() << " lane " << lane_id << " s " << s;
+			}
+		}
+	}
+
+	for (int i = 0; i < od1.GetNumOfJunctions(); i++)
+	{
+		Junction *junction1 = od1.GetJunctionByIdx(i);
+		Junction *junction2 = od2.GetJunctionByIdx(i);
+		ASSERT_EQ(junction1->GetId(), junction2->GetId()) << filename;
+		ASSERT_EQ(junction1->GetNumberOfConnections(), junction2->GetNumberOfConnections()) << filename;
+		for (int j = 0; j < junction1->GetNumberOfConnections(); j++)
+		{
+			Connection *connection1 = junction1->GetConnectionByIdx(j);
+			Connection *connection2 = junction2->GetConnectionByIdx(j);
+			ASSERT_EQ(connection1->GetIncomingRoad()->GetId(), connection2->GetIncomingRoad()->GetId()) << filename;
+			ASSERT_EQ(connection1->GetConnectingRoad()->GetId(), connection2->GetConnectingRoad()->GetId()) << filename;
+			ASSERT_EQ(connection1->GetNumberOfLaneLinks(), connection2->GetNumberOfLaneLinks()) << filename;
+		}
+	}
+}
+
+// Road network read from the compiled cache equals the one parsed from XML
+TEST(CacheTest, CacheEqualsXML)
+{
+	for (const char *filename : odr_files)
+	{
+		std::string cache_filename = std::string(".") + strrchr(filename, '/') + ".cache";
+		std::remove(cache_filename.c_str());
+
+		// First load parses the XML and writes the cache, second one reads it
+		OpenDrive od_write;
+		od_write.SetCacheDir(".");
+		ASSERT_TRUE(od_write.LoadOpenDriveFile(filename)) << filename;
+
+		FILE *file = fopen(cache_filename.c_str(), "rb");
+		ASSERT_TRUE(file != 0) << cache_filename;
+		fclose(file);
+
+		OpenDrive od_read;
+		od_read.SetCacheDir(".");
+		ASSERT_TRUE(od_read.LoadOpenDriveFile(filename)) << filename;
+
+		OpenDrive od_xml;
+		ASSERT_TRUE(od_xml.LoadOpenDriveFile(filename)) << filename;
+
+		ExpectEqualNetworks(od_xml, od_read, filename);
+		std::remove(cache_filename.c_str());
+	}
+}
+
+// Roads built by several loader threads equal the ones built by a single thread
+TEST(LoaderThreadsTest, ParallelEqualsSerial)
+{
+	for (const char *filename : odr_files)
+	{
+		OpenDrive od_serial;
+		ASSERT_TRUE(od_serial.LoadOpenDriveFile(filename)) << filename;
+
+		OpenDrive od_parallel;
+		od_parallel.SetLoaderThreads(4);
+		ASSERT_TRUE(od_parallel.LoadOpenDriveFile(filename)) << filename;
+
+		ExpectEqualNetworks(od_serial, od_parallel, filename);
+	}
+}
+
+// Shortest path cost from a node to all others, by plain Dijkstra search
+static std::vector<double> DijkstraCost(LaneGraph *graph, int from)
+{
+	std::vector<double> cost(graph->GetNumberOfNodes(), std::numeric_limits<double>::infinity());
+	std::vector<bool> done(graph->GetNumberOfNodes(), false);
+	cost[from] = 0;
+
+	for (int k = 0; k < graph->GetNumberOfNodes(); k++)
+	{
+		int n = -1;
+		for (int i = 0; i < graph->GetNumberOfNodes(); i++)
+		{
+			if (!done[i] && (n < 0 || cost[i] < cost[n]))
+			{
+				n = i;
+			}
+		}
+		if (cost[n] == std::numeric_limits<double>::infinity())
+		{
+			break;
+		}
+		done[n] = true;
+
+		for (int i = graph->GetNode(n)->first_edge_; i < graph->GetNode(n + 1)->first_edge_; i++)
+		{
+			LaneGraph::Edge *edge = graph->GetEdge(i);
+			cost[edge->to_] = std::min(cost[edge->to_], cost[n] + edge->cost_);
+		}
+	}
+
+	return cost;
+}
+
+// A* search finds the shortest path between all pairs of lanes of a junction network
+TEST(LaneGraphTest, ShortestPath)
+{
+	OpenDrive od;
+	ASSERT_TRUE(od.LoadOpenDriveFile(RESOURCES_DIR "/xodr/fabriksgatan.xodr"));
+	LaneGraph *graph = od.GetLaneGraph();
+	ASSERT_GT(graph->GetNumberOfNodes(), 0);
+	int n_connected = 0;
+
+	for (int from = 0; from < graph->GetNumberOfNodes(); from++)
+	{
+		std::vector<double> cost = DijkstraCost(graph, from);
+
+		for (int to = 0; to < graph->GetNumberOfNodes(); to++)
+		{
+			std::vector<int> path;
+			double length = graph->FindPath(from, to, path);
+
+			if (cost[to] == std::numeric_limits<double>::infinity())
+			{
+				ASSERT_EQ(length, -1) << from << " -> " << to;
+				continue;
+			}
+			n_connected++;
+			ASSERT_NEAR(length, cost[to], 1e-9) << from << " -> " << to;
+
+			// Path follows the edges of the graph, adding up to the length
+			ASSERT_EQ(path.front(), from);
+			ASSERT_EQ(path.back(), to);
+			double sum = 0;
+			for (size_t i = 1; i < path.size(); i++)
+			{
+				double edge_cost = -1;
+				for (int j = graph->GetNode(path[i - 1])->first_edge_; j < graph->GetNode(path[i - 1] + 1)->first_edge_; j++)
+				{
+					if (graph->GetEdge(j)->to_ == path[i])
+					{
+						edge_cost = edge_cost < 0 ? graph->GetEdge(j)->cost_ : std::min(edge_cost, graph->GetEdge(j)->cost_);
+					}
+				}
+				ASSERT_GE(edge_cost, 0) << from << " -> " << to << " step " << i;
+				sum += edge_cost;
+			}
+			ASSERT_NEAR(sum, length, 1e-9) << from << " -> " << to;
+		}
+	}
+	ASSERT_GT(n_connected, graph->GetNumberOfNodes());
+}
+
+// Roads linked directly, e.g. a junction connecting road and its incoming road
+static bool RoadsLinked(OpenDrive *od, int road1_id, int road2_id)
+{
+	Road *road[2] = { od->GetRoadById(road1_id), od->GetRoadById(road2_id) };
+
+	for (int i = 0; i < 2; i++)
+	{
+		for (LinkType link_type : { SUCCESSOR, PREDECESSOR })
+		{
+			RoadLink *link = road[i]->GetLink(link_type);
+			if (link && link->GetElementType() == RoadLink::ELEMENT_TYPE_ROAD && link->GetElementId() == road[1 - i]->GetId())
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+// Routes between lanes of a junction network consist of linked roads, one waypoint each
+TEST(LaneGraphTest, FindRoute)
+{
+	OpenDrive od;
+	ASSERT_TRUE(od.LoadOpenDriveFile(RESOURCES_DIR "/xodr/fabriksgatan.xodr"));
+	LaneGraph *graph = od.GetLaneGraph();
+	int n_found = 0;
+
+	for (int i = 0; i < graph->GetNumberOfNodes(); i++)
+	{
+		for (int j = 0; j < graph->GetNumberOfNodes(); j++)
+		{
+			LaneGraph::Node *node_from = graph->GetNode(i);
+			LaneGraph::Node *node_to = graph->GetNode(j);
+			Road *road_from = od.GetRoadByIdx(node_from->road_idx_);
+			Road *road_to = od.GetRoadByIdx(node_to->road_idx_);
+			LaneSection *ls_from = road_from->GetLaneSectionByIdx(node_from->lane_section_idx_);
+			LaneSection *ls_to = road_to->GetLaneSectionByIdx(node_to->lane_section_idx_);
+
+			// Mid of the lane sections
+			Position from(&od);
+			Position to(&od);
+			from.SetLanePos(road_from->GetId(), node_from->lane_id_, ls_from->GetS() + ls_from->GetLength() / 2, 0);
+			to.SetLanePos(road_to->GetId(), node_to->lane_id_, ls_to->GetS() + ls_to->GetLength() / 2, 0);
+
+			std::vector<int> path;
+			bool connected = i == j || graph->FindPath(i, j, path) >= 0;
+
+			Route route;
+			double length = od.FindRoute(&from, &to, &route);
+			if (!connected)
+			{
+				ASSERT_EQ(length, -1) << i << " -> " << j;
+				continue;
+			}
+			ASSERT_GE(length, 0) << i << " -> " << j;
+			n_found++;
+
+			ASSERT_GE(route.waypoint_.size(), 1u);
+			ASSERT_EQ(route.waypoint_.front()->GetTrackId(), from.GetTrackId());
+			ASSERT_EQ(route.waypoint_.back()->GetTrackId(), to.GetTrackId());
+			for (size_t k = 1; k < route.waypoint_.size(); k++)
+			{
+				ASSERT_TRUE(RoadsLinked(&od, route.waypoint_[k - 1]->GetTrackId(), route.waypoint_[k]->GetTrackId())) << i << " -> " << j;
+			}
+			for (size_t k = 0; k < route.waypoint_.size(); k++)
+			{
+				delete route.waypoint_[k];
+			}
+		}
+	}
+	ASSERT_GT(n_found, graph->GetNumberOfNodes());
+}
+
+// Connections from a lane of an incoming road, found by visiting all connections and lane links in order
+static std::vector<LaneRoadLaneConnection> WalkConnections(Junction *junction, int road_id, int lane_id)
+{
+	std::vector<LaneRoadLaneConnection> result;
+
+	for (int i = 0; i < junction->GetNumberOfConnections(); i++)
+	{
+		Connection *connection = junction->GetConnectionByIdx(i);
+		if (connection->GetIncomingRoad()->GetId() != road_id)
+		{
+			continue;
+		}
+		for (int j = 0; j < connection->GetNumberOfLaneLinks(); j++)
+		{
+			JunctionLaneLink *lane_link = connection->GetLaneLink(j);
+			if (lane_link->from_ == lane_id)
+			{
+				LaneRoadLaneConnection lane_connection(lane_id, connection->GetConnectingRoad()->GetId(), lane_link->to_);
+				lane_connection.contact_point_ = connection->GetContactPoint();
+				result.push_back(lane_connection);
+			}
+		}
+	}
+
+	return result;
+}
+
+// Connection table lists the same connections, in the same order, as visiting all connections
+TEST(JunctionTest, ConnectionTableEqualsWalk)
+{
+	for (const char *filename : odr_files)
+	{
+		OpenDrive od;
+		ASSERT_TRUE(od.LoadOpenDriveFile(filename)) << filename;
+
+		for (int i = 0; i < od.GetNumOfJunctions(); i++)
+		{
+			Junction *junction = od.GetJunctionByIdx(i);
+			int n_lane_links = 0;
+			int n_table = 0;
+			std::set<std::pair<int, int> > lanes;
+
+			for (int j = 0; j < junction->GetNumberOfConnections(); j++)
+			{
+				Connection *connection = junction->GetConnectionByIdx(j);
+				for (int k = 0; k < connection->GetNumberOfLaneLinks(); k++)
+				{
+					lanes.insert(std::make_pair(connection->GetIncomingRoad()->GetId(), connection->GetLaneLink(k)->from_));
+					n_lane_links++;
+				}
+			}
+
+			for (std::set<std::pair<int, int> >::iterator it = lanes.begin(); it != lanes.end(); it++)
+			{
+				std::vector<LaneRoadLaneConnection> walk = WalkConnections(junction, it->first, it->second);
+				int n_connections = 0;
+				LaneRoadLaneConnection *table = junction->GetRoadConnections(it->first, it->second, n_connections);
+
+				ASSERT_EQ(n_connections, (int)walk.size()) << filename << " junction " << junction->GetId();
+				ASSERT_EQ(junction->GetNumberOfRoadConnections(it->first, it->second), n_connections);
+				for (int k = 0; k < n_connections; k++)
+				{
+					LaneRoadLaneConnection by_idx = junction->GetRoadConnectionByIdx(it->first, it->second, k);
+					EXPECT_EQ(table[k].GetRoadId(), it->first);
+					EXPECT_EQ(table[k].GetLaneId(), it->second);
+					EXPECT_EQ(table[k].GetConnectingRoadId(), walk[k].GetConnectingRoadId()) << filename << " junction " << junction->GetId();
+					EXPECT_EQ(table[k].GetConnectinglaneId(), walk[k].GetConnectinglaneId()) << filename << " junction " << junction->GetId();
+					EXPECT_EQ(table[k].contact_point_, walk[k].contact_point_) << filename << " junction " << junction->GetId();
+					EXPECT_EQ(by_idx.GetConnectingRoadId(), table[k].GetConnectingRoadId());
+					EXPECT_EQ(by_idx.GetConnectinglaneId(), table[k].GetConnectinglaneId());
+				}
+				n_table += n_connections;
+			}
+			EXPECT_EQ(n_table, n_lane_links) << filename << " junction " << junction->GetId();
+			EXPECT_EQ(junction->GetNumberOfRoadConnections(-100, 1), 0);
+		}
+	}
+}
+
+// Turn types follow the heading change along the connecting road, and turns end up on their side
+TEST(JunctionTest, TurnClassification)
+{
+	int n_turn[3] = { 0, 0, 0 };
+
+	for (const char *filename : odr_files)
+	{
+		OpenDrive od;
+		ASSERT_TRUE(od.LoadOpenDriveFile(filename)) << filename;
+
+		for (int i = 0; i < od.GetNumOfJunctions(); i++)
+		{
+			Junction *junction = od.GetJunctionByIdx(i);
+			std::set<std::pair<int, int> > lanes;
+
+			for (int j = 0; j < junction->GetNumberOfConnections(); j++)
+			{
+				Connection *connection = junction->GetConnectionByIdx(j);
+				for (int k = 0; k < connection->GetNumberOfLaneLinks(); k++)
+				{
+					lanes.insert(std::make_pair(connection->GetIncomingRoad()->GetId(), connection->GetLaneLink(k)->from_));
+				}
+			}
+
+			for (std::set<std::pair<int, int> >::iterator it = lanes.begin(); it != lanes.end(); it++)
+			{
+				int n_connections = 0;
+				LaneRoadLaneConnection *table = junction->GetRoadConnections(it->first, it->second, n_connections);
+
+				for (int k = 0; k < n_connections; k++)
+				{
+					// Entry and exit of the reference line, in driving direction through the junction
+					Road *road = od.GetRoadById(table[k].GetConnectingRoadId());
+					Position start(&od);
+					Position end(&od);
+					start.SetLanePos(road->GetId(), 0, 0, 0);
+					end.SetLanePos(road->GetId(), 0, road->GetLength(), 0);
+					bool reversed = table[k].contact_point_ == CONTACT_POINT_END;
+					Position *entry = reversed ? &end : &start;
+					Position *exit = reversed ? &start : &end;
+					double h_entry = entry->GetH() + (reversed ? M_PI : 0);
+					double h_exit = exit->GetH() + (reversed ? M_PI : 0);
+					double angle = atan2(sin(h_exit - h_entry), cos(h_exit - h_entry));
+					double lateral = cos(h_entry) * (exit->GetY() - entry->GetY()) - sin(h_entry) * (exit->GetX() - entry->GetX());
+
+					EXPECT_NEAR(table[k].GetTurnAngle(), angle, 1e-9) << filename << " road " << road->GetId();
+					EXPECT_NEAR(remainder(table[k].GetExitHeading() - exit->GetH(), 2 * M_PI), 0, 1e-9) << filename << " road " << road->GetId();
+
+					LaneRoadLaneConnection::TurnType turn = table[k].GetTurnType();
+					if (fabs(angle) < M_PI / 6)
+					{
+						EXPECT_EQ(turn, LaneRoadLaneConnection::TURN_STRAIGHT) << filename << " road " << road->GetId();
+					}
+					else if (angle > 0)
+					{
+						EXPECT_EQ(turn, LaneRoadLaneConnection::TURN_LEFT) << filename << " road " << road->GetId();
+						EXPECT_GT(lateral, 0) << filename << " road " << road->GetId();
+					}
+					else
+					{
+						EXPECT_EQ(turn, LaneRoadLaneConnection::TURN_RIGHT) << filename << " road " << road->GetId();
+						EXPECT_LT(lateral, 0) << filename << " road " << road->GetId();
+					}
+					n_turn[turn]++;
+				}
+
+				// Lookup by turn picks the connection of the type closest to its nominal angle
+				for (LaneRoadLaneConnection::TurnType turn : { LaneRoadLaneConnection::TURN_LEFT,
+					LaneRoadLaneConnection::TURN_STRAIGHT, LaneRoadLaneConnection::TURN_RIGHT })
+				{
+					double target = turn == LaneRoadLaneConnection::TURN_LEFT ? M_PI_2 : (turn == LaneRoadLaneConnection::TURN_RIGHT ? -M_PI_2 : 0);
+					int expected = -1;
+					for (int k = 0; k < n_connections; k++)
+					{
+						if (table[k].GetTurnType() == turn && (expected == -1 ||
+							fabs(table[k].GetTurnAngle() - target) < fabs(table[expected].GetTurnAngle() - target)))
+						{
+							expected = k;
+						}
+					}
+					EXPECT_EQ(junction->GetRoadConnectionIdxByTurn(it->first, it->second, turn), expected) << filename << " junction " << junction->GetId();
+				}
+			}
+		}
+	}
+
+	// The maps include turns of every type
+	EXPECT_GT(n_turn[LaneRoadLaneConnection::TURN_LEFT], 0);
+	EXPECT_GT(n_turn[LaneRoadLaneConnection::TURN_STRAIGHT], 0);
+	EXPECT_GT(n_turn[LaneRoadLaneConnection::TURN_RIGHT], 0);
+}
+
+// Drive positions along driving lanes of fabriksgatan, choosing randomly at the junction. Positions are
+// stepped in given order, and each one's trace of road, lane and coordinates is recorded per step.
+static std::vector<std::vector<double> > RandomDrive(OpenDrive *od, std::vector<int> &order, unsigned int seed, bool seed_positions)
+{
+	std::vector<Position> pos;
+	std::vector<std::vector<double> > trace(order.size());
+
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		// Start on one of the four roads to the junction, in either direction
+		pos.push_back(Position(od));
+		pos.back().SetLanePos((int)i % 4, i % 8 < 4 ? -1 : 1, 20.0, 0);
+		if (seed_positions)
+		{
+			pos.back().SetRandomSeed(seed, (unsigned int)i);
+		}
+	}
+
+	for (int step = 0; step < 1000; step++)
+	{
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			Position *p = &pos[order[i]];
+			p->MoveAlongS(p->GetLaneId() < 0 ? 1.0 : -1.0);
+			trace[order[i]].insert(trace[order[i]].end(), { (double)p->GetTrackId(), (double)p->GetLaneId(), p->GetS(), p->GetX(), p->GetY() });
+		}
+	}
+
+	return trace;
+}
+
+// Seeded runs are repeated exactly, whatever order the positions are stepped in
+TEST(RandomSeedTest, SeededRunRepeats)
+{
+	OpenDrive od;
+	ASSERT_TRUE(od.LoadOpenDriveFile(RESOURCES_DIR "/xodr/fabriksgatan.xodr"));
+	std::vector<int> order;
+	for (int i = 0; i < 8; i++)
+	{
+		order.push_back(i);
+	}
+	std::vector<int> reverse_order(order.rbegin(), order.rend());
+	std::set<std::vector<std::vector<double> > > variants;
+
+	for (unsigned int seed = 1; seed <= 5; seed++)
+	{
+		std::vector<std::vector<double> > trace = RandomDrive(&od, order, seed, true);
+		std::vector<std::vector<double> > trace_repeated = RandomDrive(&od, order, seed, true);
+		std::vector<std::vector<double> > trace_reversed = RandomDrive(&od, reverse_order, seed, true);
+
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			// Bit identical, not only close
+			ASSERT_EQ(trace[i], trace_repeated[i]) << "seed " << seed << " position " << i;
+			ASSERT_EQ(trace[i], trace_reversed[i]) << "seed " << seed << " position " << i;
+		}
+		variants.insert(trace);
+	}
+
+	// The choices actually depend on the seed
+	EXPECT_GT(variants.size(), 1u);
+}
+
+// Positions not seeded explicitly draw their seeds from the road network, repeated if seeded the same way
+TEST(RandomSeedTest, NetworkSeedRepeats)
+{
+	std::vector<int> order;
+	for (int i = 0; i < 8; i++)
+	{
+		order.push_back(i);
+	}
+	std::vector<std::vector<double> > trace[2];
+
+	for (int run = 0; run < 2; run++)
+	{
+		OpenDrive od;
+		od.SetRandomSeed(17);
+		ASSERT_TRUE(od.LoadOpenDriveFile(RESOURCES_DIR "/xodr/fabriksgatan.xodr"));
+		trace[run] = RandomDrive(&od, order, 0, false);
+	}
+
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		ASSERT_EQ(trace[0][i], trace[1][i]) << "position " << i;
+	}
+}
+
+// Curvature of the circle through three points
+static double CircleCurvature(double x0, double y0, double x1, double y1, double x2, double y2)
+{
+	double a = sqrt((x1 - x0) * (x1 - x0) + (y1 - y0) * (y1 - y0));
+	double b = sqrt((x2 - x1) * (x2 - x1) + (y2 - y1) * (y2 - y1));
+	double c = sqrt((x2 - x0) * (x2 - x0) + (y2 - y0) * (y2 - y0));
+
+	return 2 * fabs((x1 - x0) * (y2 - y1) - (y1 - y0) * (x2 - x1)) / (a * b * c);
+}
+
+// Curvature bound of the geometries holds for the curvature measured along the roads, and is not far above it
+TEST(CurvatureTest, BoundCoversGeometry)
+{
+	const double step = 0.5;
+
+	for (const char *filename : odr_files)
+	{
+		OpenDrive od;
+		ASSERT_TRUE(od.LoadOpenDriveFile(filename)) << filename;
+
+		double od_max = 0;
+		for (int i = 0; i < od.GetNumOfRoads(); i++)
+		{
+			Road *road = od.GetRoadByIdx(i);
+
+			for (int j = 0; j < road->GetNumberOfGeometries(); j++)
+			{
+				Geometry *geom = road->GetGeometry(j);
+				double bound = geom->GetCurvatureBound();
+				double measured_max = 0;
+				double x[3], y[3], h;
+
+				for (double ds = step; ds < geom->GetLength() - step; ds += step)
+				{
+					for (int k = 0; k < 3; k++)
+					{
+						geom->EvaluateDS(ds + (k - 1) * step, &x[k], &y[k], &h);
+					}
+					double curvature = CircleCurvature(x[0], y[0], x[1], y[1], x[2], y[2]);
+					EXPECT_LE(curvature, bound * 1.01 + 1e-4) << filename << " road " << road->GetId() << " geometry " << j << " ds " << ds;
+					measured_max = std::max(measured_max, curvature);
+				}
+				EXPECT_LE(bound, 2 * measured_max + 1e-3) << filename << " road " << road->GetId() << " geometry " << j;
+				EXPECT_LE(bound, road->GetMaxCurvature()) << filename << " road " << road->GetId();
+			}
+			od_max = std::max(od_max, road->GetMaxCurvature());
+		}
+		EXPECT_EQ(od_max, od.GetMaxCurvature()) << filename;
+	}
+}
+
+// Tiled road network knows the curvature bound of all roads, also of tiles not loaded
+TEST(CurvatureTest, TiledEqualsComplete)
+{
+	for (const char *filename : odr_files)
+	{
+		std::string cache_filename = std::string(".") + strrchr(filename, '/') + ".cache";
+		std::remove(cache_filename.c_str());
+
+		OpenDrive od_complete;
+		ASSERT_TRUE(od_complete.LoadOpenDriveFile(filename)) << filename;
+
+		OpenDrive od_tiled;
+		od_tiled.SetCacheDir(".");
+		ASSERT_TRUE(od_tiled.LoadOpenDriveFileTiled(filename)) << filename;
+		ASSERT_TRUE(od_tiled.IsTiled()) << filename;
+		EXPECT_EQ(od_tiled.GetNumberOfLoadedTiles(), 0) << filename;
+
+		EXPECT_EQ(od_complete.GetMaxCurvature(), od_tiled.GetMaxCurvature()) << filename;
+		std::remove(cache_filename.c_str());
+	}
+}
+
+// Loads on demand, by road lookup, keep the tile memory within budget
+TEST(TileTest, LookupRespectsBudget)
+{
+	for (const char *filename : odr_files)
+	{
+		std::string cache_filename = std::string(".") + strrchr(filename, '/') + ".cache";
+		std::remove(cache_filename.c_str());
+
+		OpenDrive od_complete;
+		ASSERT_TRUE(od_complete.LoadOpenDriveFile(filename)) << filename;
+
+		OpenDrive od_tiled;
+		od_tiled.SetCacheDir(".");
+		ASSERT_TRUE(od_tiled.LoadOpenDriveFileTiled(filename, 100.0)) << filename;
+		ASSERT_TRUE(od_tiled.IsTiled()) << filename;
+
+		// Find size of largest tile, by loading one at a time
+		size_t budget = 0;
+		for (int i = 0; i < od_tiled.GetNumOfRoads(); i++)
+		{
+			od_tiled.SetTileMemoryBudget(1);
+			od_tiled.UpdateTiles(0, 0, 0, 0);
+			od_tiled.GetRoadByIdx(i);
+			budget = std::max(budget, od_tiled.GetTileMemoryUsage());
+		}
+		od_tiled.SetTileMemoryBudget(budget);
+
+		for (int i = 0; i < od_tiled.GetNumOfRoads(); i++)
+		{
+			od_tiled.UpdateTiles(0, 0, 0, 0);
+			Road *road = od_tiled.GetRoadByIdx(i);
+			EXPECT_LE(od_tiled.GetTileMemoryUsage(), budget) << filename << " road " << i;
+			ASSERT_TRUE(od_tiled.IsRoadLoaded(i)) << filename << " road " << i;
+
+			Road *road_complete = od_complete.GetRoadByIdx(i);
+			ASSERT_EQ(road->GetId(), road_complete->GetId()) << filename;
+			EXPECT_EQ(road->GetNumberOfGeometries(), road_complete->GetNumberOfGeometries()) << filename << " road " << i;
+			EXPECT_EQ(road->GetNumberOfLaneSections(), road_complete->GetNumberOfLaneSections()) << filename << " road " << i;
+		}
+		std::remove(cache_filename.c_str());
+	}
+}
+
+// Spiral evaluated by Fresnel integrals at every point. This is how Spiral::EvaluateDS() did it before
+// the lookup table, kept here as reference.
+static void ExactSpiral(Spiral *spiral, double ds, double *x, double *y, double *h)
+{
+	double xTmp, yTmp, t;
+	double h_start = spiral->GetHdg();
+
+	if (fabs(spiral->GetCurvEnd()) > fabs(spiral->GetCurvStart()))
+	{
+		odrSpiral(ds + spiral->GetS0(), spiral->GetCDot(), &xTmp, &yTmp, &t);
+		*h = t;
+	}
+	else
+	{
+		double x0, y0, t0, x1, y1, t1;
+
+		odrSpiral(spiral->GetS0() + spiral->GetLength(), spiral->GetCDot(), &x0, &y0, &t0);
+		odrSpiral(spiral->GetS0() + spiral->GetLength() - ds, spiral->GetCDot(), &x1, &y1, &t1);
+
+		xTmp = x0 - x1;
+		yTmp = y0 - y1;
+		h_start -= t0;
+		*h = t1 - t0;
+	}
+
+	*h += spiral->GetHdg() + spiral->GetH0();
+
+	double x1 = xTmp - spiral->GetX0();
+	double y1 = yTmp - spiral->GetY0();
+	double x2 = x1 * cos(-spiral->GetH0()) - y1 * sin(-spiral->GetH0());
+	double y2 = x1 * sin(-spiral->GetH0()) + y1 * cos(-spiral->GetH0());
+
+	*x = spiral->GetX() + x2 * cos(h_start) - y2 * sin(h_start);
+	*y = spiral->GetY() + x2 * sin(h_start) + y2 * cos(h_start);
+}
+
+// Spiral lookup table is within 1e-6 m of the exact spiral, for random curvature ranges in both directions
+TEST(SpiralTest, TableEqualsExact)
+{
+	std::mt19937 gen(1234);
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+	for (int i = 0; i < 200; i++)
+	{
+		// Every fourth spiral starts or ends straight, others have curvature at both ends, also of different signs
+		double curv_start = i % 4 == 0 ? 0.0 : (unit(gen) - 0.5) * 0.4;
+		double curv_end = i % 4 == 1 ? 0.0 : (unit(gen) - 0.5) * 0.4;
+		double length = 1.0 + unit(gen) * 300.0;
+		Road road(i, "");
+
+		road.AddSpiral(Spiral(0.0, (unit(gen) - 0.5) * 1000, (unit(gen) - 0.5) * 1000, unit(gen) * 2 * M_PI, length, curv_start, curv_end));
+		Spiral *spiral = (Spiral*)road.GetGeometry(0);
+
+		for (int j = 0; j <= 2000; j++)
+		{
+			// Both ends, and random points in between
+			double ds = j == 0 ? 0.0 : (j == 2000 ? length : unit(gen) * length);
+			double x, y, h, x_exact, y_exact, h_exact;
+
+			spiral->EvaluateDS(ds, &x, &y, &h);
+			ExactSpiral(spiral, ds, &x_exact, &y_exact, &h_exact);
+
+			ASSERT_LE(sqrt((x - x_exact) * (x - x_exact) + (y - y_exact) * (y - y_exact)), 1e-6) << "spiral " << i <<
+				" curvature " << curv_start << " to " << curv_end << " length " << length << " ds " << ds;
+			ASSERT_NEAR(h, h_exact, 1e-12) << "spiral " << i << " ds " << ds;
+		}
+	}
+}
+
+// Random road with geometries of all types, in sequence along s but not connected
+static void AddRandomGeometries(Road &road, std::mt19937 &gen)
+{
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	double s = 0;
+
+	for (int i = 0; i < 12; i++)
+	{
+		double x = (unit(gen) - 0.5) * 1000;
+		double y = (unit(gen) - 0.5) * 1000;
+		double hdg = unit(gen) * 2 * M_PI;
+		double length = 5.0 + unit(gen) * 200.0;
+
+		switch (i % 6)
+		{
+		case 0: road.AddLine(Line(s, x, y, hdg, length)); break;
+		case 1: road.AddArc(Arc(s, x, y, hdg, length, (unit(gen) - 0.5) * 0.2)); break;
+		case 2: road.AddSpiral(Spiral(s, x, y, hdg, length, (unit(gen) - 0.5) * 0.2, (unit(gen) - 0.5) * 0.2)); break;
+		case 3: road.AddPoly3(Poly3(s, x, y, hdg, length, (unit(gen) - 0.5), (unit(gen) - 0.5) * 0.1, 
+			(unit(gen) - 0.5) * 1e-3, (unit(gen) - 0.5) * 1e-5)); break;
+		case 4: road.AddParamPoly3(ParamPoly3(s, x, y, hdg, length, 0, length, (unit(gen) - 0.5) * 10, (unit(gen) - 0.5) * 10,
+			0, 0, (unit(gen) - 0.5) * 20, (unit(gen) - 0.5) * 20, ParamPoly3::P_RANGE_NORMALIZED)); break;
+		case 5: road.AddParamPoly3(ParamPoly3(s, x, y, hdg, length, 0, 1, (unit(gen) - 0.5) * 1e-3, (unit(gen) - 0.5) * 1e-5,
+			0, 0, (unit(gen) - 0.5) * 1e-2, (unit(gen) - 0.5) * 1e-4, ParamPoly3::P_RANGE_ARC_LENGTH)); break;
+		}
+		s += length;
+	}
+	road.SetLength(s);
+}
+
+static void ExpectBatchEqualsScalar(Road *road, std::mt19937 &gen, const char *name)
+{
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	const int n = 300;
+	double ds[n], s[n], x[n], y[n], h[n];
+
+	for (int i = 0; i < road->GetNumberOfGeometries(); i++)
+	{
+		Geometry *geom = road->GetGeometry(i);
+
+		// Both ends, and random points in between
+		for (int j = 0; j < n; j++)
+		{
+			ds[j] = j == 0 ? 0.0 : (j == n - 1 ? geom->GetLength() : unit(gen) * geom->GetLength());
+		}
+		geom->EvaluateDSBatch(n, ds, x, y, h);
+
+		for (int j = 0; j < n; j++)
+		{
+			double x_scalar, y_scalar, h_scalar;
+
+			geom->EvaluateDS(ds[j], &x_scalar, &y_scalar, &h_scalar);
+			ASSERT_EQ(x[j], x_scalar) << name << " road " << road->GetId() << " geometry " << i << " type " << geom->GetType() << " ds " << ds[j];
+			ASSERT_EQ(y[j], y_scalar) << name << " road " << road->GetId() << " geometry " << i << " type " << geom->GetType() << " ds " << ds[j];
+			ASSERT_EQ(h[j], h_scalar) << name << " road " << road->GetId() << " geometry " << i << " type " << geom->GetType() << " ds " << ds[j];
+		}
+	}
+
+	// Along the whole road, in increasing order spanning several geometries per batch, then in random order
+	for (int k = 0; k < 2; k++)
+	{
+		for (int j = 0; j < n; j++)
+		{
+			s[j] = k == 0 ? road->GetLength() * j / (n - 1) : unit(gen) * road->GetLength();
+		}
+		road->EvaluateSBatch(n, s, x, y, h);
+
+		for (int j = 0; j < n; j++)
+		{
+			Geometry *geom = road->GetGeometry(road->GetGeometryIdxByS(s[j]));
+			double x_scalar, y_scalar, h_scalar;
+
+			geom->EvaluateDS(s[j] - geom->GetS(), &x_scalar, &y_scalar, &h_scalar);
+			ASSERT_EQ(x[j], x_scalar) << name << " road " << road->GetId() << " s " << s[j];
+			ASSERT_EQ(y[j], y_scalar) << name << " road " << road->GetId() << " s " << s[j];
+			ASSERT_EQ(h[j], h_scalar) << name << " road " << road->GetId() << " s " << s[j];
+		}
+	}
+}
+
+// Batch evaluation gives bitwise the same result as evaluating each point, for all geometry types
+TEST(BatchEvaluationTest, BatchEqualsScalar)
+{
+	std::mt19937 gen(1234);
+
+	for (int i = 0; i < 20; i++)
+	{
+		Road road(i, "");
+
+		AddRandomGeometries(road, gen);
+		ExpectBatchEqualsScalar(&road, gen, "random");
+	}
+
+	for (const char *filename : odr_files)
+	{
+		OpenDrive od;
+		ASSERT_TRUE(od.LoadOpenDriveFile(filename)) << filename;
+
+		for (int i = 0; i < od.GetNumOfRoads(); i++)
+		{
+			ExpectBatchEqualsScalar(od.GetRoadByIdx(i), gen, filename);
+		}
+	}
+}
+
+// Cursor position equals exact evaluation of the road geometry, within 1e-9 m also between anchors
+static void ExpectCursorExact(RoadCursor &cursor, const char *filename, double ds)
+{
+	Road *road = cursor.GetRoad();
+	Geometry *geom = road->GetGeometry(road->GetGeometryIdxByS(cursor.GetS()));
+	double x, y, h;
+
+	geom->EvaluateDS(cursor.GetS() - geom->GetS(), &x, &y, &h);
+	ASSERT_NEAR(cursor.GetX(), x, 1e-9) << filename << " road " << road->GetId() << " s " << cursor.GetS() << " ds " << ds;
+	ASSERT_NEAR(cursor.GetY(), y, 1e-9) << filename << " road " << road->GetId() << " s " << cursor.GetS() << " ds " << ds;
+	ASSERT_NEAR(remainder(cursor.GetH() - h, 2 * M_PI), 0, 1e-9) << filename << " road " << road->GetId() << " s " << cursor.GetS() << " ds " << ds;
+}
+
+// Steps of constant and varying length, forwards and backwards, over many anchor intervals
+TEST(RoadCursorTest, MoveToEqualsExact)
+{
+	std::mt19937 gen(7);
+	std::uniform_real_distribution<double> step_dist(0.01, 2.0);
+
+	for (const char *filename : odr_files)
+	{
+		OpenDrive od;
+		ASSERT_TRUE(od.LoadOpenDriveFile(filename)) << filename;
+
+		for (int i = 0; i < od.GetNumOfRoads(); i++)
+		{
+			Road *road = od.GetRoadByIdx(i);
+			RoadCursor cursor;
+
+			for (double ds : { 0.1, 0.37, -0.1, -0.37 })
+			{
+				// Enough steps to pass several anchors also on short roads
+				double step = ds * std::min(1.0, road->GetLength() / (4 * ROAD_CURSOR_ANCHOR_INTERVAL * fabs(ds)));
+				cursor.Set(road, step > 0 ? 0.0 : road->GetLength());
+				ExpectCursorExact(cursor, filename, step);
+				for (int j = 0; j < 4 * ROAD_CURSOR_ANCHOR_INTERVAL && cursor.GetS() + step >= 0 && cursor.GetS() + step <= road->GetLength(); j++)
+				{
+					cursor.Step(step);
+					ExpectCursorExact(cursor, filename, step);
+				}
+			}
+
+			// Small steps over the complete road, where drift would accumulate without anchors
+			cursor.Set(road, 0.0);
+			while (cursor.GetS() < road->GetLength())
+			{
+				cursor.Step(0.01);
+				ExpectCursorExact(cursor, filename, 0.01);
+			}
+
+			// Varying steps, mixed with runs of constant steps, in both directions
+			cursor.Set(road, road->GetLength() / 2);
+			for (int j = 0; j < 500; j++)
+			{
+				double step = step_dist(gen) * (gen() % 2 ? 1 : -1);
+				int n_run = gen() % 4 == 0 ? ROAD_CURSOR_ANCHOR_INTERVAL + 3 : 1;
+				for (int k = 0; k < n_run; k++)
+				{
+					cursor.Step(step);
+					ExpectCursorExact(cursor, filename, step);
+				}
+			}
+		}
+	}
+}
+
+// Long runs of equal steps on a single line or arc, far from origin, where drift is not bounded by geometry changes
+TEST(RoadCursorTest, AnchorBoundsDrift)
+{
+	Road line(0, "");
+	line.AddLine(Line(0, 5000, -3000, 0.3, 5000));
+	line.SetLength(5000);
+	Road arc(1, "");
+	arc.AddArc(Arc(0, 5000, -3000, 0.3, 5000, 0.013));
+	arc.SetLength(5000);
+
+	for (Road *road : { &line, &arc })
+	{
+		RoadCursor cursor;
+
+		for (double ds : { 0.01, -0.01, 0.1234 })
+		{
+			cursor.Set(road, ds > 0 ? 0.0 : road->GetLength());
+			while (cursor.GetS() + ds >= 0 && cursor.GetS() + ds <= road->GetLength())
+			{
+				cursor.Step(ds);
+				ExpectCursorExact(cursor, "synthetic", ds);
+			}
+		}
+	}
+}
+
+// Lane positions of the cursor equal the ones of Position, also at lane section boundaries
+TEST(RoadCursorTest, LanePosEqualsPosition)
+{
+	for (const char *filename : odr_files)
+	{
+		OpenDrive od;
+		ASSERT_TRUE(od.LoadOpenDriveFile(filename)) << filename;
+
+		for (int i = 0; i < od.GetNumOfRoads(); i++)
+		{
+			Road *road = od.GetRoadByIdx(i);
+			std::vector<double> s_values;
+
+			for (int j = 0; j < road->GetNumberOfLaneSections(); j++)
+			{
+				LaneSection *lane_section = road->GetLaneSectionByIdx(j);
+				s_values.push_back(lane_section->GetS());
+				s_values.push_back(lane_section->GetS() + lane_section->GetLength() / 2);
+				s_values.push_back(std::max(0.0, lane_section->GetS() + lane_section->GetLength() - 1e-6));
+			}
+			s_values.push_back(road->GetLength());
+
+			RoadCursor cursor;
+			cursor.Set(road, 0.0);
+			for (double s : s_values)
+			{
+				// Reach each s by moving, forwards and backwards, as well as by setting
+				for (int mode = 0; mode < 2; mode++)
+				{
+					if (mode == 0)
+					{
+						cursor.MoveTo(s);
+					}
+					else
+					{
+						cursor.Set(road, s);
+					}
+					// At a boundary both lane sections apply, the choice depends on the way there as for Position
+					LaneSection *lane_section = road->GetLaneSectionByIdx(cursor.GetLaneSectionIdx());
+					ASSERT_NE(lane_section, nullptr) << filename << " road " << road->GetId();
+					ASSERT_GE(s, lane_section->GetS()) << filename << " road " << road->GetId();
+					ASSERT_LE(s, lane_section->GetS() + lane_section->GetLength() + SMALL_NUMBER) << filename << " road " << road->GetId();
+
+					for (int k = 0; k < lane_section->GetNumberOfLanes(); k++)
+					{
+						int lane_id = lane_section->GetLaneByIdx(k)->GetId();
+						for (double offset : { 0.0, 0.4 })
+						{
+							Position pos(&od);
+							double x, y, h;
+							pos.SetLanePos(road->GetId(), lane_id, s, offset, cursor.GetLaneSectionIdx());
+							cursor.GetLanePos(lane_id, offset, &x, &y, &h);
+							EXPECT_NEAR(x, pos.GetX(), 1e-9) << filename << " road " << road->GetId() << " lane " << lane_id << " s " << s;
+							EXPECT_NEAR(y, pos.GetY(), 1e-9) << filename << " road " << road->GetId() << " lane " << lane_id << " s " << s;
+							EXPECT_NEAR(remainder(h - pos.GetH(), 2 * M_PI), 0, 1e-9) << filename << " road " << road->GetId() << " lane " << lane_id << " s " << s;
+						}
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,786 @@
+/*
+ * esmini - Environment Simulator Minimalistic
+ * https://github.com/esmini/esmini
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) partners of Simulation Scenarios
+ * https://sites.google.com/view/simulationscenarios
+ */
+
+#include <cstdio>
+#include <cstdarg>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <set>
+#include <algorithm>
+#include <stdexcept>
+#include <gtest/gtest.h>
+#include "ScenarioEngine.hpp"
+#include "ScenarioReader.hpp"
+#include "Storyboard.hpp"
+#include "Catalogs.hpp"
+#include "Entities.hpp"
+#include "Init.hpp"
+#include "Story.hpp"
+#include "RoadNetwork.hpp"
+#include "RoadManager.hpp"
+#include "CommonMini.hpp"
+
+using namespace scenarioengine;
+
+// Bundled scenarios with a story (distance_test.xosc has an empty act)
+static const char *xosc_files[] =
+{
+	RESOURCES_DIR "/xosc/cut-in.xosc",
+	RESOURCES_DIR "/xosc/cut-in_cr.xosc",
+	RESOURCES_DIR "/xosc/cut-in_simple.xosc",
+	RESOURCES_DIR "/xosc/highway_merge.xosc",
+	RESOURCES_DIR "/xosc/highway_merge_advanced.xosc",
+	RESOURCES_DIR "/xosc/ltap-od.xosc",
+	RESOURCES_DIR "/xosc/ltap-od_two_targets.xosc",
+};
+
+// Story stepping by walking the full story tree and evaluating every condition each step. This is
+// how ScenarioEngine::step() did it before the Storyboard, kept here as reference.
+static void TreeWalkStep(std::vector<Story*> &story, double dt, double sim_time)
+{
+	for (size_t i = 0; i < story.size(); i++)
+	{
+		for (size_t j = 0; j < story[i]->act_.size(); j++)
+		{
+			Act *act = story[i]->act_[j];
+
+			// Update deactivated elements' state to inactive
+			for (size_t k = 0; k < act->sequence_.size(); k++)
+			{
+				for (size_t l = 0; l < act->sequence_[k]->maneuver_.size(); l++)
+				{
+					OSCManeuver *maneuver = act->sequence_[k]->maneuver_[l];
+
+					for (size_t m = 0; m < maneuver->event_.size(); m++)
+					{
+						for (size_t n = 0; n < maneuver->event_[m]->action_.size(); n++)
+						{
+							if (maneuver->event_[m]->action_[n]->state_ == OSCAction::State::DEACTIVATED)
+							{
+								maneuver->event_[m]->action_[n]->state_ = OSCAction::State::INACTIVE;
+							}
+						}
+						if (maneuver->event_[m]->state_ == Event::State::DEACTIVATED)
+						{
+							maneuver->event_[m]->state_ = Event::State::INACTIVE;
+						}
+					}
+				}
+			}
+			if (act->state_ == Act::State::DEACTIVATED)
+			{
+				act->state_ = Act::State::INACTIVE;
+			}
+
+			// Check Act conditions
+			if (!act->IsActive())
+			{
+				for (size_t k = 0; k < act->start_condition_group_.size(); k++)
+				{
+					for (size_t l = 0; l < act->start_condition_group_[k]->condition_.size(); l++)
+					{
+						if (act->start_condition_group_[k]->condition_[l]->Evaluate(story[i], sim_time))
+						{
+							act->Trig();
+						}
+					}
+				}
+			}
+			else if (act->state_ == Act::State::ACTIVATED)
+			{
+				act->state_ = Act::State::ACTIVE;
+			}
+
+			if (act->IsActive())
+			{
+				for (size_t k = 0; k < act->end_condition_group_.size(); k++)
+				{
+					for (size_t l = 0; l < act->end_condition_group_[k]->condition_.size(); l++)
+					{
+						if (act->end_condition_group_[k]->condition_[l]->Evaluate(story[i], sim_time))
+						{
+							act->Stop();
+						}
+					}
+				}
+
+				for (size_t k = 0; k < act->cancel_condition_group_.size(); k++)
+				{
+					for (size_t l = 0; l < act->cancel_condition_group_[k]->condition_.size(); l++)
+					{
+						if (act->cancel_condition_group_[k]->condition_[l]->Evaluate(story[i], sim_time))
+						{
+							act->Stop();
+						}
+					}
+				}
+			}
+
+			if (!act->IsActive())
+			{
+				continue;
+			}
+
+			// Maneuvers
+			for (size_t k = 0; k < act->sequence_.size(); k++)
+			{
+				for (size_t l = 0; l < act->sequence_[k]->maneuver_.size(); l++)
+				{
+					OSCManeuver *maneuver = act->sequence_[k]->maneuver_[l];
+
+					// Events - may only execute one at a time
+					for (size_t m = 0; m < maneuver->event_.size(); m++)
+					{
+						Event *event = maneuver->event_[m];
+
+						if (event->IsActive())
+						{
+							if (event->state_ == Event::State::ACTIVATED)
+							{
+								event->state_ = Event::State::ACTIVE;
+							}
+						}
+						else if (event->state_ == Event::State::DEACTIVATED)
+						{
+							event->state_ = Event::State::INACTIVE;
+						}
+					}
+					if (maneuver->GetActiveEventIdx() == -1 && maneuver->GetWaitingEventIdx() >= 0)
+					{
+						maneuver->event_[maneuver->GetWaitingEventIdx()]->Trig();
+					}
+
+					for (size_t m = 0; m < maneuver->event_.size(); m++)
+					{
+						Event *event = maneuver->event_[m];
+
+						if (event->Triggable())
+						{
+							for (size_t n = 0; n < event->start_condition_group_.size(); n++)
+							{
+								for (size_t o = 0; o < event->start_condition_group_[n]->condition_.size(); o++)
+								{
+									if (!event->start_condition_group_[n]->condition_[o]->Evaluate(story[i], sim_time))
+									{
+										continue;
+									}
+
+									if (event->priority_ == Event::Priority::OVERWRITE)
+									{
+										if (maneuver->GetActiveEventIdx() >= 0)
+										{
+											maneuver->event_[maneuver->GetActiveEventIdx()]->Stop();
+										}
+										event->Trig();
+									}
+									else if (event->priority_ == Event::Priority::FOLLOWING)
+									{
+										if (maneuver->GetActiveEventIdx() >= 0)
+										{
+											event->state_ = Event::State::WAITING;
+										}
+										else
+										{
+											event->Trig();
+										}
+									}
+									else if (event->priority_ == Event::Priority::SKIP)
+									{
+										if (maneuver->GetActiveEventIdx() < 0)
+										{
+											event->Trig();
+										}
+									}
+								}
+							}
+						}
+
+						// Update (step) all active actions
+						if (event->IsActive())
+						{
+							bool active = false;
+
+							for (size_t n = 0; n < event->action_.size(); n++)
+							{
+								OSCAction *action = event->action_[n];
+
+								if (action->state_ == OSCAction::State::TRIGGED)
+								{
+									action->state_ = OSCAction::State::ACTIVATED;
+								}
+								else if (action->state_ == OSCAction::State::ACTIVATED)
+								{
+									action->state_ = OSCAction::State::ACTIVE;
+								}
+
+								if (action->IsActive())
+								{
+									action->Step(dt);
+									active = active || action->IsActive();
+								}
+							}
+							if (!active)
+							{
+								event->Stop();
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+typedef enum
+{
+	STEP_SCHEDULED,  // Storyboard, default mode
+	STEP_POLLED,     // Storyboard, all conditions evaluated every step
+	STEP_TREE_WALK,
+} StepMode;
+
+// Parses a scenario and steps it the same way as ScenarioEngine::step(), in given mode. Records a
+// trace of story element state transitions and object states.
+class ScenarioRun
+{
+public:
+	std::vector<std::string> trace_;
+
+	ScenarioRun(const char *filename, StepMode mode, const pugi::xml_document *doc = 0) : mode_(mode), sim_time_(0)
+	{
+		if (doc)
+		{
+			reader_.loadOSCMem(*doc, filename, ExternalControlMode::EXT_CONTROL_OFF);
+		}
+		else if (reader_.loadOSCFile(filename, ExternalControlMode::EXT_CONTROL_OFF) != 0)
+		{
+			throw std::invalid_argument(std::string("Failed to load OpenSCENARIO file ") + filename);
+		}
+		reader_.parseRoadNetwork(road_network_);
+		if (!od_.LoadOpenDriveFile(road_network_.Logics.filepath.c_str()))
+		{
+			throw std::invalid_argument(std::string("Failed to load OpenDRIVE file ") + road_network_.Logics.filepath);
+		}
+		reader_.SetOpenDrive(&od_);
+		reader_.parseParameterDeclaration();
+		reader_.parseCatalogs(catalogs_, &entities_);
+		reader_.parseEntities(entities_, &catalogs_);
+		reader_.parseInit(init_, &entities_, &catalogs_);
+		reader_.parseStory(story_, &entities_, &catalogs_);
+		storyboard_.Compile(story_);
+		storyboard_.SetPolling(mode == STEP_POLLED);
+
+		od_.SetRandomSeed(1);
+		for (size_t i = 0; i < entities_.object_.size(); i++)
+		{
+			// No external input, the scenario controls all objects
+			entities_.object_[i]->extern_control_ = false;
+			entities_.object_[i]->pos_.SetRandomSeed(1, (unsigned int)entities_.object_[i]->id_);
+		}
+	}
+
+	void Step(double dt)
+	{
+		bool initial = sim_time_ == 0;
+
+		sim_time_ += dt;
+
+		for (size_t i = 0; i < init_.private_action_.size(); i++)
+		{
+			if (initial)
+			{
+				init_.private_action_[i]->Trig();
+			}
+			if (init_.private_action_[i]->IsActive())
+			{
+				init_.private_action_[i]->Step(dt);
+			}
+		}
+
+		for (size_t i = 0; i < entities_.object_.size(); i++)
+		{
+			if (initial)
+			{
+				entities_.object_[i]->ResetMotion();
+			}
+			entities_.object_[i]->NextMotionSegment();
+		}
+
+		if (mode_ == STEP_TREE_WALK)
+		{
+			TreeWalkStep(story_, dt, sim_time_);
+		}
+		else
+		{
+			storyboard_.Step(dt, sim_time_);
+		}
+
+		for (size_t i = 0; i < entities_.object_.size(); i++)
+		{
+			Object *obj = entities_.object_[i];
+
+			Trace("object %s x %.6f y %.6f h %.6f speed %.6f", obj->name_.c_str(), obj->pos_.GetX(), obj->pos_.GetY(), obj->pos_.GetH(), obj->speed_);
+
+			if (obj->pos_.GetRoute())
+			{
+				obj->pos_.MoveRouteDS(obj->speed_ * dt);
+			}
+			else
+			{
+				obj->pos_.MoveAlongS(obj->speed_ * dt);
+			}
+		}
+
+		TraceTransitions();
+	}
+
+private:
+	StepMode mode_;
+	double sim_time_;
+	roadmanager::OpenDrive od_;
+	ScenarioReader reader_;
+	RoadNetwork road_network_;
+	Catalogs catalogs_;
+	Entities entities_;
+	Init init_;
+	std::vector<Story*> story_;
+	Storyboard storyboard_;
+	std::vector<int> state_;  // Story element states as of previous step, in tree order
+
+	void Trace(const char *format, ...)
+	{
+		char buf[256];
+		va_list args;
+
+		va_start(args, format);
+		vsnprintf(buf, sizeof(buf), format, args);
+		va_end(args);
+
+		trace_.push_back(buf);
+	}
+
+	void TraceState(size_t &idx, const char *type, std::string &name, int state)
+	{
+		if (idx == state_.size())
+		{
+			state_.push_back(0);  // All elements start inactive
+		}
+		if (state_[idx] != state)
+		{
+			Trace("%.2f %s %s %d -> %d", sim_time_, type, name.c_str(), state_[idx], state);
+			state_[idx] = state;
+		}
+		idx++;
+	}
+
+	void TraceTransitions()
+	{
+		size_t idx = 0;
+
+		for (size_t i = 0; i < story_.size(); i++)
+		{
+			for (size_t j = 0; j < story_[i]->act_.size(); j++)
+			{
+				Act *act = story_[i]->act_[j];
+
+				TraceState(idx, "act", act->name_, act->state_);
+				for (size_t k = 0; k < act->sequence_.size(); k++)
+				{
+					for (size_t l = 0; l < act->sequence_[k]->maneuver_.size(); l++)
+					{
+						OSCManeuver *maneuver = act->sequence_[k]->maneuver_[l];
+
+						for (size_t m = 0; m < maneuver->event_.size(); m++)
+						{
+							Event *event = maneuver->event_[m];
+
+							TraceState(idx, "event", event->name_, event->state_);
+							for (size_t n = 0; n < event->action_.size(); n++)
+							{
+								TraceState(idx, "action", event->action_[n]->name_, event->action_[n]->state_);
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+};
+
+static void ExpectEqualTraces(std::vector<std::string> &trace1, std::vector<std::string> &trace2)
+{
+	size_t n = std::min(trace1.size(), trace2.size());
+
+	for (size_t i = 0; i < n; i++)
+	{
+		ASSERT_EQ(trace1[i], trace2[i]) << "first difference at trace line " << i;
+	}
+	EXPECT_EQ(trace1.size(), trace2.size());
+}
+
+static int CountTransitions(std::vector<std::string> &trace)
+{
+	int count = 0;
+
+	for (size_t i = 0; i < trace.size(); i++)
+	{
+		if (trace[i].compare(0, 7, "object ") != 0)
+		{
+			count++;
+		}
+	}
+
+	return count;
+}
+
+TEST(StoryboardTest, EqualsTreeWalk)
+{
+	for (size_t i = 0; i < sizeof(xosc_files) / sizeof(xosc_files[0]); i++)
+	{
+		SCOPED_TRACE(xosc_files[i]);
+
+		ScenarioRun storyboard(xosc_files[i], STEP_SCHEDULED);
+		ScenarioRun tree_walk(xosc_files[i], STEP_TREE_WALK);
+
+		for (int j = 0; j < 1500; j++)
+		{
+			storyboard.Step(0.02);
+			tree_walk.Step(0.02);
+		}
+
+		// Make sure the scenario actually did something
+		EXPECT_GT(CountTransitions(tree_walk.trace_), 0);
+
+		ExpectEqualTraces(storyboard.trace_, tree_walk.trace_);
+	}
+}
+
+// Set attribute of all conditions within elements of given type, e.g. "Event"
+static void SetConditionAttribute(pugi::xml_node node, const char *scope, const char *name, const char *value, bool in_scope = false)
+{
+	for (pugi::xml_node child = node.first_child(); child; child = child.next_sibling())
+	{
+		if (in_scope && !strcmp(child.name(), "Condition") && child.attribute(name))
+		{
+			child.attribute(name).set_value(value);
+		}
+		SetConditionAttribute(child, scope, name, value, in_scope || !strcmp(child.name(), scope));
+	}
+}
+
+TEST(StoryboardTest, ScheduledEqualsPolled)
+{
+	// Delay of all conditions and edge of event conditions, 0 for as in the file. Acts keep their edges,
+	// so that they still start. Together the bundled scenarios have SimulationTime, TimeHeadway, Distance,
+	// RelativeDistance, ReachPosition, AtStart and AfterTermination conditions.
+	const char *variant[][2] =
+	{
+		{ 0, 0 },
+		{ "0.5", 0 },
+		{ "0.5", "falling" },
+		{ 0, "any" },
+	};
+
+	for (size_t i = 0; i < sizeof(xosc_files) / sizeof(xosc_files[0]); i++)
+	{
+		for (size_t j = 0; j < sizeof(variant) / sizeof(variant[0]); j++)
+		{
+			pugi::xml_document doc;
+
+			SCOPED_TRACE(std::string(xosc_files[i]) + " delay " + (variant[j][0] ? variant[j][0] : "-") +
+				" edge " + (variant[j][1] ? variant[j][1] : "-"));
+
+			ASSERT_TRUE(doc.load_file(xosc_files[i]));
+			if (variant[j][0])
+			{
+				SetConditionAttribute(doc, "Storyboard", "delay", variant[j][0]);
+			}
+			if (variant[j][1])
+			{
+				SetConditionAttribute(doc, "Event", "edge", variant[j][1]);
+			}
+
+			ScenarioRun scheduled(xosc_files[i], STEP_SCHEDULED, &doc);
+			ScenarioRun polled(xosc_files[i], STEP_POLLED, &doc);
+
+			for (int k = 0; k < 1500; k++)
+			{
+				scheduled.Step(0.02);
+				polled.Step(0.02);
+			}
+
+			EXPECT_GT(CountTransitions(polled.trace_), 0);
+
+			ExpectEqualTraces(scheduled.trace_, polled.trace_);
+		}
+	}
+}
+
+// Simulation time of the first transition of a story element into given state, -1 if none
+static double TransitionTime(std::vector<std::string> &trace, const char *type, const char *name, int state)
+{
+	for (size_t i = 0; i < trace.size(); i++)
+	{
+		double t;
+		char t_type[32];
+		char t_name[128];
+		int from, to;
+
+		if (sscanf(trace[i].c_str(), "%lf %31s %127s %d -> %d", &t, t_type, t_name, &from, &to) == 5 &&
+			!strcmp(t_type, type) && !strcmp(t_name, name) && to == state)
+		{
+			return t;
+		}
+	}
+
+	return -1;
+}
+
+// Make the Ego of highway_merge stand still in lane -3, then change lane at 1 s, and watch for it
+// passing the point between lanes -3 and -2. So it is moved by an action only.
+static void MakeLaneChangeWatch(pugi::xml_document &doc, const char *odr_filename)
+{
+	roadmanager::OpenDrive od;
+	roadmanager::Position from(&od);
+	roadmanager::Position to(&od);
+	od.LoadOpenDriveFile(odr_filename);
+	from.SetLanePos(0, -3, 20.0, 0);
+	to.SetLanePos(0, -2, 20.0, 0);
+
+	pugi::xml_node ego = doc.select_node("//Init/Actions/Private[@object='Ego']").node();
+	pugi::xml_node lane = ego.select_node(".//Position/Lane").node();
+	lane.attribute("roadId") = "0";
+	lane.attribute("laneId") = "-3";
+	lane.attribute("s") = "20.0";
+	ego.select_node(".//Speed/Target/Absolute").node().attribute("value") = "0";
+
+	pugi::xml_node condition = doc.select_node("//Condition[@name='EgoLaneChangeCondition']").node();
+	condition.remove_child("ByEntity");
+	pugi::xml_node sim_time = condition.append_child("ByValue").append_child("SimulationTime");
+	sim_time.append_attribute("value") = "1.0";
+	sim_time.append_attribute("rule") = "greater_than";
+
+	// Watching sequence first in the act, so that the condition is evaluated before the lane change each step
+	char buf[2048];
+	snprintf(buf, sizeof(buf),
+		"<Sequence name='WatchSequence' numberOfExecutions='1'><Actors><Entity name='Ego'/></Actors>"
+		"<Maneuver name='WatchManeuver'><Event name='WatchEvent' priority='overwrite'>"
+		"<Action name='WatchAction'><Private><Longitudinal><Speed><Dynamics shape='step'/>"
+		"<Target><Absolute value='0'/></Target></Speed></Longitudinal></Private></Action>"
+		"<StartConditions><ConditionGroup><Condition name='WatchCondition' delay='0' edge='rising'>"
+		"<ByEntity><TriggeringEntities rule='any'><Entity name='Ego'/></TriggeringEntities>"
+		"<EntityCondition><ReachPosition tolerance='0.2'><Position><World x='%.6f' y='%.6f' z='0' h='0' p='0' r='0'/>"
+		"</Position></ReachPosition></EntityCondition></ByEntity></Condition></ConditionGroup></StartConditions>"
+		"</Event></Maneuver></Sequence>",
+		(from.GetX() + to.GetX()) / 2, (from.GetY() + to.GetY()) / 2);
+	pugi::xml_document watch;
+	watch.load_string(buf);
+	pugi::xml_node act = doc.select_node("//Act[@name='Act1']").node();
+	act.insert_copy_before(watch.first_child(), act.child("Sequence"));
+}
+
+// Entity conditions consider the whole motion since last step, so that a position passed in between steps 
+// is found also at coarse steps. At 1 s steps the Ego of highway_merge moves 25 m per step, while the lane 
+// change is trigged within 1 m of a position. Motion by actions counts as well, also when the condition
+// is evaluated before the action in the same step. A lane change of 2.8 s moves the Ego more than 1 m per 
+// step, past a point watched with 0.2 m tolerance.
+TEST(StoryboardTest, SweptConditionsCoarseStep)
+{
+	const char *filename = RESOURCES_DIR "/xosc/highway_merge.xosc";
+	const double fine_dt = 0.02;
+	const double coarse_dt = 1.0;
+	const double duration = 12.0;
+	const char *variant[] = { "ReachPosition", "Distance", "LaneChange" };
+
+	for (int i = 0; i < 3; i++)
+	{
+		pugi::xml_document doc;
+		const char *event_name = "EgoLaneChangeEvent";
+		int event_state = Event::State::ACTIVATED;
+
+		SCOPED_TRACE(variant[i]);
+
+		ASSERT_TRUE(doc.load_file(filename));
+		pugi::xml_node condition = doc.select_node("//ReachPosition").node();
+		ASSERT_TRUE(condition);
+		if (i == 1)
+		{
+			// Same position by a Distance condition
+			condition.set_name("Distance");
+			condition.remove_attribute("tolerance");
+			condition.append_attribute("value") = "1.0";
+			condition.append_attribute("freespace") = "false";
+			condition.append_attribute("alongRoute") = "false";
+			condition.append_attribute("rule") = "less_than";
+		}
+		else if (i == 2)
+		{
+			MakeLaneChangeWatch(doc, RESOURCES_DIR "/xodr/soderleden.xodr");
+			event_name = "WatchEvent";
+			event_state = Event::State::DEACTIVATED;  // the watch action is done at once, within the step of the trigger
+		}
+
+		ScenarioRun fine(filename, STEP_SCHEDULED, &doc);
+		ScenarioRun coarse(filename, STEP_SCHEDULED, &doc);
+
+		for (int j = 0; j < (int)(duration / fine_dt + 0.5); j++)
+		{
+			fine.Step(fine_dt);
+		}
+		for (int j = 0; j < (int)(duration / coarse_dt + 0.5); j++)
+		{
+			coarse.Step(coarse_dt);
+		}
+
+		double t_fine = TransitionTime(fine.trace_, "event", event_name, event_state);
+		double t_coarse = TransitionTime(coarse.trace_, "event", event_name, event_state);
+
+		ASSERT_GT(t_fine, 0);
+		ASSERT_GT(t_coarse, 0);
+
+		// A step evaluates the motion since before the previous storyboard step. Objects are moved after 
+		// the storyboard, so that is the motion [t - 2 dt, t - dt] plus actions of the previous step. The 
+		// coarse segment must contain the fine one.
+		EXPECT_LE(t_coarse - 2 * coarse_dt, t_fine - 2 * fine_dt);
+		EXPECT_GE(t_coarse - coarse_dt, t_fine - fine_dt);
+	}
+}
+
+// ltap-od_two_targets without routes and stories, all objects just driving. Hence they choose randomly 
+// at the junction.
+static void MakeRandomDriving(pugi::xml_document &doc)
+{
+	pugi::xml_node actions = doc.select_node("//Init/Actions").node();
+	const char *lane[][3] = { { "0", "1", "20" }, { "2", "-1", "280" }, { "3", "-1", "90" } };  // towards the junction
+	int n = 0;
+
+	for (pugi::xml_node priv = actions.child("Private"); priv; priv = priv.next_sibling("Private"), n++)
+	{
+		while (priv.first_child())
+		{
+			priv.remove_child(priv.first_child());
+		}
+		pugi::xml_node position = priv.append_child("Action").append_child("Position").append_child("Lane");
+		position.append_attribute("roadId") = lane[n % 3][0];
+		position.append_attribute("laneId") = lane[n % 3][1];
+		position.append_attribute("offset") = "0";
+		position.append_attribute("s") = lane[n % 3][2];
+		pugi::xml_node speed = priv.append_child("Action").append_child("Longitudinal").append_child("Speed");
+		speed.append_child("Dynamics").append_attribute("shape") = "step";
+		speed.append_child("Target").append_child("Absolute").append_attribute("value") = "8";
+	}
+
+	pugi::xml_node storyboard = doc.select_node("//Storyboard").node();
+	while (storyboard.child("Story"))
+	{
+		storyboard.remove_child(storyboard.child("Story"));
+	}
+}
+
+// Positions of all objects, per step, by running the scenario engine with given seed. Objects are
+// stepped in reverse order if requested.
+static std::vector<double> RunSeeded(pugi::xml_document &doc, const char *filename, unsigned int seed, bool reverse)
+{
+	ScenarioEngine engine(doc, filename, 0.0, ExternalControlMode::EXT_CONTROL_OFF);
+	std::vector<double> trace;
+
+	if (reverse)
+	{
+		std::reverse(engine.entities.object_.begin(), engine.entities.object_.end());
+	}
+	engine.SetRandomSeed(seed);
+	engine.step(0.0, true);
+
+	for (int i = 0; i < 2000; i++)
+	{
+		engine.step(0.02);
+		for (size_t j = 0; j < engine.entities.object_.size(); j++)
+		{
+			// Same order of objects in the trace, whatever order they are stepped in
+			Object *obj = engine.entities.object_[reverse ? engine.entities.object_.size() - 1 - j : j];
+			trace.insert(trace.end(), { (double)obj->pos_.GetTrackId(), obj->pos_.GetX(), obj->pos_.GetY(), obj->pos_.GetH() });
+		}
+	}
+
+	return trace;
+}
+
+// Runs with same seed are bit identical, independent of the order objects are stepped in
+TEST(StoryboardTest, SeededRunRepeats)
+{
+	const char *filename = RESOURCES_DIR "/xosc/ltap-od_two_targets.xosc";
+	pugi::xml_document doc;
+	std::set<std::vector<double> > variants;
+
+	ASSERT_TRUE(doc.load_file(filename));
+	MakeRandomDriving(doc);
+
+	for (unsigned int seed = 1; seed <= 5; seed++)
+	{
+		std::vector<double> trace = RunSeeded(doc, filename, seed, false);
+		std::vector<double> trace_repeated = RunSeeded(doc, filename, seed, false);
+		std::vector<double> trace_reversed = RunSeeded(doc, filename, seed, true);
+
+		ASSERT_EQ(trace, trace_repeated) << "seed " << seed;
+		ASSERT_EQ(trace, trace_reversed) << "seed " << seed;
+		variants.insert(trace);
+	}
+
+	// The objects actually make random choices
+	EXPECT_GT(variants.size(), 1u);
+}
+
+// Condition delays are measured in simulation time, so a delayed trigger fires at the same simulation time
+// whatever the step size, within a step. The act of cut-in_simple is started 1 s into the scenario with a
+// delay of 2 s.
+TEST(StoryboardTest, DelayIndependentOfStep)
+{
+	const char *filename = RESOURCES_DIR "/xosc/cut-in_simple.xosc";
+	const double start_time = 1.0;
+	const double delay = 2.0;
+
+	for (StepMode mode : { STEP_SCHEDULED, STEP_POLLED })
+	{
+		for (double dt : { 0.01, 0.02, 0.05, 0.1, 0.25 })
+		{
+			SCOPED_TRACE(std::string(mode == STEP_SCHEDULED ? "scheduled" : "polled") + " dt " + std::to_string(dt));
+
+			double t_act[2];
+			for (int i = 0; i < 2; i++)
+			{
+				pugi::xml_document doc;
+
+				ASSERT_TRUE(doc.load_file(filename));
+				pugi::xml_node condition = doc.select_node("//Condition[@name='CutInActStart']").node();
+				ASSERT_TRUE(condition);
+				condition.attribute("delay") = i == 0 ? "0" : std::to_string(delay).c_str();
+				condition.select_node(".//SimulationTime").node().attribute("value") = std::to_string(start_time).c_str();
+
+				ScenarioRun run(filename, mode, &doc);
+				for (int j = 0; j < (int)(5.0 / dt + 0.5); j++)
+				{
+					run.Step(dt);
+				}
+				t_act[i] = TransitionTime(run.trace_, "act", "CutInAndBrakeAct", Act::State::ACTIVATED);
+			}
+
+			// Trace times have two decimals
+			ASSERT_GT(t_act[0], 0);
+			EXPECT_GE(t_act[0], start_time - 0.005);
+			EXPECT_LE(t_act[0], start_time + dt + 0.005);
+			EXPECT_GE(t_act[1], start_time + delay - 0.005);
+			EXPECT_LE(t_act[1], start_time + delay + 2 * dt + 0.005);
+			EXPECT_GE(t_act[1] - t_act[0], delay - 0.01);
+			EXPECT_LE(t_act[1] - t_act[0], delay + dt + 0.01);
+		}
+	}
+}
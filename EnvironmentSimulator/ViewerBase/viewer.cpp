@@ -439,7 +439,8 @@ bool Viewer::CreateRoadLines(roadmanager::OpenDrive* od, osg::Group* parent)
 {
 	double step_length_target = 1;
 	double z_offset = 0.10;
-	roadmanager::Position* pos = new roadmanager::Position();
+	roadmanager::Position* pos = new roadmanager::Position(od);
+	roadmanager::RoadCursor cursor;
 	osg::Vec3 point(0, 0, 0);
 	odrLines_ = new osg::Group;
 
@@ -511,10 +512,13 @@ bool Viewer::CreateRoadLines(roadmanager::OpenDrive* od, osg::Group* parent)
 					continue;
 				}
 
+				cursor.Set(road, s_start);
 				for (int k = 0; k < steps + 1; k++)
 				{
-					pos->SetLanePos(road->GetId(), lane->GetId(), MIN(s_end, s_start + k * step_length), 0, i);
-					point.set(pos->GetX(), pos->GetY(), pos->GetZ() + z_offset);
+					double x, y, h;
+					cursor.MoveTo(MIN(s_end, s_start + k * step_length));
+					cursor.GetLanePos(lane->GetId(), 0, &x, &y, &h);
+					point.set(x, y, cursor.GetZ() + z_offset);
 					points->push_back(point);
 				}
 